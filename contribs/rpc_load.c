@@ -0,0 +1,363 @@
+/*****************************************************************************\
+ *  rpc_load.c - Drive a mix of job submit, query and cancel RPCs against
+ *	slurmctld from a number of threads and report their throughput and
+ *	latency. Compare with the latency histograms of "sdiag" to see where
+ *	slurmctld spends the time.
+ *
+ *  Build with:
+ *	gcc -o rpc_load rpc_load.c -I<prefix>/include -L<prefix>/lib \
+ *		-lslurm -lpthread
+ *
+ *  Example: rpc_load -t 16 -d 30 -m submit=1,query=8,nodes=2,cancel=1
+ *
+ *  Jobs are submitted held, to a partition given with -p if any, and are
+ *  cancelled by the cancel RPCs or once the run is over.
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+
+enum {
+	OP_SUBMIT,
+	OP_QUERY,
+	OP_NODES,
+	OP_CANCEL,
+	OP_PING,
+	OP_CNT
+};
+
+static const char *op_name[OP_CNT] = {
+	"submit", "query", "nodes", "cancel", "ping"
+};
+
+typedef struct {
+	uint32_t *usec;		/* latency of each RPC */
+	int cnt;
+	int size;
+	int errors;
+} op_stats_t;
+
+typedef struct {
+	pthread_t thread;
+	unsigned int seed;
+	op_stats_t stats[OP_CNT];
+} worker_t;
+
+static int weight[OP_CNT] = { 1, 8, 0, 1, 0 };
+static int weight_sum = 0;
+static int duration = 10;
+static char *partition = NULL;
+static struct timeval end_time;
+
+/* Held jobs available to the cancel RPCs */
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *job_ids = NULL;
+static int job_cnt = 0, job_size = 0;
+
+static void _usage(void)
+{
+	fprintf(stderr,
+"Usage: rpc_load [-t threads] [-d seconds] [-p partition] [-m mix]\n"
+"  mix is a comma separated list of <rpc>=<weight> with rpc one of\n"
+"  submit, query (job information), nodes (node information), cancel or\n"
+"  ping. Default: -t 8 -d 10 -m submit=1,query=8,cancel=1\n");
+	exit(1);
+}
+
+static void _parse_mix(char *mix)
+{
+	char *tmp = strdup(mix), *tok, *save_ptr = NULL, *eq;
+	int i;
+
+	memset(weight, 0, sizeof(weight));
+	for (tok = strtok_r(tmp, ",", &save_ptr); tok;
+	     tok = strtok_r(NULL, ",", &save_ptr)) {
+		if (!(eq = strchr(tok, '=')))
+			_usage();
+		*eq = '\0';
+		for (i = 0; i < OP_CNT; i++) {
+			if (!strcmp(tok, op_name[i]))
+				break;
+		}
+		if (i >= OP_CNT)
+			_usage();
+		weight[i] = atoi(eq + 1);
+		if (weight[i] < 0)
+			_usage();
+	}
+	free(tmp);
+}
+
+static long _usec_diff(struct timeval *start, struct timeval *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000 +
+	       (end->tv_usec - start->tv_usec);
+}
+
+static void _job_push(uint32_t job_id)
+{
+	pthread_mutex_lock(&job_mutex);
+	if (job_cnt >= job_size) {
+		job_size = job_size ? (job_size * 2) : 1024;
+		job_ids = realloc(job_ids, sizeof(uint32_t) * job_size);
+		if (!job_ids) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	job_ids[job_cnt++] = job_id;
+	pthread_mutex_unlock(&job_mutex);
+}
+
+static uint32_t _job_pop(void)
+{
+	uint32_t job_id = 0;
+
+	pthread_mutex_lock(&job_mutex);
+	if (job_cnt)
+		job_id = job_ids[--job_cnt];
+	pthread_mutex_unlock(&job_mutex);
+	return job_id;
+}
+
+static int _submit(void)
+{
+	job_desc_msg_t job_desc;
+	submit_response_msg_t *resp = NULL;
+	char *env[] = { "RPC_LOAD=1" };
+	int rc;
+
+	slurm_init_job_desc_msg(&job_desc);
+	job_desc.name = "rpc_load";
+	job_desc.script = "#!/bin/sh\ntrue\n";
+	job_desc.environment = env;
+	job_desc.env_size = 1;
+	job_desc.work_dir = "/tmp";
+	job_desc.std_out = "/dev/null";
+	job_desc.partition = partition;
+	job_desc.min_nodes = 1;
+	job_desc.time_limit = 1;
+	job_desc.priority = 0;		/* held */
+	job_desc.user_id = getuid();
+	job_desc.group_id = getgid();
+
+	rc = slurm_submit_batch_job(&job_desc, &resp);
+	if (rc == SLURM_SUCCESS) {
+		_job_push(resp->job_id);
+		slurm_free_submit_response_response_msg(resp);
+	}
+	return rc;
+}
+
+/* Run one RPC, RET the operation actually performed or -1 on error */
+static int _run_op(int op)
+{
+	job_info_msg_t *job_info = NULL;
+	node_info_msg_t *node_info = NULL;
+	uint32_t job_id;
+
+	switch (op) {
+	case OP_SUBMIT:
+		return _submit() ? -1 : op;
+	case OP_QUERY:
+		if (slurm_load_jobs((time_t) 0, &job_info, SHOW_ALL))
+			return -1;
+		slurm_free_job_info_msg(job_info);
+		return op;
+	case OP_NODES:
+		if (slurm_load_node((time_t) 0, &node_info, SHOW_ALL))
+			return -1;
+		slurm_free_node_info_msg(node_info);
+		return op;
+	case OP_CANCEL:
+		/* Nothing to cancel yet, submit a job instead */
+		if (!(job_id = _job_pop()))
+			return _submit() ? -1 : OP_SUBMIT;
+		return slurm_kill_job(job_id, SIGKILL, 0) ? -1 : op;
+	case OP_PING:
+		return slurm_ping(1) ? -1 : op;
+	}
+	return -1;
+}
+
+static void *_worker(void *arg)
+{
+	worker_t *worker = arg;
+	struct timeval start, end;
+	op_stats_t *stats;
+	int op, done, pick;
+
+	while (1) {
+		gettimeofday(&start, NULL);
+		if (_usec_diff(&start, &end_time) <= 0)
+			break;
+		pick = rand_r(&worker->seed) % weight_sum;
+		for (op = 0; pick >= weight[op]; op++)
+			pick -= weight[op];
+		done = _run_op(op);
+		gettimeofday(&end, NULL);
+
+		if (done < 0) {
+			worker->stats[op].errors++;
+			continue;
+		}
+		stats = &worker->stats[done];
+		if (stats->cnt >= stats->size) {
+			stats->size = stats->size ? (stats->size * 2) : 1024;
+			stats->usec = realloc(stats->usec,
+					      sizeof(uint32_t) * stats->size);
+			if (!stats->usec) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		stats->usec[stats->cnt++] = _usec_diff(&start, &end);
+	}
+	return NULL;
+}
+
+static int _cmp_usec(const void *x, const void *y)
+{
+	uint32_t a = *(const uint32_t *) x, b = *(const uint32_t *) y;
+
+	return (a > b) - (a < b);
+}
+
+static void _report(worker_t *workers, int threads, double elapsed)
+{
+	op_stats_t all;
+	int op, i, total = 0;
+
+	printf("%-8s %8s %8s %10s %10s %10s %10s\n", "RPC", "Count",
+	       "Errors", "Per_sec", "P50_usec", "P99_usec", "Max_usec");
+	for (op = 0; op < OP_CNT; op++) {
+		memset(&all, 0, sizeof(all));
+		for (i = 0; i < threads; i++) {
+			all.cnt += workers[i].stats[op].cnt;
+			all.errors += workers[i].stats[op].errors;
+		}
+		if (!all.cnt && !all.errors)
+			continue;
+		all.usec = malloc(sizeof(uint32_t) * (all.cnt + 1));
+		for (i = 0; i < threads; i++) {
+			memcpy(all.usec + all.size, workers[i].stats[op].usec,
+			       sizeof(uint32_t) * workers[i].stats[op].cnt);
+			all.size += workers[i].stats[op].cnt;
+		}
+		qsort(all.usec, all.cnt, sizeof(uint32_t), _cmp_usec);
+		printf("%-8s %8d %8d %10.1f %10u %10u %10u\n", op_name[op],
+		       all.cnt, all.errors, all.cnt / elapsed,
+		       all.cnt ? all.usec[(all.cnt - 1) / 2] : 0,
+		       all.cnt ? all.usec[((all.cnt - 1) * 99) / 100] : 0,
+		       all.cnt ? all.usec[all.cnt - 1] : 0);
+		total += all.cnt;
+		free(all.usec);
+	}
+	printf("%-8s %8d %8s %10.1f\n", "total", total, "", total / elapsed);
+}
+
+int main(int argc, char **argv)
+{
+	struct timeval start, end;
+	worker_t *workers;
+	uint32_t job_id;
+	int c, i, threads = 8;
+
+	while ((c = getopt(argc, argv, "d:hm:p:t:")) != -1) {
+		switch (c) {
+		case 'd':
+			duration = atoi(optarg);
+			break;
+		case 'm':
+			_parse_mix(optarg);
+			break;
+		case 'p':
+			partition = optarg;
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
+		default:
+			_usage();
+		}
+	}
+	for (i = 0; i < OP_CNT; i++)
+		weight_sum += weight[i];
+	if ((threads < 1) || (duration < 1) || (weight_sum < 1))
+		_usage();
+
+	/* Every query must reach slurmctld */
+	unsetenv("SLURM_INFO_CACHE");
+
+	workers = calloc(threads, sizeof(worker_t));
+	gettimeofday(&start, NULL);
+	end_time = start;
+	end_time.tv_sec += duration;
+	for (i = 0; i < threads; i++) {
+		workers[i].seed = start.tv_usec + i;
+		if (pthread_create(&workers[i].thread, NULL, _worker,
+				   &workers[i])) {
+			perror("pthread_create");
+			exit(1);
+		}
+	}
+	for (i = 0; i < threads; i++)
+		pthread_join(workers[i].thread, NULL);
+	gettimeofday(&end, NULL);
+
+	_report(workers, threads, _usec_diff(&start, &end) / 1000000.0);
+
+	/* Remove the jobs that are still held */
+	while ((job_id = _job_pop()))
+		(void) slurm_kill_job(job_id, SIGKILL, 0);
+
+	for (i = 0; i < threads; i++) {
+		for (c = 0; c < OP_CNT; c++)
+			free(workers[i].stats[c].usec);
+	}
+	free(workers);
+	free(job_ids);
+	return 0;
+}
@@ -785,6 +785,8 @@ typedef struct {
 } slurmdb_job_rec_t;
 
 typedef struct {
+	void *acct_limit_index; /* hash index of acct_limit_list by
+				 * account (DON'T PACK) */
 	List acct_limit_list; /* slurmdb_used_limits_t's (DON'T PACK
 			       * for state file) */
 	List job_list; /* list of job pointers to submitted/running
@@ -808,6 +810,8 @@ typedef struct {
 
 	long double *usage_tres_raw; /* measure of each TRES usage (DON'T
 				      * PACK for state file)*/
+	void *user_limit_index; /* hash index of user_limit_list by
+				 * uid (DON'T PACK) */
 	List user_limit_list; /* slurmdb_used_limits_t's (DON'T PACK
 			       * for state file) */
 } slurmdb_qos_usage_t;
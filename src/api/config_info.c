@@ -1847,6 +1847,31 @@ slurm_load_slurmd_status(slurmd_status_t **slurmd_status_ptr)
 	return SLURM_PROTOCOL_SUCCESS;
 }
 
+/*
+ * Print a step launch latency histogram of slurmd_status_t, one
+ * "<limit>:<count>" pair per non-empty bucket
+ */
+static void _print_launch_hist(FILE *out, char *title, uint32_t *hist,
+			       uint32_t hist_cnt)
+{
+	uint32_t i;
+	bool found = false;
+
+	fprintf(out, "%s", title);
+	for (i = 0; i < hist_cnt; i++) {
+		if (!hist[i])
+			continue;
+		if (i < (hist_cnt - 1))
+			fprintf(out, "%s<%ums:%u", found ? " " : "", 1 << i,
+				hist[i]);
+		else
+			fprintf(out, "%s>=%ums:%u", found ? " " : "",
+				1 << (i - 1), hist[i]);
+		found = true;
+	}
+	fprintf(out, "%s\n", found ? "" : "NONE");
+}
+
 /*
  * slurm_print_slurmd_status - output the contents of slurmd status
  *	message as loaded using slurm_load_slurmd_status
@@ -1900,6 +1925,15 @@ void slurm_print_slurmd_status (FILE* out,
 		slurmd_status_ptr->slurmd_debug);
 	fprintf(out, "Slurmd Logfile           = %s\n",
 		slurmd_status_ptr->slurmd_logfile);
+	fprintf(out, "Stepd Pool               = %u of %u idle\n",
+		slurmd_status_ptr->stepd_pool_idle,
+		slurmd_status_ptr->stepd_pool_size);
+	_print_launch_hist(out, "Step Launch Pooled       = ",
+			   slurmd_status_ptr->launch_hist_pooled,
+			   slurmd_status_ptr->launch_hist_cnt);
+	_print_launch_hist(out, "Step Launch Forked       = ",
+			   slurmd_status_ptr->launch_hist_forked,
+			   slurmd_status_ptr->launch_hist_cnt);
 	fprintf(out, "Version                  = %s\n",
 		slurmd_status_ptr->version);
 	return;
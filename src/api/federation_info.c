@@ -38,6 +38,7 @@
 #include "slurm/slurmdb.h"
 #include "slurm/slurm_errno.h"
 
+#include "src/api/info_cache.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/xstring.h"
 #include "src/common/xmalloc.h"
@@ -61,6 +62,12 @@ extern int slurm_load_federation(void **fed_pptr)
 	req_msg.msg_type = REQUEST_FED_INFO;
 	req_msg.data     = NULL;
 
+	if (info_cache_enabled()) {
+		if (info_cache_load(&req_msg, 0, NULL, fed_pptr))
+			return SLURM_ERROR;
+		return SLURM_PROTOCOL_SUCCESS;
+	}
+
 	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg,
 					   working_cluster_rec) < 0)
 		return SLURM_ERROR;
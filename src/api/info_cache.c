@@ -0,0 +1,377 @@
+/*****************************************************************************\
+ *  info_cache.c - per user cache of job, node and partition information
+ *	shared by the client commands running on a host
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/api/info_cache.h"
+#include "src/common/macros.h"
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define INFO_CACHE_DIR		"/dev/shm"
+#define INFO_CACHE_MAGIC	0x1ca9e5e7
+
+/*
+ * A cache file holds this header followed by the body of the controller's
+ * response, exactly as it was received. Cache files are replaced with
+ * rename(), so a file which is mapped never changes.
+ */
+typedef struct {
+	uint32_t magic;
+	uint16_t protocol_version;	/* of the packed response */
+	uint16_t msg_type;		/* of the packed response */
+	time_t last_update;		/* last_update of the response */
+	time_t fetch_time;		/* controller last asked for changes */
+	uint32_t body_size;		/* bytes of packed response */
+} info_cache_hdr_t;
+
+static int cache_time = -1;		/* SLURM_INFO_CACHE, in seconds */
+
+extern bool info_cache_enabled(void)
+{
+	char *val;
+
+	if (cache_time < 0) {
+		if ((val = getenv("SLURM_INFO_CACHE")))
+			cache_time = MAX(atoi(val), 0);
+		else
+			cache_time = 0;
+	}
+
+	return (cache_time > 0) && !working_cluster_rec;
+}
+
+static uint16_t _resp_type(uint16_t req_type)
+{
+	switch (req_type) {
+	case REQUEST_JOB_INFO:
+		return RESPONSE_JOB_INFO;
+	case REQUEST_NODE_INFO:
+		return RESPONSE_NODE_INFO;
+	case REQUEST_PARTITION_INFO:
+		return RESPONSE_PARTITION_INFO;
+	case REQUEST_FED_INFO:
+		return RESPONSE_FED_INFO;
+	}
+
+	return 0;
+}
+
+static time_t _data_last_update(uint16_t resp_type, void *data)
+{
+	if (!data)
+		return 0;
+
+	switch (resp_type) {
+	case RESPONSE_JOB_INFO:
+		return ((job_info_msg_t *) data)->last_update;
+	case RESPONSE_NODE_INFO:
+		return ((node_info_msg_t *) data)->last_update;
+	case RESPONSE_PARTITION_INFO:
+		return ((partition_info_msg_t *) data)->last_update;
+	}
+
+	return 0;
+}
+
+/*
+ * Responses depend on the user's identity (hidden partitions, PrivateData)
+ * and on the show_flags, so each user has a cache file per request type and
+ * show_flags.
+ */
+static char *_cache_path(uint16_t msg_type, uint16_t show_flags)
+{
+	char *cluster_name = slurm_get_cluster_name();
+	char *path;
+
+	path = xstrdup_printf("%s/slurm_info.%s.%u.%u.%x", INFO_CACHE_DIR,
+			      cluster_name, (uint32_t) getuid(), msg_type,
+			      show_flags);
+	xfree(cluster_name);
+
+	return path;
+}
+
+/*
+ * Open a cache or lock file. /dev/shm is writable by everyone, so only use
+ * regular files owned by this user.
+ */
+static int _open_own(char *path, int flags, struct stat *st)
+{
+	struct stat tmp_st;
+	int fd;
+
+	if (!st)
+		st = &tmp_st;
+	if ((fd = open(path, flags | O_NOFOLLOW | O_CLOEXEC, 0600)) < 0)
+		return -1;
+	if (fstat(fd, st) || !S_ISREG(st->st_mode) ||
+	    (st->st_uid != getuid())) {
+		close(fd);
+		errno = EPERM;
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Map a cache file, RET NULL if it is missing or not valid */
+static info_cache_hdr_t *_map_cache(char *path, uint16_t resp_type,
+				    size_t *size)
+{
+	info_cache_hdr_t *hdr;
+	struct stat st;
+	int fd;
+
+	if ((fd = _open_own(path, O_RDONLY, &st)) < 0)
+		return NULL;
+	if (st.st_size < sizeof(info_cache_hdr_t)) {
+		close(fd);
+		return NULL;
+	}
+	hdr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hdr == MAP_FAILED)
+		return NULL;
+
+	if ((hdr->magic != INFO_CACHE_MAGIC) || (hdr->msg_type != resp_type) ||
+	    (hdr->protocol_version < SLURM_MIN_PROTOCOL_VERSION) ||
+	    (hdr->protocol_version > SLURM_PROTOCOL_VERSION) ||
+	    (sizeof(info_cache_hdr_t) + hdr->body_size != st.st_size)) {
+		munmap(hdr, st.st_size);
+		return NULL;
+	}
+	*size = st.st_size;
+
+	return hdr;
+}
+
+static bool _fresh(info_cache_hdr_t *hdr)
+{
+	time_t now = time(NULL);
+
+	return (hdr->fetch_time <= now) &&
+	       (difftime(now, hdr->fetch_time) < cache_time);
+}
+
+/* Write a new cache file and move it into place */
+static void _write_cache(char *path, info_cache_hdr_t *hdr, char *body)
+{
+	char *tmp_path = xstrdup_printf("%s.XXXXXX", path);
+	int fd;
+
+	if ((fd = mkstemp(tmp_path)) < 0) {
+		debug("%s: mkstemp(%s): %m", __func__, tmp_path);
+		xfree(tmp_path);
+		return;
+	}
+	safe_write(fd, hdr, sizeof(info_cache_hdr_t));
+	safe_write(fd, body, hdr->body_size);
+	close(fd);
+
+	if (rename(tmp_path, path) < 0) {
+		debug("%s: rename(%s): %m", __func__, path);
+		(void) unlink(tmp_path);
+	}
+	xfree(tmp_path);
+	return;
+
+rwfail:
+	close(fd);
+	(void) unlink(tmp_path);
+	xfree(tmp_path);
+}
+
+/*
+ * Unpack the cached response, or return SLURM_NO_CHANGE_IN_DATA if it is not
+ * newer than the caller's copy, as the controller would.
+ */
+static int _load_cached(info_cache_hdr_t *hdr, time_t *last_update,
+			void **data)
+{
+	slurm_msg_t msg;
+	Buf buffer;
+	int rc;
+
+	if (last_update && *last_update &&
+	    (*last_update >= hdr->last_update)) {
+		slurm_seterrno(SLURM_NO_CHANGE_IN_DATA);
+		return SLURM_NO_CHANGE_IN_DATA;
+	}
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = hdr->msg_type;
+	msg.protocol_version = hdr->protocol_version;
+
+	/* Unpack straight from the mapping, which the buffer must not free */
+	if (!(buffer = create_buf((char *) (hdr + 1), hdr->body_size))) {
+		slurm_seterrno(ESLURM_PROTOCOL_INCOMPLETE_PACKET);
+		return SLURM_ERROR;
+	}
+	rc = unpack_msg(&msg, buffer);
+	buffer->head = NULL;
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS) {
+		slurm_seterrno(ESLURM_PROTOCOL_INCOMPLETE_PACKET);
+		return SLURM_ERROR;
+	}
+	*data = msg.data;
+
+	return SLURM_SUCCESS;
+}
+
+/* Ask the controller for changes since the cached copy (if any), then
+ * rewrite the cache file */
+static int _refresh_cache(slurm_msg_t *req_msg, char *path,
+			  info_cache_hdr_t *old_hdr, time_t *last_update,
+			  void **data)
+{
+	uint16_t resp_type = _resp_type(req_msg->msg_type);
+	info_cache_hdr_t hdr;
+	slurm_msg_t resp_msg;
+	time_t req_update = 0;
+	Buf buffer;
+	int rc;
+
+	if (last_update) {
+		req_update = *last_update;
+		*last_update = old_hdr ? old_hdr->last_update : 0;
+	}
+
+	slurm_msg_t_init(&resp_msg);
+	req_msg->flags |= SLURM_MSG_KEEP_BUFFER;
+	rc = slurm_send_recv_controller_msg(req_msg, &resp_msg, NULL);
+	req_msg->flags &= (~SLURM_MSG_KEEP_BUFFER);
+	if (last_update)
+		*last_update = req_update;
+	if (rc < 0) {
+		free_buf(resp_msg.buffer);
+		return SLURM_ERROR;
+	}
+
+	if (resp_msg.msg_type == RESPONSE_SLURM_RC) {
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if ((rc == SLURM_NO_CHANGE_IN_DATA) && old_hdr) {
+			/* The cached copy is current, keep it longer */
+			hdr = *old_hdr;
+			hdr.fetch_time = time(NULL);
+			_write_cache(path, &hdr, (char *) (old_hdr + 1));
+			rc = _load_cached(old_hdr, last_update, data);
+		} else if (rc) {
+			slurm_seterrno(rc);
+		}
+	} else if (resp_msg.msg_type == resp_type) {
+		buffer = resp_msg.buffer;
+		memset(&hdr, 0, sizeof(info_cache_hdr_t));
+		hdr.magic = INFO_CACHE_MAGIC;
+		hdr.protocol_version = resp_msg.protocol_version;
+		hdr.msg_type = resp_msg.msg_type;
+		hdr.last_update = _data_last_update(resp_type, resp_msg.data);
+		hdr.fetch_time = time(NULL);
+		hdr.body_size = size_buf(buffer) - resp_msg.body_offset;
+		_write_cache(path, &hdr,
+			     get_buf_data(buffer) + resp_msg.body_offset);
+		*data = resp_msg.data;
+		rc = SLURM_SUCCESS;
+	} else {
+		slurm_free_msg_data(resp_msg.msg_type, resp_msg.data);
+		rc = SLURM_UNEXPECTED_MSG_ERROR;
+		slurm_seterrno(rc);
+	}
+	free_buf(resp_msg.buffer);
+
+	return rc;
+}
+
+extern int info_cache_load(slurm_msg_t *req_msg, uint16_t show_flags,
+			   time_t *last_update, void **data)
+{
+	uint16_t resp_type = _resp_type(req_msg->msg_type);
+	info_cache_hdr_t *hdr;
+	char *path, *lock_path;
+	size_t size = 0;
+	int lock_fd, rc;
+
+	xassert(resp_type);
+	*data = NULL;
+	path = _cache_path(req_msg->msg_type, show_flags);
+
+	/* Most calls only read a fresh cache file and need no lock */
+	if ((hdr = _map_cache(path, resp_type, &size)) && _fresh(hdr)) {
+		rc = _load_cached(hdr, last_update, data);
+		goto fini;
+	}
+	if (hdr) {
+		munmap(hdr, size);
+		hdr = NULL;
+	}
+
+	/* Let a single process refresh the cache file */
+	lock_path = xstrdup_printf("%s.lock", path);
+	if ((lock_fd = _open_own(lock_path, O_RDWR | O_CREAT, NULL)) >= 0) {
+		while ((flock(lock_fd, LOCK_EX) < 0) && (errno == EINTR))
+			;
+	}
+	xfree(lock_path);
+
+	if ((hdr = _map_cache(path, resp_type, &size)) && _fresh(hdr))
+		rc = _load_cached(hdr, last_update, data);
+	else
+		rc = _refresh_cache(req_msg, path, hdr, last_update, data);
+
+	if (lock_fd >= 0)
+		close(lock_fd);
+fini:
+	if (hdr)
+		munmap(hdr, size);
+	xfree(path);
+
+	return rc;
+}
@@ -0,0 +1,72 @@
+/*****************************************************************************\
+ *  info_cache.h - per user cache of job, node and partition information
+ *	shared by the client commands running on a host
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _INFO_CACHE_H
+#define _INFO_CACHE_H
+
+#include <time.h>
+
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * info_cache_enabled - report if the information cache may be used for a
+ *	request, which is the case when SLURM_INFO_CACHE is set to the number
+ *	of seconds cached information remains valid and the request is for
+ *	the local cluster.
+ */
+extern bool info_cache_enabled(void);
+
+/*
+ * info_cache_load - get the response to a REQUEST_JOB_INFO,
+ *	REQUEST_NODE_INFO, REQUEST_PARTITION_INFO or REQUEST_FED_INFO message,
+ *	from the cache file in /dev/shm if it was refreshed within the last
+ *	SLURM_INFO_CACHE seconds, from the controller otherwise. Only one
+ *	process at a time refreshes a cache file, the others wait and then
+ *	read the new copy.
+ * IN req_msg - request to send to the controller
+ * IN show_flags - show_flags of the request, part of the cache key
+ * IN/OUT last_update - last_update of the request or NULL. Overwritten
+ *	while the cache is refreshed and restored afterwards.
+ * OUT data - the unpacked response, NULL when the controller returned
+ *	SLURM_SUCCESS instead
+ * RET SLURM_SUCCESS, SLURM_ERROR on communication errors or the error code
+ *	returned by the controller, such as SLURM_NO_CHANGE_IN_DATA. errno is
+ *	set on failure.
+ */
+extern int info_cache_load(slurm_msg_t *req_msg, uint16_t show_flags,
+			   time_t *last_update, void **data);
+
+#endif
@@ -54,6 +54,7 @@
 #include "slurm/slurmdb.h"
 #include "slurm/slurm_errno.h"
 
+#include "src/api/info_cache.h"
 #include "src/common/cpu_frequency.h"
 #include "src/common/forward.h"
 #include "src/common/macros.h"
@@ -1339,7 +1340,7 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 
 	slurm_msg_t_init(&req_msg);
 	req.last_update  = update_time;
-	req.show_flags   = show_flags;
+	req.show_flags   = show_flags | SHOW_REC_INDEX;
 	req_msg.msg_type = REQUEST_JOB_INFO;
 	req_msg.data     = &req;
 
@@ -1347,6 +1348,11 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 		fed = (slurmdb_federation_rec_t *) ptr;
 		rc = _load_fed_jobs(&req_msg, job_info_msg_pptr, show_flags,
 				    cluster_name, fed);
+	} else if (info_cache_enabled()) {
+		rc = info_cache_load(&req_msg, show_flags, &req.last_update,
+				     (void **) job_info_msg_pptr);
+		if (rc)
+			rc = SLURM_ERROR;
 	} else {
 		rc = _load_cluster_jobs(&req_msg, job_info_msg_pptr,
 					working_cluster_rec);
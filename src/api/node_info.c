@@ -49,6 +49,7 @@
 
 #include "slurm/slurm.h"
 
+#include "src/api/info_cache.h"
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_acct_gather_energy.h"
@@ -733,7 +734,7 @@ extern int slurm_load_node(time_t update_time, node_info_msg_t **resp,
 
 	slurm_msg_t_init(&req_msg);
 	req.last_update  = update_time;
-	req.show_flags   = show_flags;
+	req.show_flags   = show_flags | SHOW_REC_INDEX;
 	req_msg.msg_type = REQUEST_NODE_INFO;
 	req_msg.data     = &req;
 
@@ -741,6 +742,13 @@ extern int slurm_load_node(time_t update_time, node_info_msg_t **resp,
 		fed = (slurmdb_federation_rec_t *) ptr;
 		rc = _load_fed_nodes(&req_msg, resp, show_flags, cluster_name,
 				     fed);
+	} else if (info_cache_enabled()) {
+		rc = info_cache_load(&req_msg, show_flags, &req.last_update,
+				     (void **) resp);
+		if (rc)
+			rc = SLURM_ERROR;
+		else if (*resp && (show_flags & SHOW_MIXED))
+			_set_node_mixed(*resp);
 	} else {
 		rc = _load_cluster_nodes(&req_msg, resp, working_cluster_rec,
 					 show_flags);
@@ -45,6 +45,7 @@
 #include "slurm/slurm.h"
 #include "slurm/slurmdb.h"
 
+#include "src/api/info_cache.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_selecttype_info.h"
@@ -608,6 +609,11 @@ extern int slurm_load_partitions(time_t update_time,
 		fed = (slurmdb_federation_rec_t *) ptr;
 		rc = _load_fed_parts(&req_msg, resp, show_flags, cluster_name,
 				     fed);
+	} else if (info_cache_enabled()) {
+		rc = info_cache_load(&req_msg, show_flags, &req.last_update,
+				     (void **) resp);
+		if (rc)
+			rc = SLURM_ERROR;
 	} else {
 		rc = _load_cluster_parts(&req_msg, resp, working_cluster_rec);
 	}
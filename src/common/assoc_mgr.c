@@ -44,6 +44,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 
+#include "src/common/lock_stats.h"
 #include "src/common/uid.h"
 #include "src/common/xstring.h"
 #include "src/common/slurm_priority.h"
@@ -2061,8 +2062,15 @@ extern int assoc_mgr_fini(char *state_save_location)
 	return SLURM_SUCCESS;
 }
 
-extern void assoc_mgr_lock(assoc_mgr_lock_t *locks)
+extern void assoc_mgr_lock_at(assoc_mgr_lock_t *locks, const char *file,
+			      int line, const char *func)
 {
+	bool stats = lock_stats_enabled;
+	struct timeval start;
+
+	if (stats)
+		gettimeofday(&start, NULL);
+
 	if (locks->assoc == READ_LOCK)
 		_wr_rdlock(ASSOC_LOCK);
 	else if (locks->assoc == WRITE_LOCK)
@@ -2097,6 +2105,12 @@ extern void assoc_mgr_lock(assoc_mgr_lock_t *locks)
 		_wr_rdlock(WCKEY_LOCK);
 	else if (locks->wckey == WRITE_LOCK)
 		_wr_wrlock(WCKEY_LOCK);
+
+	if (stats) {
+		lock_stats_acquired(LOCK_STATS_ASSOC_MGR,
+				    (lock_level_t *) locks, file, line, func,
+				    &start);
+	}
 }
 
 extern void assoc_mgr_unlock(assoc_mgr_lock_t *locks)
@@ -2135,6 +2149,8 @@ extern void assoc_mgr_unlock(assoc_mgr_lock_t *locks)
 		_wr_rdunlock(ASSOC_LOCK);
 	else if (locks->assoc == WRITE_LOCK)
 		_wr_wrunlock(ASSOC_LOCK);
+
+	lock_stats_released(LOCK_STATS_ASSOC_MGR);
 }
 
 /* Since the returned assoc_list is full of pointers from the
@@ -130,7 +130,11 @@ extern uint32_t g_tres_count; /* Number of TRES from the database
 extern int assoc_mgr_init(void *db_conn, assoc_init_args_t *args,
 			  int db_conn_errno);
 extern int assoc_mgr_fini(char *state_save_location);
-extern void assoc_mgr_lock(assoc_mgr_lock_t *locks);
+/* The call site is recorded for SchedulerParameters=lock_stats */
+#define assoc_mgr_lock(locks) \
+	assoc_mgr_lock_at(locks, __FILE__, __LINE__, __func__)
+extern void assoc_mgr_lock_at(assoc_mgr_lock_t *locks, const char *file,
+			      int line, const char *func);
 extern void assoc_mgr_unlock(assoc_mgr_lock_t *locks);
 
 /*
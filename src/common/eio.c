@@ -40,10 +40,16 @@
 
 #include <errno.h>
 #include <poll.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#ifdef HAVE_SYS_EPOLL_H
+#  include <sys/epoll.h>
+#endif
+
 #include "src/common/fd.h"
 #include "src/common/eio.h"
 #include "src/common/log.h"
@@ -89,6 +95,43 @@ struct eio_handle_components {
 };
 
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * epoll registration state of one file descriptor. Registrations persist
+ * across loop iterations and are only changed when the events wanted by
+ * the object change. EPOLLONESHOT is used so a registration left behind
+ * by an fd that was closed (while a duplicate of it is still open
+ * elsewhere) and reused fires at most once; such events are recognized
+ * by their stale sequence number and ignored.
+ */
+typedef struct {
+	bool armed;		/* registration armed, no event since	*/
+	uint32_t events;	/* registered events, 0 if none		*/
+	uint32_t gen;		/* loop iteration fd was last wanted in	*/
+	eio_obj_t *obj;		/* object polled on this fd		*/
+	uint32_t obj_id;	/* id of obj, a freed obj's address may
+				 * be reused by a new one		*/
+	uint32_t seq;		/* sequence number of the registration	*/
+} eio_epoll_fd_t;
+
+typedef struct {
+	int epfd;
+	struct epoll_event *events;
+	eio_epoll_fd_t *fds;
+	int fds_size;
+	uint32_t gen;
+	int nfds;		/* objects polled this iteration	*/
+	int nregs;		/* fds registered this iteration	*/
+	int registered;		/* fds registered in total		*/
+	uint32_t seq;
+} eio_epoll_t;
+
+#define EIO_EPOLL_WAKEUP ((uint64_t) -1)
+#endif
+
+static uint32_t obj_id = 0;	/* last id given to an eio_obj_t */
+static pthread_mutex_t obj_id_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* Function prototypes
  */
 
@@ -280,7 +323,7 @@ static int _eio_wakeup_handler(eio_handle_t *eio)
 	return 0;
 }
 
-int eio_handle_mainloop(eio_handle_t *eio)
+static int _poll_mainloop(eio_handle_t *eio)
 {
 	int            retval  = 0;
 	struct pollfd *pollfds = NULL;
@@ -512,6 +555,262 @@ _poll_handle_event(short revents, eio_obj_t *obj, List objList)
 	}
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * Register, re-arm or modify fd in the epoll set for "events", or remove
+ * it if "events" is 0. Returns -1 if the fd can not be polled with epoll,
+ * e.g. a regular file.
+ */
+static int _epoll_ctl(eio_epoll_t *ep, int fd, uint32_t events)
+{
+	eio_epoll_fd_t *slot = &ep->fds[fd];
+	struct epoll_event ev;
+	int op = slot->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+	memset(&ev, 0, sizeof(ev));
+	if (!events) {
+		/* fails harmlessly if the fd has already been closed */
+		(void) epoll_ctl(ep->epfd, EPOLL_CTL_DEL, fd, &ev);
+		slot->armed = false;
+		slot->events = 0;
+		slot->obj = NULL;
+		ep->registered--;
+		return 0;
+	}
+
+	if (op == EPOLL_CTL_ADD)
+		slot->seq = ++ep->seq;
+	ev.events = events | EPOLLONESHOT;
+	ev.data.u64 = ((uint64_t) slot->seq << 32) | (uint32_t) fd;
+	if (epoll_ctl(ep->epfd, op, fd, &ev) < 0) {
+		/* the fd may have been closed and reused since registered */
+		if ((op == EPOLL_CTL_MOD) && (errno == ENOENT)) {
+			slot->seq = ++ep->seq;
+			ev.data.u64 = ((uint64_t) slot->seq << 32) |
+				      (uint32_t) fd;
+			op = EPOLL_CTL_ADD;
+		} else if ((op == EPOLL_CTL_ADD) && (errno == EEXIST)) {
+			op = EPOLL_CTL_MOD;
+		} else {
+			debug2("%s: epoll_ctl(%d): %m", __func__, fd);
+			return -1;
+		}
+		if (epoll_ctl(ep->epfd, op, fd, &ev) < 0) {
+			debug2("%s: epoll_ctl(%d): %m", __func__, fd);
+			return -1;
+		}
+	}
+
+	if (!slot->events)
+		ep->registered++;
+	slot->armed = true;
+	slot->events = events;
+	return 0;
+}
+
+/*
+ * Update the epoll set to the objects' current readable()/writable()
+ * state. Only fds whose wanted events changed, or which fired during the
+ * previous iteration, need an epoll_ctl() call.
+ *
+ * Returns the number of objects being polled, or -1 if the epoll set can
+ * not represent them (an fd shared by two objects or one epoll does not
+ * support), in which case the caller falls back to poll().
+ */
+static int _epoll_setup_obj(void *x, void *arg)
+{
+	eio_obj_t *obj = x;
+	eio_epoll_t *ep = arg;
+	eio_epoll_fd_t *slot;
+	uint32_t events = 0;
+	int fd;
+
+	if (_is_readable(obj))
+		events |= EPOLLIN | EPOLLRDHUP;
+	if (_is_writable(obj))
+		events |= EPOLLOUT;
+	if (!events)
+		return 0;
+	ep->nfds++;
+	if ((fd = obj->fd) < 0)		/* ignored, as by poll() */
+		return 0;
+
+	if (fd >= ep->fds_size) {
+		int new_size = MAX(fd + 1, ep->fds_size * 2);
+		xrealloc(ep->fds, new_size * sizeof(eio_epoll_fd_t));
+		ep->fds_size = new_size;
+	}
+	slot = &ep->fds[fd];
+	if (slot->gen == ep->gen)
+		return -1;
+	slot->gen = ep->gen;
+	ep->nregs++;
+	if (slot->armed && (slot->obj == obj) && (slot->obj_id == obj->id) &&
+	    (slot->events == events))
+		return 0;
+	slot->obj = obj;
+	slot->obj_id = obj->id;
+	return _epoll_ctl(ep, fd, events);
+}
+
+static int _epoll_setup(eio_epoll_t *ep, List l)
+{
+	int fd;
+
+	ep->gen++;
+	ep->nfds = 0;
+	ep->nregs = 0;
+	if (list_for_each(l, _epoll_setup_obj, ep) < 0)
+		return -1;
+
+	/* remove fds no longer polled by any object */
+	if (ep->nregs != ep->registered) {
+		for (fd = 0; fd < ep->fds_size; fd++) {
+			if (ep->fds[fd].events && (ep->fds[fd].gen != ep->gen))
+				_epoll_ctl(ep, fd, 0);
+		}
+	}
+
+	return ep->nfds;
+}
+
+static short _epoll_revents(uint32_t events)
+{
+	short revents = 0;
+
+	if (events & EPOLLIN)
+		revents |= POLLIN;
+	if (events & EPOLLOUT)
+		revents |= POLLOUT;
+	if (events & EPOLLERR)
+		revents |= POLLERR;
+	if (events & EPOLLHUP)
+		revents |= POLLHUP;
+#ifdef POLLRDHUP
+	if (events & EPOLLRDHUP)
+		revents |= POLLRDHUP;
+#endif
+	return revents;
+}
+
+/*
+ * Same as _poll_mainloop(), but the set of polled fds is kept registered
+ * with epoll between iterations and only the objects with pending events
+ * are dispatched, rather than building and scanning a pollfd array of
+ * every object on each wakeup.
+ *
+ * Returns 1 if poll() must be used instead, otherwise as _poll_mainloop().
+ */
+static int _epoll_mainloop(eio_handle_t *eio)
+{
+	eio_epoll_t ep;
+	struct epoll_event ev;
+	eio_epoll_fd_t *slot;
+	time_t shutdown_time;
+	int i, n, fd, nfds, max_events = 0, timeout, retval = 0;
+
+	memset(&ep, 0, sizeof(ep));
+	if ((ep.epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		debug2("%s: epoll_create1: %m", __func__);
+		return 1;
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u64 = EIO_EPOLL_WAKEUP;
+	if (epoll_ctl(ep.epfd, EPOLL_CTL_ADD, eio->fds[0], &ev) < 0) {
+		debug2("%s: epoll_ctl: %m", __func__);
+		retval = 1;
+		goto done;
+	}
+
+	while (1) {
+		debug4("eio: handling events for %d objects",
+		       list_count(eio->obj_list));
+		if ((nfds = _epoll_setup(&ep, eio->obj_list)) < 0) {
+			retval = 1;
+			goto done;
+		}
+		if (nfds == 0)
+			goto done;
+		if (max_events < nfds + 1) {
+			max_events = nfds + 1;
+			xrealloc(ep.events, max_events * sizeof(ev));
+		}
+
+		slurm_mutex_lock(&eio->shutdown_mutex);
+		shutdown_time = eio->shutdown_time;
+		slurm_mutex_unlock(&eio->shutdown_mutex);
+		if (shutdown_time)
+			timeout = 1000;	/* Return every 1000 msec */
+		else
+			timeout = -1;
+		if ((n = epoll_wait(ep.epfd, ep.events, max_events,
+				    timeout)) < 0) {
+			if (errno != EINTR) {
+				error("epoll_wait: %m");
+				retval = -1;
+				goto done;
+			}
+			n = 0;
+		}
+
+		/* See if we've been told to shut down by eio_signal_shutdown */
+		for (i = 0; i < n; i++) {
+			if (ep.events[i].data.u64 == EIO_EPOLL_WAKEUP) {
+				_eio_wakeup_handler(eio);
+				break;
+			}
+		}
+
+		for (i = 0; i < n; i++) {
+			if (ep.events[i].data.u64 == EIO_EPOLL_WAKEUP)
+				continue;
+			fd = (int) (ep.events[i].data.u64 & 0xffffffff);
+			slot = &ep.fds[fd];
+			if ((slot->seq != (ep.events[i].data.u64 >> 32)) ||
+			    !slot->obj)
+				continue;	/* registration of closed fd */
+			slot->armed = false;
+			_poll_handle_event(_epoll_revents(ep.events[i].events),
+					   slot->obj, eio->obj_list);
+		}
+
+		slurm_mutex_lock(&eio->shutdown_mutex);
+		shutdown_time = eio->shutdown_time;
+		slurm_mutex_unlock(&eio->shutdown_mutex);
+		if (shutdown_time &&
+		    (difftime(time(NULL), shutdown_time)>=eio->shutdown_wait)) {
+			error("%s: Abandoning IO %d secs after job shutdown "
+			      "initiated", __func__, eio->shutdown_wait);
+			retval = -1;
+			goto done;
+		}
+	}
+
+done:
+	close(ep.epfd);
+	xfree(ep.events);
+	xfree(ep.fds);
+	return retval;
+}
+#endif
+
+int eio_handle_mainloop(eio_handle_t *eio)
+{
+	xassert (eio != NULL);
+	xassert (eio->magic == EIO_MAGIC);
+
+#ifdef HAVE_SYS_EPOLL_H
+	if (!getenv("SLURM_EIO_POLL")) {
+		int rc = _epoll_mainloop(eio);
+		if (rc != 1)
+			return rc;
+		debug2("%s: falling back to poll()", __func__);
+	}
+#endif
+	return _poll_mainloop(eio);
+}
+
 static struct io_operations *
 _ops_copy(struct io_operations *ops)
 {
@@ -530,6 +829,9 @@ eio_obj_create(int fd, struct io_operations *ops, void *arg)
 	obj->arg = arg;
 	obj->ops = _ops_copy(ops);
 	obj->shutdown = false;
+	slurm_mutex_lock(&obj_id_mutex);
+	obj->id = ++obj_id;
+	slurm_mutex_unlock(&obj_id_mutex);
 	return obj;
 }
 
@@ -67,6 +67,7 @@ struct eio_obj {
 	void *arg;                        /* application-specific data       */
 	struct io_operations *ops;        /* pointer to ops struct for obj   */
 	bool shutdown;
+	uint32_t id;                      /* unique, set by eio_obj_create() */
 };
 
 eio_handle_t *eio_handle_create(uint16_t);
@@ -103,6 +104,13 @@ bool eio_remove_obj(eio_obj_t *obj, List objs);
  * readable() or writable().
  *
  * returns -1 on error.
+ *
+ * Where available, fds stay registered with epoll between iterations so
+ * only objects with pending events are dispatched. readable() and
+ * writable() are still called for every object on each iteration, with
+ * the object list locked. poll() is used instead if the SLURM_EIO_POLL
+ * environment variable is set, or if an fd can not be used with epoll
+ * (e.g. a regular file) or is shared by two objects.
  */
 int eio_handle_mainloop(eio_handle_t *eio);
 
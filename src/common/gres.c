@@ -160,6 +160,23 @@ typedef struct xcpuinfo_funcs {
 } xcpuinfo_funcs_t;
 xcpuinfo_funcs_t xcpuinfo_ops;
 
+/*
+ * Cores of a node usable by jobs, see _topo_avail_cores(). Entry
+ * (type_inx + 1) * 2 + use_total_gres of avail_cores is for jobs requesting
+ * the node's type_model[type_inx], type_inx -1 for jobs requesting no type
+ * and type_cnt for jobs requesting a type the node lacks.
+ */
+#define TOPO_CACHE_UNSET	0	/* entry not built yet */
+#define TOPO_CACHE_CORES	1	/* usable cores in avail_cores */
+#define TOPO_CACHE_ALL		2	/* all cores usable */
+typedef struct gres_topo_cache {
+	int core_cnt;		/* size of the avail_cores bitmaps */
+	uint16_t type_cnt;	/* type_cnt of the node when built */
+	int *topo_type_inx;	/* type_model index of topo_model[i], or -2 */
+	uint8_t *state;		/* TOPO_CACHE_* of each entry */
+	bitstr_t **avail_cores;
+} gres_topo_cache_t;
+
 /* Local variables */
 static int gres_context_cnt = -1;
 static uint32_t gres_cpu_cnt = 0;
@@ -248,6 +265,7 @@ static int	_step_state_validate(char *config,
 static uint64_t	_step_test(void *step_gres_data, void *job_gres_data,
 			   int node_offset, bool ignore_alloc, char *gres_name,
 			   uint32_t job_id, uint32_t step_id);
+static void	_topo_cache_free(gres_node_state_t *node_gres_ptr);
 static int	_unload_gres_plugin(slurm_gres_context_t *plugin_context);
 static void	_validate_config(slurm_gres_context_t *context_ptr);
 static int	_validate_file(char *path_name, char *gres_name);
@@ -1239,6 +1257,7 @@ static void _gres_node_list_delete(void *list_element)
 	gres_node_ptr = (gres_node_state_t *) gres_ptr->gres_data;
 	FREE_NULL_BITMAP(gres_node_ptr->gres_bit_alloc);
 	xfree(gres_node_ptr->gres_used);
+	_topo_cache_free(gres_node_ptr);
 	for (i = 0; i < gres_node_ptr->topo_cnt; i++) {
 		if (gres_node_ptr->topo_cpus_bitmap)
 			FREE_NULL_BITMAP(gres_node_ptr->topo_cpus_bitmap[i]);
@@ -1647,6 +1666,7 @@ static int _node_config_validate(char *node_name, char *orig_config,
 	gres_data = (gres_node_state_t *) gres_ptr->gres_data;
 	if (gres_data->node_feature)
 		return rc;
+	_topo_cache_free(gres_data);	/* Topology may change */
 
 	gres_cnt = _get_tot_gres_cnt(context_ptr->plugin_id, &set_cnt);
 	if (gres_data->gres_cnt_found != gres_cnt) {
@@ -2353,6 +2373,7 @@ static void _node_state_dealloc(gres_state_t *gres_ptr)
 
 	gres_node_ptr = (gres_node_state_t *) gres_ptr->gres_data;
 	gres_node_ptr->gres_cnt_alloc = 0;
+	_topo_cache_free(gres_node_ptr);
 	if (gres_node_ptr->gres_bit_alloc) {
 		int i = bit_size(gres_node_ptr->gres_bit_alloc) - 1;
 		if (i >= 0)
@@ -3370,26 +3391,114 @@ static void _validate_gres_node_cpus(gres_node_state_t *node_gres_ptr,
 						     cpus_ctld);
 		FREE_NULL_BITMAP(node_gres_ptr->topo_cpus_bitmap[i]);
 		node_gres_ptr->topo_cpus_bitmap[i] = new_cpu_bitmap;
+		_topo_cache_free(node_gres_ptr);
 	}
 }
 
-static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
-				 bool use_total_gres, bitstr_t *cpu_bitmap,
-				 int cpu_start_bit, int cpu_end_bit,
-				 char *gres_name, char *node_name)
+static void _topo_cache_free(gres_node_state_t *node_gres_ptr)
 {
-	int i, j, cpus_ctld;
-	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
-	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
-	bitstr_t *avail_cpu_bitmap = NULL;
+	gres_topo_cache_t *cache = node_gres_ptr->topo_cache;
+	int i;
 
-	if (!node_gres_ptr->topo_cnt || !cpu_bitmap ||	/* No topology info */
-	    !job_gres_ptr->gres_cnt_alloc)		/* No job GRES */
+	if (!cache)
 		return;
+	for (i = 0; i < (cache->type_cnt + 2) * 2; i++)
+		FREE_NULL_BITMAP(cache->avail_cores[i]);
+	xfree(cache->avail_cores);
+	xfree(cache->state);
+	xfree(cache->topo_type_inx);
+	xfree(node_gres_ptr->topo_cache);
+}
 
-	/* Determine which specific CPUs can be used */
-	avail_cpu_bitmap = bit_copy(cpu_bitmap);
-	bit_nclear(avail_cpu_bitmap, cpu_start_bit, cpu_end_bit);
+/* Return the node's topology cache, building it if needed */
+static gres_topo_cache_t *_topo_cache_get(gres_node_state_t *node_gres_ptr)
+{
+	gres_topo_cache_t *cache = node_gres_ptr->topo_cache;
+	int i, j;
+
+	/* _add_gres_type() may have added a type */
+	if (cache && (cache->type_cnt != node_gres_ptr->type_cnt)) {
+		_topo_cache_free(node_gres_ptr);
+		cache = NULL;
+	}
+	if (cache)
+		return cache;
+
+	cache = xmalloc(sizeof(gres_topo_cache_t));
+	cache->type_cnt = node_gres_ptr->type_cnt;
+	cache->topo_type_inx = xmalloc(sizeof(int) * node_gres_ptr->topo_cnt);
+	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+		cache->topo_type_inx[i] = -2;
+		if (!node_gres_ptr->topo_model[i])
+			continue;
+		for (j = 0; j < node_gres_ptr->type_cnt; j++) {
+			if (!xstrcmp(node_gres_ptr->topo_model[i],
+				     node_gres_ptr->type_model[j])) {
+				cache->topo_type_inx[i] = j;
+				break;
+			}
+		}
+	}
+	cache->state = xmalloc(sizeof(uint8_t) * (cache->type_cnt + 2) * 2);
+	cache->avail_cores = xmalloc(sizeof(bitstr_t *) *
+				     (cache->type_cnt + 2) * 2);
+	node_gres_ptr->topo_cache = cache;
+	return cache;
+}
+
+/* Return the index of the job's gres type in the node's type_model, -1 if
+ * the job requests no type or type_cnt if the node lacks it */
+static int _job_type_inx(gres_job_state_t *job_gres_ptr,
+			 gres_node_state_t *node_gres_ptr)
+{
+	int i;
+
+	if (!job_gres_ptr->type_model)
+		return -1;
+	for (i = 0; i < node_gres_ptr->type_cnt; i++) {
+		if (!xstrcmp(job_gres_ptr->type_model,
+			     node_gres_ptr->type_model[i]))
+			break;
+	}
+	return i;
+}
+
+/* Return true if topology entry topo_inx has the gres type of a job */
+static bool _topo_type_match(gres_topo_cache_t *cache, int topo_inx,
+			     int job_type_inx)
+{
+	return ((job_type_inx == -1) ||
+		(cache->topo_type_inx[topo_inx] == job_type_inx));
+}
+
+/*
+ * Return a bitmap of the node's cores from which a job can use some GRES,
+ * or NULL if all cores qualify. The bitmap is cached in the node's gres
+ * state until its allocations or configuration change.
+ * IN job_type_inx - from _job_type_inx()
+ * IN core_cnt - size of the node's topo_cpus_bitmap entries
+ */
+static bitstr_t *_topo_avail_cores(gres_node_state_t *node_gres_ptr,
+				   int job_type_inx, bool use_total_gres,
+				   int core_cnt)
+{
+	gres_topo_cache_t *cache = _topo_cache_get(node_gres_ptr);
+	int i, inx = (job_type_inx + 1) * 2 + (use_total_gres ? 1 : 0);
+	bitstr_t *avail_cores;
+
+	if (cache->core_cnt != core_cnt) {
+		for (i = 0; i < (cache->type_cnt + 2) * 2; i++) {
+			FREE_NULL_BITMAP(cache->avail_cores[i]);
+			cache->state[i] = TOPO_CACHE_UNSET;
+		}
+		cache->core_cnt = core_cnt;
+	}
+	if (cache->state[inx] == TOPO_CACHE_ALL)
+		return NULL;
+	if (cache->state[inx] == TOPO_CACHE_CORES)
+		return cache->avail_cores[inx];
+
+	avail_cores = bit_alloc(core_cnt);
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 			continue;
@@ -3397,26 +3506,62 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 		    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 		     node_gres_ptr->topo_gres_cnt_avail[i]))
 			continue;
-		if (job_gres_ptr->type_model &&
-		    (!node_gres_ptr->topo_model[i] ||
-		     xstrcmp(job_gres_ptr->type_model,
-			     node_gres_ptr->topo_model[i])))
+		if (!_topo_type_match(cache, i, job_type_inx))
 			continue;
 		if (!node_gres_ptr->topo_cpus_bitmap[i]) {
-			FREE_NULL_BITMAP(avail_cpu_bitmap);	/* No filter */
-			return;
-		}
-		cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
-		_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
-		cpus_ctld = bit_size(node_gres_ptr->topo_cpus_bitmap[i]);
-		for (j = 0; j < cpus_ctld; j++) {
-			if (bit_test(node_gres_ptr->topo_cpus_bitmap[i], j)) {
-				bit_set(avail_cpu_bitmap, cpu_start_bit + j);
-			}
+			FREE_NULL_BITMAP(avail_cores);	/* No filter */
+			cache->state[inx] = TOPO_CACHE_ALL;
+			return NULL;
 		}
+		bit_or(avail_cores, node_gres_ptr->topo_cpus_bitmap[i]);
+	}
+	cache->avail_cores[inx] = avail_cores;
+	cache->state[inx] = TOPO_CACHE_CORES;
+	return avail_cores;
+}
+
+/* Return a bitmap of the cores set in cpu_bitmap between cpu_start_bit and
+ * cpu_start_bit + cpu_cnt - 1, shifted to start at zero */
+static bitstr_t *_node_core_bitmap(bitstr_t *cpu_bitmap, int cpu_start_bit,
+				   int cpu_cnt)
+{
+	bitstr_t *node_bitmap = bit_alloc(cpu_cnt);
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		if (bit_test(cpu_bitmap, cpu_start_bit + i))
+			bit_set(node_bitmap, i);
+	}
+	return node_bitmap;
+}
+
+static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
+				 bool use_total_gres, bitstr_t *cpu_bitmap,
+				 int cpu_start_bit, int cpu_end_bit,
+				 char *gres_name, char *node_name)
+{
+	int i, cpus_ctld;
+	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
+	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
+	bitstr_t *avail_cpu_bitmap;
+
+	if (!node_gres_ptr->topo_cnt || !cpu_bitmap ||	/* No topology info */
+	    !job_gres_ptr->gres_cnt_alloc)		/* No job GRES */
+		return;
+
+	/* Determine which specific CPUs can be used */
+	cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
+	_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
+	avail_cpu_bitmap = _topo_avail_cores(node_gres_ptr,
+					     _job_type_inx(job_gres_ptr,
+							   node_gres_ptr),
+					     use_total_gres, cpus_ctld);
+	if (!avail_cpu_bitmap)				/* No filter */
+		return;
+	for (i = 0; i < cpus_ctld; i++) {
+		if (!bit_test(avail_cpu_bitmap, i))
+			bit_clear(cpu_bitmap, cpu_start_bit + i);
 	}
-	bit_and(cpu_bitmap, avail_cpu_bitmap);
-	FREE_NULL_BITMAP(avail_cpu_bitmap);
 }
 
 static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
@@ -3433,6 +3578,8 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 	uint32_t cpu_cnt = 0;
 	bitstr_t *alloc_cpu_bitmap = NULL;
 	bitstr_t *avail_cpu_bitmap = NULL;
+	gres_topo_cache_t *cache;
+	int job_type_inx;
 
 	if (node_gres_ptr->no_consume)
 		use_total_gres = true;
@@ -3450,40 +3597,28 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 			_validate_gres_node_cpus(node_gres_ptr, cpus_ctld,
 						 node_name);
+			avail_cpu_bitmap = _node_core_bitmap(cpu_bitmap,
+							     cpu_start_bit,
+							     cpus_ctld);
 		}
+		cache = _topo_cache_get(node_gres_ptr);
+		job_type_inx = _job_type_inx(job_gres_ptr, node_gres_ptr);
 		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
-			if (job_gres_ptr->type_model &&
-			    (!node_gres_ptr->topo_model[i] ||
-			     xstrcmp(node_gres_ptr->topo_model[i],
-				     job_gres_ptr->type_model)))
-				continue;
-			if (!node_gres_ptr->topo_cpus_bitmap[i]) {
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
+			if (!_topo_type_match(cache, i, job_type_inx))
 				continue;
-			}
-			cpus_ctld = bit_size(node_gres_ptr->
-					     topo_cpus_bitmap[i]);
-			for (j = 0; j < cpus_ctld; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (!bit_test(node_gres_ptr->
-					      topo_cpus_bitmap[i], j))
-					continue; /* not avail for this gres */
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
-				break;
+			if (node_gres_ptr->topo_cpus_bitmap[i] &&
+			    (avail_cpu_bitmap ?
+			     !bit_overlap(avail_cpu_bitmap,
+					  node_gres_ptr->topo_cpus_bitmap[i]) :
+			     (bit_ffs(node_gres_ptr->topo_cpus_bitmap[i]) < 0)))
+				continue; /* not avail for this gres */
+			gres_avail += node_gres_ptr->topo_gres_cnt_avail[i];
+			if (!use_total_gres) {
+				gres_avail -= node_gres_ptr->
+					      topo_gres_cnt_alloc[i];
 			}
 		}
+		FREE_NULL_BITMAP(avail_cpu_bitmap);
 		if (job_gres_ptr->gres_cnt_alloc > gres_avail)
 			return (uint32_t) 0;	/* insufficient, gres to use */
 		return NO_VAL;
@@ -3514,17 +3649,18 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 		}
 
-		alloc_cpu_bitmap = bit_alloc(cpus_ctld);
 		if (cpu_bitmap) {
-			for (j = 0; j < cpus_ctld; j++) {
-				if (bit_test(cpu_bitmap, cpu_start_bit+j))
-					bit_set(alloc_cpu_bitmap, j);
-			}
+			alloc_cpu_bitmap = _node_core_bitmap(cpu_bitmap,
+							     cpu_start_bit,
+							     cpus_ctld);
 		} else {
+			alloc_cpu_bitmap = bit_alloc(cpus_ctld);
 			bit_nset(alloc_cpu_bitmap, 0, cpus_ctld - 1);
 		}
 
 		avail_cpu_bitmap = bit_copy(alloc_cpu_bitmap);
+		cache = _topo_cache_get(node_gres_ptr);
+		job_type_inx = _job_type_inx(job_gres_ptr, node_gres_ptr);
 		cpus_addnt = xmalloc(sizeof(uint32_t)*node_gres_ptr->topo_cnt);
 		cpus_avail = xmalloc(sizeof(uint32_t)*node_gres_ptr->topo_cnt);
 		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
@@ -3534,24 +3670,20 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 			     node_gres_ptr->topo_gres_cnt_avail[i]))
 				continue;
-			if (job_gres_ptr->type_model &&
-			    (!node_gres_ptr->topo_model[i] ||
-			     xstrcmp(node_gres_ptr->topo_model[i],
-				     job_gres_ptr->type_model)))
+			if (!_topo_type_match(cache, i, job_type_inx))
 				continue;
 			if (!node_gres_ptr->topo_cpus_bitmap[i]) {
 				cpus_avail[i] = cpu_end_bit - cpu_start_bit + 1;
 				continue;
 			}
 			cpu_size = bit_size(node_gres_ptr->topo_cpus_bitmap[i]);
-			for (j = 0; j < cpu_size; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (bit_test(node_gres_ptr->
-					     topo_cpus_bitmap[i], j)) {
-					cpus_avail[i]++;
-				}
+			if (!cpu_bitmap) {
+				cpus_avail[i] = bit_set_count(node_gres_ptr->
+							topo_cpus_bitmap[i]);
+			} else if (cpu_size == cpus_ctld) {
+				cpus_avail[i] = bit_overlap(avail_cpu_bitmap,
+							    node_gres_ptr->
+							    topo_cpus_bitmap[i]);
 			}
 		}
 
@@ -3629,12 +3761,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 		xfree(cpus_avail);
 		return cpu_cnt;
 	} else if (job_gres_ptr->type_model) {
-		for (i = 0; i < node_gres_ptr->type_cnt; i++) {
-			if (node_gres_ptr->type_model[i] &&
-			    !xstrcmp(node_gres_ptr->type_model[i],
-				     job_gres_ptr->type_model))
-				break;
-		}
+		i = _job_type_inx(job_gres_ptr, node_gres_ptr);
 		if (i >= node_gres_ptr->type_cnt)
 			return (uint32_t) 0;	/* no such type */
 		gres_avail = node_gres_ptr->type_cnt_avail[i];
@@ -3672,7 +3799,7 @@ extern void gres_plugin_job_core_filter(List job_gres_list, List node_gres_list,
 					char *node_name)
 {
 	int i;
-	ListIterator  job_gres_iter, node_gres_iter;
+	ListIterator  job_gres_iter;
 	gres_state_t *job_gres_ptr, *node_gres_ptr;
 
 	if ((job_gres_list == NULL) || (cpu_bitmap == NULL))
@@ -3687,13 +3814,8 @@ extern void gres_plugin_job_core_filter(List job_gres_list, List node_gres_list,
 	slurm_mutex_lock(&gres_context_lock);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		node_gres_ptr = list_find_first(node_gres_list, _gres_find_id,
+						&job_gres_ptr->plugin_id);
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			bit_nclear(cpu_bitmap, cpu_start_bit, cpu_end_bit);
@@ -3739,7 +3861,7 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 {
 	int i;
 	uint32_t cpu_cnt, tmp_cnt;
-	ListIterator job_gres_iter,  node_gres_iter;
+	ListIterator job_gres_iter;
 	gres_state_t *job_gres_ptr, *node_gres_ptr;
 	bool topo_set = false;
 
@@ -3754,13 +3876,8 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 	slurm_mutex_lock(&gres_context_lock);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		node_gres_ptr = list_find_first(node_gres_list, _gres_find_id,
+						&job_gres_ptr->plugin_id);
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			cpu_cnt = 0;
@@ -3908,6 +4025,7 @@ static int _job_alloc(void *job_gres_data, void *node_gres_data,
 		return SLURM_SUCCESS;
 
 	xfree(node_gres_ptr->gres_used);	/* Clear cache */
+	_topo_cache_free(node_gres_ptr);
 	if (job_gres_ptr->node_cnt == 0) {
 		job_gres_ptr->node_cnt = node_cnt;
 		if (job_gres_ptr->gres_bit_alloc) {
@@ -4251,6 +4369,7 @@ static int _job_dealloc(void *job_gres_data, void *node_gres_data,
 	}
 
 	xfree(node_gres_ptr->gres_used);	/* Clear cache */
+	_topo_cache_free(node_gres_ptr);
 	if (node_gres_ptr->gres_bit_alloc && job_gres_ptr->gres_bit_alloc &&
 	    job_gres_ptr->gres_bit_alloc[node_offset]) {
 		len = bit_size(job_gres_ptr->gres_bit_alloc[node_offset]);
@@ -123,6 +123,10 @@ typedef struct gres_node_state {
 	uint64_t *type_cnt_alloc;
 	uint64_t *type_cnt_avail;
 	char **type_model;		/* Type of this gres (e.g. model name) */
+
+	/* Cores usable by jobs, by job gres type. Set NULL if needs to be
+	 * rebuilt. */
+	struct gres_topo_cache *topo_cache;
 } gres_node_state_t;
 
 /* Gres job state as used by slurmctld daemon */
@@ -334,7 +334,6 @@ static int    _zero_padded(unsigned long, int);
 static int    _width_equiv(unsigned long, int *, unsigned long, int *);
 
 static int           host_prefix_end(const char *, int dims);
-static hostname_t    hostname_create(const char *);
 static void          hostname_destroy(hostname_t);
 static int           hostname_suffix_is_valid(hostname_t);
 static int           hostname_suffix_width(hostname_t);
@@ -382,7 +381,6 @@ static hostlist_iterator_t hostlist_iterator_new(void);
 static void               _iterator_advance(hostlist_iterator_t);
 static void               _iterator_advance_range(hostlist_iterator_t);
 
-static int hostset_find_host(hostset_t, const char *);
 
 /* ------[ macros ]------ */
 
@@ -459,12 +457,15 @@ static char * _next_tok(char *sep, char **str)
 		while ((**str != '\0') && (strchr(sep, **str) == NULL))
 			(*str)++;
 
-		/* push str past pairs of brackets */
-bracket: 	open_bracket = strchr(parse, '[');
-		if ((open_bracket == NULL) || (open_bracket > *str))
+		/* push str past pairs of brackets, only searching the
+		 * current token so long lists are parsed in linear time */
+bracket: 	open_bracket = memchr(parse, '[', *str - parse);
+		if (open_bracket == NULL)
 			break;
-		close_bracket = strchr(parse, ']');
-		if ((close_bracket == NULL) || (close_bracket < open_bracket))
+		if (memchr(parse, ']', open_bracket - parse))
+			break;
+		close_bracket = strchr(open_bracket, ']');
+		if (close_bracket == NULL)
 			break;
 		if (close_bracket < *str) {
 			parse = close_bracket + 1;
@@ -616,16 +617,6 @@ static hostname_t hostname_create_dims(const char *hostname, int dims)
 
 	return hn;
 }
-/*
- * create a hostname_t object from a string hostname
- */
-static hostname_t hostname_create(const char *hostname)
-{
-	int dims = slurmdb_setup_cluster_name_dims();
-
-	return hostname_create_dims(hostname, dims);
-}
-
 /* free a hostname object
  */
 static void hostname_destroy(hostname_t hn)
@@ -3565,14 +3556,296 @@ void hostset_destroy(hostset_t set)
 	free(set);
 }
 
+/* Binary search the sorted ranges of a hostset for the first range that
+ * is not less than hr, i.e. the position at which hr would be inserted.
+ * Assumes that the hostlist lock is already held.
+ */
+static int _hostset_search(hostlist_t hl, hostrange_t hr)
+{
+	int lo = 0, hi = hl->nranges, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (hostrange_cmp(hl->hr[mid], hr) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Return true if range hr contains hostname hn, without moving digits of
+ * the hostname suffix into its prefix as hostrange_hn_within() may do.
+ */
+static int _hostset_hn_match(hostrange_t hr, hostname_t hn, int dims)
+{
+	if (!hr->singlehost && hostname_suffix_is_valid(hn) &&
+	    strcmp(hr->prefix, hn->prefix))
+		return 0;
+	return hostrange_hn_within(hr, hn, dims);
+}
+
+/* Return true if any range of hl has a prefix ending in a digit. Only then
+ * can a hostname like nid00002 match a range like nid0000[2-7]. The result
+ * is cached in *padded (initially -1) since this is a linear scan.
+ */
+static bool _hostset_padded(hostlist_t hl, int dims, int *padded)
+{
+	int i, len;
+
+	if (*padded >= 0)
+		return *padded;
+	*padded = 0;
+	for (i = 0; (dims == 1) && (i < hl->nranges); i++) {
+		len = strlen(hl->hr[i]->prefix);
+		if (len && isdigit((int) hl->hr[i]->prefix[len - 1])) {
+			*padded = 1;
+			break;
+		}
+	}
+	return *padded;
+}
+
+/* Find the range of a hostset containing hostname hn in O(log n) and
+ * return its index, or -1 if not found. If num is not NULL, it is set to
+ * the suffix value of the host within that range. If padded is true,
+ * leading digits of the suffix are also tried as part of the prefix.
+ * Assumes that the hostlist lock is already held.
+ */
+static int _hostset_find_range(hostlist_t hl, hostname_t hn, int dims,
+			       bool padded, unsigned long *num)
+{
+	struct hostrange_components probe;
+	struct hostname_components tmp;
+	char prefix[MAXHOSTNAMELEN + 16];
+	int i, k, plen, slen;
+
+	if (hostname_suffix_is_valid(hn)) {
+		probe.prefix = hn->prefix;
+		probe.lo = probe.hi = hn->num;
+		probe.width = hostname_suffix_width(hn);
+		probe.singlehost = 0;
+	} else {
+		probe.prefix = hn->hostname;
+		probe.lo = probe.hi = 0;
+		probe.width = 0;
+		probe.singlehost = 1;
+	}
+
+	i = _hostset_search(hl, &probe);
+	if ((i < hl->nranges) && _hostset_hn_match(hl->hr[i], hn, dims))
+		goto found;
+	if ((i > 0) && _hostset_hn_match(hl->hr[--i], hn, dims))
+		goto found;
+
+	if (!padded || !hostname_suffix_is_valid(hn))
+		return -1;
+
+	plen = hn->suffix - hn->hostname;
+	slen = strlen(hn->suffix);
+	if (plen + slen >= sizeof(prefix))
+		return -1;
+	tmp.hostname = hn->hostname;
+	tmp.prefix = prefix;
+	for (k = 1; k < slen; k++) {
+		memcpy(prefix, hn->hostname, plen + k);
+		prefix[plen + k] = '\0';
+		tmp.suffix = hn->suffix + k;
+		tmp.num = strtoul(tmp.suffix, NULL, 10);
+		if ((i = _hostset_find_range(hl, &tmp, dims, false, num)) >= 0)
+			return i;
+	}
+	return -1;
+
+found:
+	if (num)
+		*num = hn->num;
+	return i;
+}
+
+/* Find host number depth of range hr in a hostset, return the index of the
+ * range containing it or -1. Used for single hosts and when the hostset may
+ * hold zero padded prefixes.
+ */
+static int _hostset_find_nth(hostlist_t hl, hostrange_t hr, int depth,
+			     int dims, bool padded, unsigned long *num)
+{
+	hostname_t hn;
+	char *host;
+	int i;
+
+	if (!(host = _hostrange_string(hr, depth)))
+		return -1;
+	hn = hostname_create_dims(host, dims);
+	i = _hostset_find_range(hl, hn, dims, padded, num);
+	hostname_destroy(hn);
+	free(host);
+	return i;
+}
+
+/* Return the number of hosts of range hr that are in a hostset. Ranges of
+ * the hostset are sorted and disjoint, so only those from the insertion
+ * point of hr up to its last host need to be examined.
+ * Assumes that the hostlist lock is already held.
+ */
+static unsigned long _hostset_range_cnt(hostlist_t hl, hostrange_t hr,
+					int dims, int *padded)
+{
+	unsigned long cnt = 0;
+	hostrange_t h;
+	int i, cmp;
+
+	if (hr->singlehost)
+		return (_hostset_find_nth(hl, hr, 0, dims, (dims == 1),
+					  NULL) >= 0);
+
+	i = _hostset_search(hl, hr);
+	for (i = MAX(i - 1, 0); i < hl->nranges; i++) {
+		h = hl->hr[i];
+		if ((cmp = hostrange_prefix_cmp(h, hr)) < 0)
+			continue;
+		if (cmp > 0)
+			break;
+		if (!hostrange_width_combine(h, hr))
+			continue;
+		if (h->lo > hr->hi)
+			break;
+		if (h->hi < hr->lo)
+			continue;
+		cnt += MIN(h->hi, hr->hi) - MAX(h->lo, hr->lo) + 1;
+	}
+
+	if ((cnt < hostrange_count(hr)) && _hostset_padded(hl, dims, padded)) {
+		for (i = 0, cnt = 0; i < hostrange_count(hr); i++) {
+			if (_hostset_find_nth(hl, hr, i, dims, true, NULL) >= 0)
+				cnt++;
+		}
+	}
+
+	return cnt;
+}
+
+/* Remove host num from range i of a hostset.
+ * Assumes that the hostlist lock is already held.
+ */
+static void _hostset_delete_num(hostlist_t hl, int i, unsigned long num)
+{
+	hostrange_t hr = hl->hr[i], new;
+
+	if (hr->singlehost) {
+		hostlist_delete_range(hl, i);
+	} else if ((new = hostrange_delete_host(hr, num))) {
+		hostlist_insert_range(hl, new, i + 1);
+		hostrange_destroy(new);
+	} else if (hostrange_empty(hr))
+		hostlist_delete_range(hl, i);
+	hl->nhosts--;
+}
+
+/* Drop ranges of hl that were destroyed and set to NULL with a single pass
+ * over the array, instead of one hostlist_delete_range() call per range.
+ * Assumes that the hostlist lock is already held.
+ */
+static void _hostlist_compact(hostlist_t hl)
+{
+	hostlist_iterator_t hli;
+	int i, j;
+
+	/* same effect on iterators as deleting the ranges one at a time */
+	for (hli = hl->ilist; hli; hli = hli->next) {
+		for (i = 0, j = 0; (i <= hli->idx) && (i < hl->nranges); i++) {
+			if (!hl->hr[i])
+				j++;
+		}
+		hli->idx -= j;
+	}
+
+	for (i = 0, j = 0; i < hl->nranges; i++) {
+		if (hl->hr[i])
+			hl->hr[j++] = hl->hr[i];
+	}
+	for (i = j; i < hl->nranges; i++)
+		hl->hr[i] = NULL;
+	hl->nranges = j;
+
+	for (hli = hl->ilist; hli; hli = hli->next) {
+		if (hli->idx >= 0)
+			hli->hr = hl->hr[hli->idx];
+		else
+			hostlist_iterator_reset(hli);
+	}
+}
+
+/* Remove the hosts of range hr from a hostset, return the number removed.
+ * Assumes that the hostlist lock is already held.
+ */
+static int _hostset_delete_range(hostlist_t hl, hostrange_t hr, int dims,
+				 int *padded)
+{
+	unsigned long lo, hi, num;
+	int i, cmp, n = 0, removed = 0;
+	hostrange_t h, new;
+
+	if (hr->singlehost)
+		goto per_host;
+
+	i = _hostset_search(hl, hr);
+	for (i = MAX(i - 1, 0); i < hl->nranges; i++) {
+		h = hl->hr[i];
+		if ((cmp = hostrange_prefix_cmp(h, hr)) > 0)
+			break;
+		if ((cmp < 0) || !hostrange_width_combine(h, hr) ||
+		    (h->hi < hr->lo))
+			continue;
+		if (h->lo > hr->hi)
+			break;
+
+		lo = MAX(h->lo, hr->lo);
+		hi = MIN(h->hi, hr->hi);
+		n += hi - lo + 1;
+		hl->nhosts -= hi - lo + 1;
+		if ((lo > h->lo) && (hi < h->hi)) {
+			new = hostrange_copy(h);
+			new->lo = hi + 1;
+			h->hi = lo - 1;
+			hostlist_insert_range(hl, new, ++i);
+			hostrange_destroy(new);
+		} else if (lo > h->lo) {
+			h->hi = lo - 1;
+		} else if (hi < h->hi) {
+			h->lo = hi + 1;
+		} else {
+			/* removed below along with any others */
+			hostrange_destroy(h);
+			hl->hr[i] = NULL;
+			removed++;
+		}
+	}
+	if (removed)
+		_hostlist_compact(hl);
+
+	if ((n == hostrange_count(hr)) || !_hostset_padded(hl, dims, padded))
+		return n;
+
+per_host:
+	/* hosts not removed above may still match a zero padded prefix */
+	for (i = 0; i < hostrange_count(hr); i++) {
+		if ((cmp = _hostset_find_nth(hl, hr, i, dims, (dims == 1),
+					     &num)) >= 0) {
+			_hostset_delete_num(hl, cmp, num);
+			n++;
+		}
+	}
+	return n;
+}
+
 /* inserts a single range object into a hostset
  * Assumes that the set->hl lock is already held
  * Updates hl->nhosts
  */
 static int hostset_insert_range(hostset_t set, hostrange_t hr)
 {
-	int i = 0;
-	int inserted = 0;
+	int i, m;
 	int nhosts = 0;
 	int ndups = 0;
 	hostlist_t hl;
@@ -3584,36 +3857,18 @@ static int hostset_insert_range(hostset_t set, hostrange_t hr)
 
 	nhosts = hostrange_count(hr);
 
-	for (i = 0; i < hl->nranges; i++) {
-		if (hostrange_cmp(hr, hl->hr[i]) <= 0) {
-
-			if ((ndups = hostrange_join(hr, hl->hr[i])) >= 0)
-				hostlist_delete_range(hl, i);
-			else if (ndups < 0)
-				ndups = 0;
-
-			hostlist_insert_range(hl, hr, i);
-
-			/* now attempt to join hr[i] and hr[i-1] */
-			if (i > 0) {
-				int m;
-				if ((m = _attempt_range_join(hl, i)) > 0)
-					ndups += m;
-			}
-			hl->nhosts += nhosts - ndups;
-			inserted = 1;
-			break;
-		}
-	}
+	i = _hostset_search(hl, hr);
+	if (!hostlist_insert_range(hl, hr, i))
+		return 0;
+	hl->nhosts += nhosts;
 
-	if (inserted == 0) {
-		hl->hr[hl->nranges++] = hostrange_copy(hr);
-		hl->nhosts += nhosts;
-		if (hl->nranges > 1) {
-			if ((ndups = _attempt_range_join(hl, hl->nranges - 1)) <= 0)
-				ndups = 0;
-		}
-	}
+	/* absorb following ranges that hr overlaps, then attempt to
+	 * join hr[i] and hr[i-1] */
+	while ((i < hl->nranges - 1) &&
+	       ((m = _attempt_range_join(hl, i + 1)) >= 0))
+		ndups += m;
+	if ((i > 0) && ((m = _attempt_range_join(hl, i)) > 0))
+		ndups += m;
 
 	/*
 	 *  Return the number of unique hosts inserted
@@ -3638,47 +3893,25 @@ int hostset_insert(hostset_t set, const char *hosts)
 }
 
 
-/* linear search through N ranges for hostname "host"
- * */
-static int hostset_find_host(hostset_t set, const char *host)
-{
-	int i;
-	int retval = 0;
-	hostname_t hn;
-	LOCK_HOSTLIST(set->hl);
-	hn = hostname_create(host);
-	for (i = 0; i < set->hl->nranges; i++) {
-		/*
-		 * FIXME: THIS WILL NOT ALWAYS WORK CORRECTLY IF CALLED FROM A
-		 * LOCATION THAT COULD HAVE DIFFERENT DIMENSIONS
-		 * (i.e. slurmdbd).
-		 */
-		if (hostrange_hn_within(set->hl->hr[i], hn, 0)) {
-			retval = 1;
-			goto done;
-		}
-	}
-done:
-	UNLOCK_HOSTLIST(set->hl);
-	hostname_destroy(hn);
-	return retval;
-}
-
 int hostset_intersects(hostset_t set, const char *hosts)
 {
-	int retval = 0;
+	int i, retval = 0;
+	int dims = slurmdb_setup_cluster_name_dims();
+	int padded = -1;
 	hostlist_t hl;
-	char *hostname;
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
-	hl = hostlist_create(hosts);
-	while ((hostname = hostlist_pop(hl)) != NULL) {
-		retval += hostset_find_host(set, hostname);
-		free(hostname);
-		if (retval)
-			break;
+	if (!(hl = hostlist_create(hosts)))
+		return 0;
+	hostlist_uniq(hl);
+
+	LOCK_HOSTLIST(set->hl);
+	for (i = 0; (i < hl->nranges) && !retval; i++) {
+		if (_hostset_range_cnt(set->hl, hl->hr[i], dims, &padded))
+			retval = 1;
 	}
+	UNLOCK_HOSTLIST(set->hl);
 
 	hostlist_destroy(hl);
 
@@ -3687,21 +3920,22 @@ int hostset_intersects(hostset_t set, const char *hosts)
 
 int hostset_within(hostset_t set, const char *hosts)
 {
-	int nhosts, nfound;
+	int i, nhosts, nfound = 0;
+	int dims = slurmdb_setup_cluster_name_dims();
+	int padded = -1;
 	hostlist_t hl;
-	char *hostname;
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
 	if (!(hl = hostlist_create(hosts)))
 		return (0);
+	hostlist_uniq(hl);
 	nhosts = hostlist_count(hl);
-	nfound = 0;
 
-	while ((hostname = hostlist_pop(hl)) != NULL) {
-		nfound += hostset_find_host(set, hostname);
-		free(hostname);
-	}
+	LOCK_HOSTLIST(set->hl);
+	for (i = 0; i < hl->nranges; i++)
+		nfound += _hostset_range_cnt(set->hl, hl->hr[i], dims, &padded);
+	UNLOCK_HOSTLIST(set->hl);
 
 	hostlist_destroy(hl);
 
@@ -3710,12 +3944,40 @@ int hostset_within(hostset_t set, const char *hosts)
 
 int hostset_delete(hostset_t set, const char *hosts)
 {
-	return hostlist_delete(set->hl, hosts);
+	int i, n = 0;
+	int dims = slurmdb_setup_cluster_name_dims();
+	int padded = -1;
+	hostlist_t hl;
+
+	if (!(hl = hostlist_create(hosts)))
+		seterrno_ret(EINVAL, 0);
+	hostlist_uniq(hl);
+
+	LOCK_HOSTLIST(set->hl);
+	for (i = 0; i < hl->nranges; i++)
+		n += _hostset_delete_range(set->hl, hl->hr[i], dims,
+					       &padded);
+	UNLOCK_HOSTLIST(set->hl);
+
+	hostlist_destroy(hl);
+
+	return n;
 }
 
 int hostset_delete_host(hostset_t set, const char *hostname)
 {
-	return hostlist_delete_host(set->hl, hostname);
+	int i, dims = slurmdb_setup_cluster_name_dims();
+	unsigned long num;
+	hostname_t hn;
+
+	LOCK_HOSTLIST(set->hl);
+	hn = hostname_create_dims(hostname, dims);
+	if ((i = _hostset_find_range(set->hl, hn, dims, (dims == 1),
+				     &num)) >= 0)
+		_hostset_delete_num(set->hl, i, num);
+	UNLOCK_HOSTLIST(set->hl);
+	hostname_destroy(hn);
+	return (i >= 0) ? 1 : 0;
 }
 
 char *hostset_shift(hostset_t set)
@@ -3760,7 +4022,24 @@ char * hostset_nth(hostset_t set, int n)
 
 int hostset_find(hostset_t set, const char *hostname)
 {
-	return hostlist_find(set->hl, hostname);
+	int i, ret = -1, dims = slurmdb_setup_cluster_name_dims();
+	unsigned long num;
+	hostname_t hn;
+
+	if (!hostname || !set)
+		return -1;
+
+	LOCK_HOSTLIST(set->hl);
+	hn = hostname_create_dims(hostname, dims);
+	if ((i = _hostset_find_range(set->hl, hn, dims, (dims == 1),
+				     &num)) >= 0) {
+		ret = set->hl->hr[i]->singlehost ? 0 : num - set->hl->hr[i]->lo;
+		while (i-- > 0)
+			ret += hostrange_count(set->hl->hr[i]);
+	}
+	UNLOCK_HOSTLIST(set->hl);
+	hostname_destroy(hn);
+	return ret;
 }
 
 #if TEST_MAIN
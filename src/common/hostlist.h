@@ -105,6 +105,10 @@ extern char *alpha_num;
  * 2. is always sorted
  *    (Note: sort occurs first on alphanumeric prefix -- where prefix
  *     matches, numeric suffixes will be sorted *by value*)
+ *
+ * Since ranges are kept sorted, membership tests, insertion and deletion
+ * use a binary search and operate on whole ranges rather than on
+ * individual hosts, so prefer a hostset over a hostlist for large sets.
  */
 typedef struct hostset * hostset_t;
 
@@ -510,6 +514,12 @@ int hostset_insert(hostset_t set, const char *hosts);
  */
 int hostset_delete(hostset_t set, const char *hosts);
 
+/* hostset_delete_host():
+ * Delete a single host from hostset "set."
+ * Returns 1 if the host was found and deleted, 0 otherwise.
+ */
+int hostset_delete_host(hostset_t set, const char *hostname);
+
 /* hostset_intersects():
  * Return 1 if any of the hosts specified by "hosts" are within the hostset "set"
  * Return 0 if all host in "hosts" is not in the hostset "set"
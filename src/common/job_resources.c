@@ -1336,13 +1336,19 @@ extern int job_fits_into_cores(job_resources_t *job_resrcs_ptr,
 	     job_node_cnt > 0; full_node_inx++) {
 		if (bit_test(job_resrcs_ptr->node_bitmap, full_node_inx)) {
 			full_bit_inx = cr_node_cores_offset[full_node_inx];
-			for (i = 0; i < bits_per_node[full_node_inx]; i++) {
-				if (!bit_test(full_bitmap, full_bit_inx + i))
-					continue;
-				if ((job_resrcs_ptr->whole_node == 1) ||
-				    bit_test(job_resrcs_ptr->core_bitmap,
-					     job_bit_inx + i)) {
+			/* Skip nodes with no cores in use, a word at a time */
+			if (bit_set_count_range(full_bitmap, full_bit_inx,
+						full_bit_inx +
+						bits_per_node[full_node_inx])) {
+				if (job_resrcs_ptr->whole_node == 1)
 					return 0;
+				for (i = 0; i < bits_per_node[full_node_inx];
+				     i++) {
+					if (bit_test(full_bitmap,
+						     full_bit_inx + i) &&
+					    bit_test(job_resrcs_ptr->core_bitmap,
+						     job_bit_inx + i))
+						return 0;
 				}
 			}
 			job_bit_inx += bits_per_node[full_node_inx];
@@ -1382,12 +1388,19 @@ extern void add_job_to_cores(job_resources_t *job_resrcs_ptr,
 	     job_node_cnt > 0; full_node_inx++) {
 		if (bit_test(job_resrcs_ptr->node_bitmap, full_node_inx)) {
 			full_bit_inx = cr_node_cores_offset[full_node_inx];
-			for (i = 0; i < bits_per_node[full_node_inx]; i++) {
-				if ((job_resrcs_ptr->whole_node != 1) &&
-				    !bit_test(job_resrcs_ptr->core_bitmap,
-					      job_bit_inx + i))
-					continue;
-				bit_set(*full_core_bitmap, full_bit_inx + i);
+			if (job_resrcs_ptr->whole_node == 1) {
+				bit_nset(*full_core_bitmap, full_bit_inx,
+					 full_bit_inx +
+					 bits_per_node[full_node_inx] - 1);
+			} else {
+				for (i = 0; i < bits_per_node[full_node_inx];
+				     i++) {
+					if (bit_test(job_resrcs_ptr->
+						     core_bitmap,
+						     job_bit_inx + i))
+						bit_set(*full_core_bitmap,
+							full_bit_inx + i);
+				}
 			}
 			job_bit_inx += bits_per_node[full_node_inx];
 			job_node_cnt --;
@@ -1425,12 +1438,19 @@ extern void remove_job_from_cores(job_resources_t *job_resrcs_ptr,
 	     job_node_cnt > 0; full_node_inx++) {
 		if (bit_test(job_resrcs_ptr->node_bitmap, full_node_inx)) {
 			full_bit_inx = cr_node_cores_offset[full_node_inx];
-			for (i = 0; i < bits_per_node[full_node_inx]; i++) {
-				if ((job_resrcs_ptr->whole_node != 1) &&
-				    !bit_test(job_resrcs_ptr->core_bitmap,
-					      job_bit_inx + i))
-					continue;
-				bit_clear(*full_core_bitmap, full_bit_inx + i);
+			if (job_resrcs_ptr->whole_node == 1) {
+				bit_nclear(*full_core_bitmap, full_bit_inx,
+					   full_bit_inx +
+					   bits_per_node[full_node_inx] - 1);
+			} else {
+				for (i = 0; i < bits_per_node[full_node_inx];
+				     i++) {
+					if (bit_test(job_resrcs_ptr->
+						     core_bitmap,
+						     job_bit_inx + i))
+						bit_clear(*full_core_bitmap,
+							  full_bit_inx + i);
+				}
 			}
 			job_bit_inx += bits_per_node[full_node_inx];
 			job_node_cnt --;
@@ -0,0 +1,322 @@
+/*****************************************************************************\
+ *  lock_stats.c - hold and wait time of the slurmctld and assoc_mgr locks
+ *	by call site
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/lock_stats.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* Size of the call site table, sites beyond it are counted as dropped */
+#define LOCK_STATS_SITES	1024
+
+typedef struct {
+	const char *file;	/* NULL if the entry is unused */
+	const char *func;
+	int line;
+	lock_stats_family_t family;
+	uint32_t levels;	/* two bits per lock */
+	uint32_t count;
+	uint64_t wait_total;
+	uint32_t wait_max;
+	uint64_t hold_total;
+	uint32_t hold_max;
+} lock_site_t;
+
+/* Locks of one family held by a thread */
+typedef struct {
+	int depth;		/* nesting of lock calls */
+	int site;		/* index of the outermost call site or -1 */
+	struct timeval acquired;
+} lock_hold_t;
+
+static const int lock_cnt[LOCK_STATS_FAMILIES] = { 5, 7 };
+static const char *lock_names[LOCK_STATS_FAMILIES][7] = {
+	{ "config", "job", "node", "part", "fed" },
+	{ "assoc", "file", "qos", "res", "tres", "user", "wckey" }
+};
+
+bool lock_stats_enabled = false;
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static lock_site_t *sites = NULL;
+static uint32_t sites_dropped = 0;
+static uint32_t warn_usec = 0;
+
+static pthread_key_t hold_key;
+static pthread_once_t hold_once = PTHREAD_ONCE_INIT;
+
+static void _hold_free(void *hold)
+{
+	xfree(hold);
+}
+
+static void _hold_key_create(void)
+{
+	if (pthread_key_create(&hold_key, _hold_free))
+		fatal("%s: pthread_key_create: %m", __func__);
+}
+
+static lock_hold_t *_get_hold(lock_stats_family_t family)
+{
+	lock_hold_t *hold;
+	int i;
+
+	pthread_once(&hold_once, _hold_key_create);
+	if (!(hold = pthread_getspecific(hold_key))) {
+		hold = xmalloc(sizeof(lock_hold_t) * LOCK_STATS_FAMILIES);
+		for (i = 0; i < LOCK_STATS_FAMILIES; i++)
+			hold[i].site = -1;
+		pthread_setspecific(hold_key, hold);
+	}
+	return &hold[family];
+}
+
+static uint32_t _usec_diff(struct timeval *start, struct timeval *end)
+{
+	int64_t usec = (end->tv_sec - start->tv_sec) * 1000000 +
+		       (end->tv_usec - start->tv_usec);
+
+	if (usec < 0)
+		return 0;
+	if (usec > UINT32_MAX)
+		return UINT32_MAX;
+	return usec;
+}
+
+/* __FILE__ includes the path given to the compiler */
+static const char *_base_name(const char *file)
+{
+	const char *base = strrchr(file, '/');
+
+	return base ? (base + 1) : file;
+}
+
+/* Return the index of a call site, adding it if new. Call with stats_mutex
+ * locked. */
+static int _find_site(lock_stats_family_t family, uint32_t levels,
+		      const char *file, int line, const char *func)
+{
+	uint32_t hash, i;
+	lock_site_t *site;
+
+	hash = (((uintptr_t) file) >> 3) * 31 + line * 7 + levels + family;
+	for (i = 0; i < LOCK_STATS_SITES; i++) {
+		site = &sites[(hash + i) % LOCK_STATS_SITES];
+		if (!site->file) {
+			site->file = file;
+			site->func = func;
+			site->line = line;
+			site->family = family;
+			site->levels = levels;
+			return site - sites;
+		}
+		if ((site->file == file) && (site->line == line) &&
+		    (site->levels == levels) && (site->family == family))
+			return site - sites;
+	}
+	sites_dropped++;
+	return -1;
+}
+
+extern void lock_stats_config(bool enable, uint32_t warn)
+{
+	slurm_mutex_lock(&stats_mutex);
+	if (enable && !sites)
+		sites = xmalloc(sizeof(lock_site_t) * LOCK_STATS_SITES);
+	warn_usec = warn;
+	lock_stats_enabled = enable;
+	slurm_mutex_unlock(&stats_mutex);
+}
+
+extern void lock_stats_acquired(lock_stats_family_t family,
+				const lock_level_t *levels,
+				const char *file, int line, const char *func,
+				struct timeval *start)
+{
+	lock_hold_t *hold = _get_hold(family);
+	lock_site_t *site;
+	struct timeval now;
+	uint32_t code = 0, wait;
+	int i, inx;
+
+	gettimeofday(&now, NULL);
+	wait = _usec_diff(start, &now);
+	for (i = 0; i < lock_cnt[family]; i++)
+		code |= (levels[i] & 3) << (i * 2);
+
+	slurm_mutex_lock(&stats_mutex);
+	inx = sites ? _find_site(family, code, file, line, func) : -1;
+	if (inx >= 0) {
+		site = &sites[inx];
+		site->count++;
+		site->wait_total += wait;
+		site->wait_max = MAX(site->wait_max, wait);
+	}
+	slurm_mutex_unlock(&stats_mutex);
+
+	if (hold->depth++ == 0) {
+		hold->site = inx;
+		hold->acquired = now;
+	}
+}
+
+extern void lock_stats_released(lock_stats_family_t family)
+{
+	lock_hold_t *hold;
+	lock_site_t *site;
+	struct timeval now;
+	uint32_t usec, warn;
+
+	/* Called on every unlock, only look up threads that recorded locks */
+	pthread_once(&hold_once, _hold_key_create);
+	if (!(hold = pthread_getspecific(hold_key)))
+		return;
+	hold = &hold[family];
+
+	/* Locks taken before lock_stats_config() enabled recording */
+	if (hold->depth == 0)
+		return;
+	if ((--hold->depth > 0) || (hold->site < 0))
+		return;
+
+	gettimeofday(&now, NULL);
+	usec = _usec_diff(&hold->acquired, &now);
+	slurm_mutex_lock(&stats_mutex);
+	site = &sites[hold->site];
+	site->hold_total += usec;
+	site->hold_max = MAX(site->hold_max, usec);
+	warn = warn_usec;
+	slurm_mutex_unlock(&stats_mutex);
+	hold->site = -1;
+
+	if (warn && (usec > warn)) {
+		info("Warning: Note very large %s lock hold time of %u usec "
+		     "from %s at %s:%d",
+		     (family == LOCK_STATS_SLURMCTLD) ? "slurmctld" :
+		     "assoc_mgr", usec, site->func, _base_name(site->file),
+		     site->line);
+	}
+}
+
+static char *_levels_str(lock_site_t *site)
+{
+	char *str = NULL;
+	uint32_t level;
+	int i;
+
+	for (i = 0; i < lock_cnt[site->family]; i++) {
+		level = (site->levels >> (i * 2)) & 3;
+		if (level == NO_LOCK)
+			continue;
+		xstrfmtcat(str, "%s%s:%s", str ? " " : "",
+			   lock_names[site->family][i],
+			   level == WRITE_LOCK ? "W" : "R");
+	}
+	return str;
+}
+
+static int _cmp_hold(const void *a, const void *b)
+{
+	const lock_site_t *site_a = *(lock_site_t **) a;
+	const lock_site_t *site_b = *(lock_site_t **) b;
+
+	if (site_a->hold_total > site_b->hold_total)
+		return -1;
+	if (site_a->hold_total < site_b->hold_total)
+		return 1;
+	return 0;
+}
+
+extern void lock_stats_pack(Buf buffer)
+{
+	lock_site_t **sorted;
+	char *str;
+	uint32_t i, cnt = 0;
+
+	slurm_mutex_lock(&stats_mutex);
+	sorted = xmalloc(sizeof(lock_site_t *) * LOCK_STATS_SITES);
+	for (i = 0; sites && (i < LOCK_STATS_SITES); i++) {
+		if (sites[i].count)
+			sorted[cnt++] = &sites[i];
+	}
+	qsort(sorted, cnt, sizeof(lock_site_t *), _cmp_hold);
+
+	pack32(cnt, buffer);
+	for (i = 0; i < cnt; i++) {
+		str = xstrdup_printf("%s@%s:%d", sorted[i]->func,
+				     _base_name(sorted[i]->file),
+				     sorted[i]->line);
+		packstr(str, buffer);
+		xfree(str);
+		str = _levels_str(sorted[i]);
+		packstr(str, buffer);
+		xfree(str);
+		pack32(sorted[i]->count, buffer);
+		pack64(sorted[i]->wait_total, buffer);
+		pack32(sorted[i]->wait_max, buffer);
+		pack64(sorted[i]->hold_total, buffer);
+		pack32(sorted[i]->hold_max, buffer);
+	}
+	if (sites_dropped) {
+		debug("%s: %u lock calls from sites beyond the first %d "
+		      "not recorded", __func__, sites_dropped,
+		      LOCK_STATS_SITES);
+	}
+	slurm_mutex_unlock(&stats_mutex);
+	xfree(sorted);
+}
+
+extern void lock_stats_reset(void)
+{
+	int i;
+
+	/* Keep the call sites, threads holding locks refer to them */
+	slurm_mutex_lock(&stats_mutex);
+	for (i = 0; sites && (i < LOCK_STATS_SITES); i++) {
+		sites[i].count = 0;
+		sites[i].wait_total = 0;
+		sites[i].wait_max = 0;
+		sites[i].hold_total = 0;
+		sites[i].hold_max = 0;
+	}
+	sites_dropped = 0;
+	slurm_mutex_unlock(&stats_mutex);
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************\
+ *  lock_stats.h - hold and wait time of the slurmctld and assoc_mgr locks
+ *	by call site
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _LOCK_STATS_H
+#define _LOCK_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "src/common/pack.h"
+#include "src/slurmctld/locks.h"
+
+/* Sets of locks taken together, each is timed separately */
+typedef enum {
+	LOCK_STATS_SLURMCTLD,	/* lock_slurmctld() */
+	LOCK_STATS_ASSOC_MGR,	/* assoc_mgr_lock() */
+	LOCK_STATS_FAMILIES
+} lock_stats_family_t;
+
+/* Set if lock hold and wait times are being recorded */
+extern bool lock_stats_enabled;
+
+/*
+ * lock_stats_config - Start or stop recording lock hold and wait times
+ * IN enable - record the times of each call site
+ * IN warn_usec - log holds longer than this, 0 to never log
+ */
+extern void lock_stats_config(bool enable, uint32_t warn_usec);
+
+/*
+ * lock_stats_acquired - Record that the calling thread has been granted a
+ *	set of locks. Only call if lock_stats_enabled is set.
+ * IN family - the set of locks
+ * IN levels - level of each lock of the family, in lock order
+ * IN file, line, func - where the locks were requested
+ * IN start - when the locks were requested
+ */
+extern void lock_stats_acquired(lock_stats_family_t family,
+				const lock_level_t *levels,
+				const char *file, int line, const char *func,
+				struct timeval *start);
+
+/*
+ * lock_stats_released - Record that the calling thread has released the
+ *	locks of a family, logging the hold time if above the configured
+ *	threshold. Nested locks of the same family count toward the hold time
+ *	of the outermost ones. Call on every release, even with
+ *	lock_stats_enabled clear, so that locks recorded before recording was
+ *	disabled are released.
+ */
+extern void lock_stats_released(lock_stats_family_t family);
+
+/* lock_stats_pack - Pack the statistics of each call site, the sites holding
+ *	their locks longest first */
+extern void lock_stats_pack(Buf buffer);
+
+/* lock_stats_reset - Clear the statistics of all call sites */
+extern void lock_stats_reset(void);
+
+#endif
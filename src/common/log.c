@@ -66,6 +66,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "slurm/slurm_errno.h"
@@ -85,6 +86,9 @@
 
 #define NAMELEN 16
 
+/* Maximum number of queued messages written with one writev() call */
+#define LOG_ASYNC_IOV_MAX 256
+
 /*
 ** Define slurm-specific aliases for use by plugins, see slurm_xlator.h
 ** for details.
@@ -129,10 +133,33 @@ typedef struct {
 
 char *slurm_prog_name = NULL;
 
+/*
+** Ring of formatted log file messages waiting to be written by the async
+** log thread, see log_set_async()
+*/
+typedef struct {
+	pthread_cond_t cond;
+	uint32_t cnt;            /* messages queued                     */
+	uint64_t dropped;        /* messages discarded because of a full ring */
+	uint32_t dropped_unreported; /* dropped since last reported in log */
+	uint32_t head;           /* index of oldest message in msgs     */
+	char **msgs;
+	pthread_mutex_t mutex;
+	bool running;            /* thread is consuming the ring        */
+	bool shutdown;
+	uint32_t size;           /* number of slots in msgs             */
+	pthread_t thread_id;
+}	log_async_t;
+
 /* static variables */
 static pthread_mutex_t  log_lock = PTHREAD_MUTEX_INITIALIZER;
 static log_t            *log = NULL;
 static log_t            *sched_log = NULL;
+static uint32_t         logfp_gen = 0;   /* changes when log->logfp does */
+static log_async_t      log_async = {
+	.cond = PTHREAD_COND_INITIALIZER,
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
 
 #define LOG_INITIALIZED ((log != NULL) && (log->initialized))
 #define SCHED_LOG_INITIALIZED ((sched_log != NULL) && (sched_log->initialized))
@@ -150,9 +177,25 @@ extern char * program_invocation_name;
 /*
  * pthread_atfork handlers:
  */
-static void _atfork_prep()   { slurm_mutex_lock(&log_lock);   }
-static void _atfork_parent() { slurm_mutex_unlock(&log_lock); }
-static void _atfork_child()  { slurm_mutex_unlock(&log_lock); }
+static void _atfork_prep()
+{
+	slurm_mutex_lock(&log_lock);
+	slurm_mutex_lock(&log_async.mutex);
+}
+static void _atfork_parent()
+{
+	slurm_mutex_unlock(&log_async.mutex);
+	slurm_mutex_unlock(&log_lock);
+}
+static void _atfork_child()
+{
+	/* The async log thread does not exist in the child, the parent
+	 * writes out the messages queued so far */
+	log_async.running = false;
+	log_async.cnt = 0;
+	slurm_mutex_unlock(&log_async.mutex);
+	slurm_mutex_unlock(&log_lock);
+}
 static bool at_forked = false;
 #define atfork_install_handlers()					\
 	while (!at_forked) {						\
@@ -341,6 +384,7 @@ _log_init(char *prog, log_options_t opt, log_facility_t fac, char *logfile )
 			fclose(log->logfp); /* Ignore errors */
 
 		log->logfp = fp;
+		logfp_gen++;
 	}
 
 	if (log->logfp && (fileno(log->logfp) < 0))
@@ -459,6 +503,8 @@ void log_fini(void)
 	if (!log)
 		return;
 
+	log_set_async(0);
+
 	slurm_mutex_lock(&log_lock);
 	_log_flush(log);
 	xfree(log->argv0);
@@ -911,6 +957,231 @@ static void xlogfmtcat(char **dst, const char *fmt, ...)
 
 }
 
+/* Write all of iov to fd, retrying after partial writes */
+static void _log_writev(int fd, struct iovec *iov, int iovcnt)
+{
+	ssize_t rc;
+
+	while (iovcnt > 0) {
+		rc = writev(fd, iov, iovcnt);
+		if (rc < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			return;
+		}
+		while ((iovcnt > 0) && (rc >= iov->iov_len)) {
+			rc -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char *) iov->iov_base + rc;
+			iov->iov_len -= rc;
+		}
+	}
+}
+
+/* Write a batch of queued messages to fd and free them */
+static void _log_async_write(int fd, char **msgs, uint32_t cnt,
+			     uint32_t dropped)
+{
+	struct iovec iov[LOG_ASYNC_IOV_MAX];
+	char *drop_msg = NULL, time_str[64];
+	uint32_t i, n = 0;
+
+	for (i = 0; i < cnt; i++) {
+		iov[n].iov_base = msgs[i];
+		iov[n].iov_len = strlen(msgs[i]);
+		if ((++n == LOG_ASYNC_IOV_MAX) || (i == (cnt - 1))) {
+			if (fd >= 0)
+				_log_writev(fd, iov, n);
+			n = 0;
+		}
+	}
+	for (i = 0; i < cnt; i++)
+		xfree(msgs[i]);
+
+	if (dropped && (fd >= 0)) {
+		log_timestamp(time_str, sizeof(time_str));
+		xstrfmtcat(drop_msg, "[%s] error: log ring full, %u messages "
+			   "dropped\n", time_str, dropped);
+		iov[0].iov_base = drop_msg;
+		iov[0].iov_len = strlen(drop_msg);
+		_log_writev(fd, iov, 1);
+		xfree(drop_msg);
+	}
+}
+
+/*
+ * Move every queued message into *msgs (grown as needed).
+ * Call with log_async.mutex locked.
+ * RET number of messages moved
+ */
+static uint32_t _log_async_take(char ***msgs, uint32_t *msgs_size)
+{
+	uint32_t i, cnt = log_async.cnt;
+
+	if (*msgs_size < cnt) {
+		*msgs_size = log_async.size;
+		xrealloc(*msgs, sizeof(char *) * *msgs_size);
+	}
+	for (i = 0; i < cnt; i++) {
+		(*msgs)[i] = log_async.msgs[log_async.head];
+		log_async.head = (log_async.head + 1) % log_async.size;
+	}
+	log_async.cnt = 0;
+
+	return cnt;
+}
+
+static void *_log_async_thread(void *arg)
+{
+	char **msgs = NULL;
+	uint32_t cnt, dropped, msgs_size = 0, fd_gen = 0;
+	int fd = -1;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "log_async", NULL, NULL, NULL) < 0)
+		fprintf(stderr, "%s: cannot set my name: %m\n", __func__);
+#endif
+
+	slurm_mutex_lock(&log_async.mutex);
+	while (true) {
+		if (!log_async.cnt && !log_async.dropped_unreported) {
+			if (log_async.shutdown)
+				break;
+			slurm_cond_wait(&log_async.cond, &log_async.mutex);
+			continue;
+		}
+		cnt = _log_async_take(&msgs, &msgs_size);
+		dropped = log_async.dropped_unreported;
+		log_async.dropped_unreported = 0;
+		slurm_mutex_unlock(&log_async.mutex);
+
+		/* Write through our own descriptor so the file can be
+		 * written without holding log_lock */
+		slurm_mutex_lock(&log_lock);
+		if ((fd < 0) || (fd_gen != logfp_gen)) {
+			if (fd >= 0)
+				close(fd);
+			fd = -1;
+			if (log && log->logfp && (fileno(log->logfp) >= 0))
+				fd = dup(fileno(log->logfp));
+			fd_gen = logfp_gen;
+		}
+		slurm_mutex_unlock(&log_lock);
+
+		_log_async_write(fd, msgs, cnt, dropped);
+
+		slurm_mutex_lock(&log_async.mutex);
+	}
+	slurm_mutex_unlock(&log_async.mutex);
+
+	if (fd >= 0)
+		close(fd);
+	xfree(msgs);
+
+	return NULL;
+}
+
+/*
+ * Queue a formatted log file message for the async log thread, which takes
+ * ownership of msg.
+ * RET false if async logging is not active and msg must be written here
+ */
+static bool _log_async_queue(char *msg)
+{
+	slurm_mutex_lock(&log_async.mutex);
+	if (!log_async.running) {
+		slurm_mutex_unlock(&log_async.mutex);
+		return false;
+	}
+	if (log_async.cnt == log_async.size) {
+		log_async.dropped++;
+		log_async.dropped_unreported++;
+		xfree(msg);
+	} else {
+		log_async.msgs[(log_async.head + log_async.cnt) %
+			       log_async.size] = msg;
+		log_async.cnt++;
+	}
+	slurm_cond_signal(&log_async.cond);
+	slurm_mutex_unlock(&log_async.mutex);
+
+	return true;
+}
+
+/*
+ * Write out anything queued for the async log thread from the calling
+ * thread, used before messages that must reach the file immediately.
+ * Call with log_lock locked.
+ */
+static void _log_async_drain(void)
+{
+	char **msgs = NULL;
+	uint32_t cnt, dropped, msgs_size = 0;
+
+	slurm_mutex_lock(&log_async.mutex);
+	if (!log_async.running || !log_async.cnt) {
+		slurm_mutex_unlock(&log_async.mutex);
+		return;
+	}
+	cnt = _log_async_take(&msgs, &msgs_size);
+	dropped = log_async.dropped_unreported;
+	log_async.dropped_unreported = 0;
+	slurm_mutex_unlock(&log_async.mutex);
+
+	if (log->logfp)
+		_log_async_write(fileno(log->logfp), msgs, cnt, dropped);
+	else
+		_log_async_write(-1, msgs, cnt, dropped);
+	xfree(msgs);
+}
+
+extern void log_set_async(uint32_t ring_size)
+{
+	uint64_t dropped = 0;
+
+	slurm_mutex_lock(&log_async.mutex);
+	if (log_async.running && (log_async.size == ring_size)) {
+		slurm_mutex_unlock(&log_async.mutex);
+		return;
+	}
+
+	/* Stop the current thread, it writes out whatever is queued */
+	if (log_async.running) {
+		log_async.shutdown = true;
+		slurm_cond_signal(&log_async.cond);
+		slurm_mutex_unlock(&log_async.mutex);
+		pthread_join(log_async.thread_id, NULL);
+		slurm_mutex_lock(&log_async.mutex);
+		log_async.running = false;
+		log_async.shutdown = false;
+		xfree(log_async.msgs);
+		log_async.size = 0;
+		dropped = log_async.dropped;
+		log_async.dropped = 0;
+	}
+
+	if (ring_size) {
+		atfork_install_handlers();
+		xfree(log_async.msgs);	/* left over in a forked child */
+		log_async.msgs = xmalloc(sizeof(char *) * ring_size);
+		log_async.size = ring_size;
+		log_async.head = 0;
+		log_async.cnt = 0;
+		log_async.running = true;
+		slurm_thread_create(&log_async.thread_id, _log_async_thread,
+				    NULL);
+	}
+	slurm_mutex_unlock(&log_async.mutex);
+
+	if (dropped) {
+		info("Async log writer stopped, %"PRIu64" messages dropped "
+		     "because its ring was full", dropped);
+	}
+}
+
 static void
 _log_printf(log_t *log, cbuf_t cb, FILE *stream, const char *fmt, ...)
 {
@@ -1056,11 +1327,16 @@ static void log_msg(log_level_t level, const char *fmt, va_list args)
 
 	if ((level <= log->opt.logfile_level) && (log->logfp != NULL)) {
 
-		xlogfmtcat(&msgbuf, "[%M] %s%s%s", log->fpfx, pfx, buf);
-		_log_printf(log, log->fbuf, log->logfp, "%s\n", msgbuf);
-		fflush(log->logfp);
-
-		xfree(msgbuf);
+		xlogfmtcat(&msgbuf, "[%M] %s%s%s\n", log->fpfx, pfx, buf);
+		if ((level > LOG_LEVEL_FATAL) && _log_async_queue(msgbuf)) {
+			msgbuf = NULL;
+		} else {
+			/* Keep fatal messages after anything still queued */
+			_log_async_drain();
+			_log_printf(log, log->fbuf, log->logfp, "%s", msgbuf);
+			fflush(log->logfp);
+			xfree(msgbuf);
+		}
 	}
 
 	if (level <=  log->opt.syslog_level) {
@@ -46,6 +46,7 @@
 #ifndef _LOG_H
 #define _LOG_H
 
+#include <inttypes.h>
 #include <syslog.h>
 #include <stdio.h>
 
@@ -227,6 +228,16 @@ bool log_has_data(void);
  */
 void log_flush(void);
 
+/*
+ * log_set_async() hands log file messages to a background thread instead
+ * of writing them from the calling thread. Up to ring_size formatted
+ * messages are queued, further messages are dropped and counted until the
+ * thread catches up. Fatal messages are always written synchronously.
+ * A ring_size of 0 writes out the queue and reverts to synchronous writes.
+ * Stopping the thread logs the number of messages it dropped, if any.
+ */
+extern void log_set_async(uint32_t ring_size);
+
 /* log_set_debug_flags()
  * Set or reset the debug flags based on the configuration
  * file or the scontrol command.
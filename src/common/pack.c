@@ -42,6 +42,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -63,6 +64,7 @@
 strong_alias(create_buf,	slurm_create_buf);
 strong_alias(free_buf,		slurm_free_buf);
 strong_alias(grow_buf,		slurm_grow_buf);
+strong_alias(init_buf_chain,	slurm_init_buf_chain);
 strong_alias(init_buf,		slurm_init_buf);
 strong_alias(xfer_buf_data,	slurm_xfer_buf_data);
 strong_alias(pack_time,		slurm_pack_time);
@@ -93,8 +95,107 @@ strong_alias(unpackstr_xmalloc_chooser, slurm_unpackstr_xmalloc_chooser);
 strong_alias(packstr_array,	slurm_packstr_array);
 strong_alias(unpackstr_array,	slurm_unpackstr_array);
 strong_alias(packmem_array,	slurm_packmem_array);
+strong_alias(packmem_chain,	slurm_packmem_chain);
 strong_alias(unpackmem_array,	slurm_unpackmem_array);
 
+/*
+ * Pool of buffer memory. Buffers from BUF_SIZE up to the largest size class
+ * are sized to a power of two multiple of BUF_SIZE, and their memory is kept
+ * for reuse when they are freed rather than returned to malloc(), which
+ * would unmap large buffers and fault them in again for the next message.
+ * Pooled memory is not cleared. Each class keeps up to BUF_POOL_BYTES,
+ * with free blocks linked through their first bytes.
+ */
+#define BUF_POOL_CLASSES	9		/* BUF_SIZE to 4 MiB */
+#define BUF_POOL_BYTES		(2 * 1024 * 1024)
+
+static pthread_mutex_t buf_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *buf_pool[BUF_POOL_CLASSES];
+static int buf_pool_cnt[BUF_POOL_CLASSES];
+
+/* Return the smallest size class holding size bytes, or -1 if none does */
+static int _pool_class(uint64_t size)
+{
+	int class;
+
+	for (class = 0; class < BUF_POOL_CLASSES; class++) {
+		if (size <= ((uint64_t) BUF_SIZE << class))
+			return class;
+	}
+	return -1;
+}
+
+/*
+ * The pool is skipped rather than waited for while another thread holds
+ * its lock, which also keeps a child forked at that moment from hanging.
+ */
+static char *_pool_get(int class)
+{
+	char *head = NULL;
+
+	if (pthread_mutex_trylock(&buf_pool_lock))
+		return NULL;
+	if ((head = buf_pool[class])) {
+		buf_pool[class] = *(char **) head;
+		buf_pool_cnt[class]--;
+	}
+	slurm_mutex_unlock(&buf_pool_lock);
+
+	return head;
+}
+
+static void _pool_put(char *head)
+{
+	size_t size;
+	int class;
+
+	if (!head)
+		return;
+	size = xsize(head);
+	class = _pool_class(size);
+	if ((class < 0) || (size != (BUF_SIZE << class)) ||
+	    pthread_mutex_trylock(&buf_pool_lock)) {
+		xfree(head);
+		return;
+	}
+	if (buf_pool_cnt[class] < MAX(1, BUF_POOL_BYTES / size)) {
+		*(char **) head = buf_pool[class];
+		buf_pool[class] = head;
+		buf_pool_cnt[class]++;
+		head = NULL;
+	}
+	slurm_mutex_unlock(&buf_pool_lock);
+	xfree(head);
+}
+
+/*
+ * Make a buffer at least size bytes larger. Within the pool's size classes
+ * it grows to the next class, beyond them by at least half its size, so
+ * building a large message takes a number of reallocations logarithmic
+ * rather than linear in its size.
+ * RET SLURM_SUCCESS or SLURM_ERROR if the buffer would exceed MAX_BUF_SIZE
+ */
+static int _grow_buf(Buf buffer, uint32_t size, const char *caller)
+{
+	uint64_t new_size = (uint64_t) buffer->size + size;
+	int class;
+
+	if (new_size > MAX_BUF_SIZE) {
+		error("%s: Buffer size limit exceeded (%"PRIu64" > %u)",
+		      caller, new_size, MAX_BUF_SIZE);
+		return SLURM_ERROR;
+	}
+	if ((class = _pool_class(new_size)) >= 0)
+		new_size = (uint64_t) BUF_SIZE << class;
+	else
+		new_size = MIN(MAX(new_size, buffer->size + buffer->size / 2),
+			       MAX_BUF_SIZE);
+
+	buffer->size = new_size;
+	xrealloc_nz(buffer->head, buffer->size);
+	return SLURM_SUCCESS;
+}
+
 /* Basic buffer management routines */
 /* create_buf - create a buffer with the supplied contents, contents must
  * be xalloc'ed */
@@ -108,7 +209,7 @@ Buf create_buf(char *data, uint32_t size)
 		return NULL;
 	}
 
-	my_buf = xmalloc_nz(sizeof(struct slurm_buf));
+	my_buf = xmalloc(sizeof(struct slurm_buf));
 	my_buf->magic = BUF_MAGIC;
 	my_buf->size = size;
 	my_buf->processed = 0;
@@ -123,7 +224,9 @@ void free_buf(Buf my_buf)
 	if (!my_buf)
 		return;
 	assert(my_buf->magic == BUF_MAGIC);
-	xfree(my_buf->head);
+	xarena_destroy(my_buf->arena);
+	xfree(my_buf->segs);
+	_pool_put(my_buf->head);
 	xfree(my_buf);
 }
 
@@ -144,6 +247,7 @@ void grow_buf (Buf buffer, uint32_t size)
 Buf init_buf(uint32_t size)
 {
 	Buf my_buf;
+	int class;
 
 	if (size > MAX_BUF_SIZE) {
 		error("%s: Buffer size limit exceeded (%u > %u)",
@@ -152,11 +256,28 @@ Buf init_buf(uint32_t size)
 	}
 	if (size <= 0)
 		size = BUF_SIZE;
-	my_buf = xmalloc_nz(sizeof(struct slurm_buf));
+	my_buf = xmalloc(sizeof(struct slurm_buf));
 	my_buf->magic = BUF_MAGIC;
-	my_buf->size = size;
 	my_buf->processed = 0;
-	my_buf->head = xmalloc(sizeof(char)*size);
+	if ((size >= BUF_SIZE) && ((class = _pool_class(size)) >= 0)) {
+		size = BUF_SIZE << class;
+		my_buf->head = _pool_get(class);
+	}
+	if (!my_buf->head)
+		my_buf->head = xmalloc(sizeof(char)*size);
+	my_buf->size = size;
+	return my_buf;
+}
+
+/* init_buf_chain - create an empty buffer of the given size, to which
+ * packmem_chain() adds references rather than copies of large data. Such a
+ * buffer can only be sent with slurm_msg_sendto_buf(). */
+Buf init_buf_chain(uint32_t size)
+{
+	Buf my_buf = init_buf(size);
+
+	if (my_buf)
+		my_buf->chain = true;
 	return my_buf;
 }
 
@@ -168,6 +289,8 @@ void *xfer_buf_data(Buf my_buf)
 
 	assert(my_buf->magic == BUF_MAGIC);
 	data_ptr = (void *) my_buf->head;
+	xarena_destroy(my_buf->arena);
+	xfree(my_buf->segs);
 	xfree(my_buf);
 	return data_ptr;
 }
@@ -181,14 +304,8 @@ void pack_time(time_t val, Buf buffer)
 	int64_t n64 = HTON_int64((int64_t) val);
 
 	if (remaining_buf(buffer) < sizeof(n64)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &n64, sizeof(n64));
@@ -228,14 +345,8 @@ void 	packdouble(double val, Buf buffer)
 	uval.d =  (val * FLOAT_MULT);
 	nl =  HTON_uint64(uval.u);
 	if (remaining_buf(buffer) < sizeof(nl)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
@@ -309,14 +420,8 @@ void pack64(uint64_t val, Buf buffer)
 	uint64_t nl =  HTON_uint64(val);
 
 	if (remaining_buf(buffer) < sizeof(nl)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
@@ -348,14 +453,8 @@ void pack32(uint32_t val, Buf buffer)
 	uint32_t nl = htonl(val);
 
 	if (remaining_buf(buffer) < sizeof(nl)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
@@ -403,7 +502,7 @@ int unpack16_array(uint16_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > NO_VAL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint16_t));
+	*valp = buf_xmalloc_nz(buffer, (*size_val) * sizeof(uint16_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack16((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -436,7 +535,7 @@ int unpack32_array(uint32_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > NO_VAL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint32_t));
+	*valp = buf_xmalloc_nz(buffer, (*size_val) * sizeof(uint32_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack32((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -484,7 +583,7 @@ int unpack64_array(uint64_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > NO_VAL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint64_t));
+	*valp = buf_xmalloc_nz(buffer, (*size_val) * sizeof(uint64_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack64((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -503,7 +602,7 @@ int unpack64_array_from_32(uint64_t ** valp, uint32_t * size_val, Buf buffer)
 	if ((*size_val) > NO_VAL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(uint64_t));
+	*valp = buf_xmalloc_nz(buffer, (*size_val) * sizeof(uint64_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack32(&val32, buffer))
 			return SLURM_ERROR;
@@ -534,7 +633,7 @@ int unpackdouble_array(double **valp, uint32_t* size_val, Buf buffer)
 	if ((*size_val) > NO_VAL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(double));
+	*valp = buf_xmalloc_nz(buffer, (*size_val) * sizeof(double));
 	for (i = 0; i < *size_val; i++) {
 		if (unpackdouble((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -564,7 +663,8 @@ int unpacklongdouble_array(long double **valp, uint32_t* size_val, Buf buffer)
 	if ((*size_val) > NO_VAL)
 		return SLURM_ERROR;
 
-	*valp = xmalloc_nz((*size_val) * sizeof(long double));
+	*valp = buf_xmalloc_nz(buffer,
+				(*size_val) * sizeof(long double));
 	for (i = 0; i < *size_val; i++) {
 		if (unpacklongdouble((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -583,14 +683,8 @@ void pack16(uint16_t val, Buf buffer)
 	uint16_t ns = htons(val);
 
 	if (remaining_buf(buffer) < sizeof(ns)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
@@ -621,14 +715,8 @@ int unpack16(uint16_t * valp, Buf buffer)
 void pack8(uint8_t val, Buf buffer)
 {
 	if (remaining_buf(buffer) < sizeof(uint8_t)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &val, sizeof(uint8_t));
@@ -664,14 +752,8 @@ void packmem(char *valp, uint32_t size_val, Buf buffer)
 		return;
 	}
 	if (remaining_buf(buffer) < (sizeof(ns) + size_val)) {
-		if ((buffer->size + size_val + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + size_val + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, size_val + BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
@@ -781,7 +863,7 @@ int unpackmem_xmalloc(char **valp, uint32_t * size_valp, Buf buffer)
 	else if (*size_valp > 0) {
 		if (remaining_buf(buffer) < *size_valp)
 			return SLURM_ERROR;
-		*valp = xmalloc_nz(*size_valp);
+		*valp = buf_xmalloc_nz(buffer, *size_valp);
 		memcpy(*valp, &buffer->head[buffer->processed],
 		       *size_valp);
 		buffer->processed += *size_valp;
@@ -866,7 +948,7 @@ int unpackstr_xmalloc_escaped(char **valp, uint32_t *size_valp, Buf buffer)
 			return SLURM_ERROR;
 
 		/* make a buffer 2 times the size just to be safe */
-		*valp = xmalloc_nz((cnt * 2) + 1);
+		*valp = buf_xmalloc_nz(buffer, (cnt * 2) + 1);
 		if (*valp) {
 			char *copy = NULL, *str, tmp;
 			uint32_t i;
@@ -914,14 +996,8 @@ void packstr_array(char **valp, uint32_t size_val, Buf buffer)
 	uint32_t ns = htonl(size_val);
 
 	if (remaining_buf(buffer) < sizeof(ns)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
@@ -960,7 +1036,8 @@ int unpackstr_array(char ***valp, uint32_t * size_valp, Buf buffer)
 		return SLURM_ERROR;
 	}
 	else if (*size_valp > 0) {
-		*valp = xmalloc_nz(sizeof(char *) * (*size_valp + 1));
+		*valp = buf_xmalloc_nz(buffer,
+				       sizeof(char *) * (*size_valp + 1));
 		for (i = 0; i < *size_valp; i++) {
 			if (unpackmem_xmalloc(&(*valp)[i], &uint32_tmp, buffer))
 				return SLURM_ERROR;
@@ -979,20 +1056,42 @@ int unpackstr_array(char ***valp, uint32_t * size_valp, Buf buffer)
 void packmem_array(char *valp, uint32_t size_val, Buf buffer)
 {
 	if (remaining_buf(buffer) < size_val) {
-		if ((buffer->size + size_val + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + size_val + BUF_SIZE),
-			      MAX_BUF_SIZE);
+		if (_grow_buf(buffer, size_val + BUF_SIZE, __func__))
 			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc_nz(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], valp, size_val);
 	buffer->processed += size_val;
 }
 
+/*
+ * Like packmem_array(), but a buffer created with init_buf_chain() only
+ * references large data, which must then remain unchanged until the buffer
+ * is sent.
+ */
+void packmem_chain(char *valp, uint32_t size_val, Buf buffer)
+{
+	buf_seg_t *seg;
+
+	if (!buffer->chain || (size_val < BUF_SIZE)) {
+		packmem_array(valp, size_val, buffer);
+		return;
+	}
+	if (((uint64_t) get_buf_length(buffer) + size_val) > MAX_BUF_SIZE) {
+		error("%s: Buffer size limit exceeded (%"PRIu64" > %u)",
+		      __func__, (uint64_t) get_buf_length(buffer) + size_val,
+		      MAX_BUF_SIZE);
+		return;
+	}
+
+	xrealloc(buffer->segs, sizeof(buf_seg_t) * (buffer->seg_cnt + 1));
+	seg = &buffer->segs[buffer->seg_cnt++];
+	seg->offset = buffer->processed;
+	seg->size = size_val;
+	seg->data = valp;
+	buffer->seg_size += size_val;
+}
+
 /*
  * Given a pointer to memory (valp), size (size_val), and buffer,
  * store the buffer contents into memory
@@ -1008,3 +1107,61 @@ int unpackmem_array(char *valp, uint32_t size_valp, Buf buffer)
 		return SLURM_ERROR;
 	}
 }
+
+#define REC_INDEX_MAGIC 0x1d3c5e7f
+
+/*
+ * Append an index of the records packed so far to a message, so that a
+ * receiver can unpack the records in parallel. offsets are relative to the
+ * start of the first record. The index is the last thing in the message:
+ *	uint32_t offsets[rec_cnt], uint32_t rec_cnt, uint32_t REC_INDEX_MAGIC
+ */
+void pack_rec_index(uint32_t *offsets, uint32_t rec_cnt, Buf buffer)
+{
+	uint32_t i;
+
+	for (i = 0; i < rec_cnt; i++)
+		pack32(offsets[i], buffer);
+	pack32(rec_cnt, buffer);
+	pack32(REC_INDEX_MAGIC, buffer);
+}
+
+/*
+ * Read the index appended by pack_rec_index(), if any. The buffer offset
+ * must be at the start of the first record and is not changed.
+ * RET array of rec_cnt + 1 offsets relative to the buffer offset, the last
+ *	being the end of the records, or NULL if there is no valid index.
+ *	Must be xfreed.
+ */
+uint32_t *unpack_rec_index(uint32_t rec_cnt, Buf buffer)
+{
+	uint32_t *offsets = NULL;
+	uint32_t i, index_size, cnt = 0, magic = 0, start;
+
+	start = get_buf_offset(buffer);
+	index_size = (rec_cnt + 2) * sizeof(uint32_t);
+	if ((rec_cnt >= NO_VAL / sizeof(uint32_t)) ||
+	    (remaining_buf(buffer) < index_size))
+		return NULL;
+
+	set_buf_offset(buffer, size_buf(buffer) - 2 * sizeof(uint32_t));
+	if (unpack32(&cnt, buffer) || unpack32(&magic, buffer) ||
+	    (cnt != rec_cnt) || (magic != REC_INDEX_MAGIC))
+		goto fini;
+
+	offsets = xmalloc(sizeof(uint32_t) * (rec_cnt + 1));
+	set_buf_offset(buffer, size_buf(buffer) - index_size);
+	offsets[rec_cnt] = size_buf(buffer) - index_size - start;
+	for (i = 0; i < rec_cnt; i++) {
+		if (unpack32(&offsets[i], buffer) ||
+		    (offsets[i] > offsets[rec_cnt]) ||
+		    (i ? (offsets[i] < offsets[i - 1]) : (offsets[i] != 0))) {
+			xfree(offsets);
+			goto fini;
+		}
+	}
+
+fini:
+	set_buf_offset(buffer, start);
+	return offsets;
+}
@@ -43,6 +43,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <time.h>
 #include <string.h>
 
@@ -59,11 +60,23 @@
 #define MAX_PACK_ARRAY_LEN	(128 * 1024)
 #define MAX_PACK_MEM_LEN	(1024 * 1024 * 1024)
 
+/* Data sent after the first offset bytes of a chained buffer's head */
+typedef struct {
+	uint32_t offset;
+	uint32_t size;
+	char *data;
+} buf_seg_t;
+
 struct slurm_buf {
 	uint32_t magic;
 	char *head;
 	uint32_t size;
 	uint32_t processed;
+	struct xarena *arena;	/* memory for unpacked data, may be NULL */
+	bool chain;		/* packmem_chain() may reference its data */
+	uint32_t seg_cnt;	/* data segments referenced by a chain */
+	uint32_t seg_size;	/* total size of those segments */
+	buf_seg_t *segs;
 };
 
 typedef struct slurm_buf * Buf;
@@ -73,10 +86,19 @@ typedef struct slurm_buf * Buf;
 #define set_buf_offset(__buf,__val)	(__buf->processed = __val)
 #define remaining_buf(__buf)		(__buf->size - __buf->processed)
 #define size_buf(__buf)			(__buf->size)
+/* bytes packed, including the segments of a chained buffer */
+#define get_buf_length(__buf)		(__buf->processed + __buf->seg_size)
+
+/* Allocate memory for unpacked data, from the buffer's arena if it has one.
+ * The data is then released along with the buffer by free_buf().
+ * These need src/common/xmalloc.h. */
+#define buf_xmalloc(__buf, __sz)	xarena_alloc((__buf)->arena, __sz)
+#define buf_xmalloc_nz(__buf, __sz)	xarena_alloc_nz((__buf)->arena, __sz)
 
 Buf	create_buf (char *data, uint32_t size);
 void	free_buf(Buf my_buf);
 Buf	init_buf(uint32_t size);
+Buf	init_buf_chain(uint32_t size);
 void    grow_buf (Buf my_buf, uint32_t size);
 void	*xfer_buf_data(Buf my_buf);
 
@@ -133,8 +155,12 @@ void	packstr_array(char **valp, uint32_t size_val, Buf buffer);
 int	unpackstr_array(char ***valp, uint32_t* size_val, Buf buffer);
 
 void	packmem_array(char *valp, uint32_t size_val, Buf buffer);
+void	packmem_chain(char *valp, uint32_t size_val, Buf buffer);
 int	unpackmem_array(char *valp, uint32_t size_valp, Buf buffer);
 
+void	pack_rec_index(uint32_t *offsets, uint32_t rec_cnt, Buf buffer);
+uint32_t *unpack_rec_index(uint32_t rec_cnt, Buf buffer);
+
 #define safe_unpack_time(valp,buf) do {			\
 	assert(sizeof(*valp) == sizeof(time_t));	\
 	assert(buf->magic == BUF_MAGIC);		\
@@ -544,6 +544,22 @@ slurm_cred_ctx_key_update(slurm_cred_ctx_t ctx, const char *path)
 slurm_cred_t *
 slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 		  uint16_t protocol_version)
+{
+	slurm_cred_t *cred;
+
+	if (!(cred = slurm_cred_create_unsigned(ctx, arg)))
+		return NULL;
+
+	if (slurm_cred_sign(ctx, cred, protocol_version) < 0) {
+		slurm_cred_destroy(cred);
+		return NULL;
+	}
+
+	return cred;
+}
+
+slurm_cred_t *
+slurm_cred_create_unsigned(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg)
 {
 	slurm_cred_t *cred = NULL;
 
@@ -608,23 +624,30 @@ slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 	}
 #endif
 	cred->ctime  = time(NULL);
+	slurm_mutex_unlock(&cred->mutex);
+
+	return cred;
+}
+
+int
+slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+		uint16_t protocol_version)
+{
+	int rc;
+
+	xassert(ctx != NULL);
+	xassert(cred != NULL);
 
+	slurm_mutex_lock(&cred->mutex);
+	xassert(cred->magic == CRED_MAGIC);
 	slurm_mutex_lock(&ctx->mutex);
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 	xassert(ctx->type == SLURM_CRED_CREATOR);
-	if (_slurm_cred_sign(ctx, cred, protocol_version) < 0)
-		goto fail;
-
+	rc = _slurm_cred_sign(ctx, cred, protocol_version);
 	slurm_mutex_unlock(&ctx->mutex);
 	slurm_mutex_unlock(&cred->mutex);
 
-	return cred;
-
-fail:
-	slurm_mutex_unlock(&ctx->mutex);
-	slurm_mutex_unlock(&cred->mutex);
-	slurm_cred_destroy(cred);
-	return NULL;
+	return rc;
 }
 
 slurm_cred_t *
@@ -189,6 +189,25 @@ int slurm_crypto_fini(void);
 slurm_cred_t *slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 				uint16_t protocol_version);
 
+/*
+ * Create a slurm credential as slurm_cred_create() does, but do not sign
+ * it. Since the values of `arg' are copied, locks protecting them can be
+ * released before the credential is signed with slurm_cred_sign().
+ *
+ * Returns NULL on failure.
+ */
+slurm_cred_t *slurm_cred_create_unsigned(slurm_cred_ctx_t ctx,
+					 slurm_cred_arg_t *arg);
+
+/*
+ * Sign a credential created by slurm_cred_create_unsigned() using the
+ * creators private key.
+ *
+ * Returns SLURM_SUCCESS or SLURM_ERROR.
+ */
+int slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+		    uint16_t protocol_version);
+
 /*
  * Copy a slurm credential.
  * Returns NULL on failure.
@@ -943,7 +943,8 @@ extern int jobacctinfo_unpack(jobacctinfo_t **jobacct,
 		if (uint8_tmp == (uint8_t) 0)
 			return SLURM_SUCCESS;
 		if (alloc)
-			*jobacct = xmalloc(sizeof(struct jobacctinfo));
+			*jobacct = buf_xmalloc(buffer,
+					       sizeof(struct jobacctinfo));
 		safe_unpack32(&uint32_tmp, buffer);
 		(*jobacct)->user_cpu_sec = uint32_tmp;
 		safe_unpack32(&uint32_tmp, buffer);
@@ -3146,6 +3146,12 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
+	bool use_arena = false;
+
+	/* The arena is released with the buffer, so it must be kept */
+	if ((msg->flags & SLURM_MSG_UNPACK_ARENA) &&
+	    (msg->flags & SLURM_MSG_KEEP_BUFFER))
+		use_arena = true;
 
 	if (unpack_header(&header, buffer) == SLURM_ERROR) {
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
@@ -3218,6 +3224,9 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 
 	msg->body_offset =  get_buf_offset(buffer);
 
+	if (use_arena && !buffer->arena && unpack_msg_arena_ok(msg->msg_type))
+		buffer->arena = xarena_create();
+
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(msg, buffer) != SLURM_SUCCESS)) {
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
@@ -3770,9 +3779,9 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 {
 	unsigned int tmplen, msglen;
 
-	tmplen = get_buf_offset(buffer);
+	tmplen = get_buf_length(buffer);
 	pack_msg(msg, buffer);
-	msglen = get_buf_offset(buffer) - tmplen;
+	msglen = get_buf_length(buffer) - tmplen;
 
 	/* update header with correct cred and msg lengths */
 	update_header(hdr, msglen);
@@ -3874,9 +3883,11 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	init_header(&header, msg, msg->flags);
 
 	/*
-	 * Pack header into buffer for transmission
+	 * Pack header into buffer for transmission. Responses which are
+	 * already packed, like job information, are sent from msg->data
+	 * rather than copied into the buffer.
 	 */
-	buffer = init_buf(BUF_SIZE);
+	buffer = init_buf_chain(BUF_SIZE);
 	pack_header(&header, buffer);
 
 	/*
@@ -3902,9 +3913,8 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	/*
 	 * Send message
 	 */
-	rc = slurm_msg_sendto( fd, get_buf_data(buffer),
-			       get_buf_offset(buffer),
-			       SLURM_PROTOCOL_NO_SEND_RECV_FLAGS );
+	rc = slurm_msg_sendto_buf(fd, buffer,
+				  SLURM_PROTOCOL_NO_SEND_RECV_FLAGS);
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		debug3("slurm_msg_sendto: peer has disappeared for msg_type=%u",
@@ -4232,7 +4242,11 @@ extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 			       slurm_msg_t *resp, int timeout)
 {
 	int rc = -1;
+	/* SLURM_MSG_KEEP_BUFFER of the request applies to the response */
+	uint16_t keep_buffer = req->flags & SLURM_MSG_KEEP_BUFFER;
+
 	slurm_msg_t_init(resp);
+	resp->flags |= keep_buffer;
 
 	/* If we are using a persistent connection make sure it is the one we
 	 * actually want.  This should be the correct one already, but just make
@@ -4243,6 +4257,7 @@ extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 		resp->conn = req->conn;
 	}
 
+	req->flags &= (~SLURM_MSG_KEEP_BUFFER);
 	if (slurm_send_node_msg(fd, req) >= 0) {
 		/* no need to adjust and timeouts here since we are not
 		   forwarding or expecting anything other than 1 message
@@ -4250,6 +4265,7 @@ extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 		   slurm_receive_msg if it is 0 */
 		rc = slurm_receive_msg(fd, resp, timeout);
 	}
+	req->flags |= keep_buffer;
 
 	return rc;
 }
@@ -4849,8 +4865,9 @@ extern void slurm_free_msg_members(slurm_msg_t *msg)
 	if (msg) {
 		if (msg->auth_cred)
 			(void) g_slurm_auth_destroy(msg->auth_cred);
-		free_buf(msg->buffer);
+		/* Data may be allocated from the buffer's arena */
 		slurm_free_msg_data(msg->msg_type, msg->data);
+		free_buf(msg->buffer);
 		FREE_NULL_LIST(msg->ret_list);
 	}
 }
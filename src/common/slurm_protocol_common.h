@@ -107,6 +107,7 @@
 #define SLURMDBD_CONNECTION     0x0002
 #define SLURM_MSG_KEEP_BUFFER   0x0004
 #define SLURM_DROP_PRIV		0x0008
+#define SLURM_MSG_UNPACK_ARENA	0x0010	/* local, see unpack_msg_arena_ok() */
 
 #include "src/common/slurm_protocol_socket_common.h"
 
@@ -1494,6 +1494,8 @@ extern void slurm_free_suspend_int_msg(suspend_int_msg_t *msg)
 
 extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 {
+	int i;
+
 	if (msg) {
 		xfree(msg->rpc_type_id);
 		xfree(msg->rpc_type_cnt);
@@ -1501,6 +1503,12 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 		xfree(msg->rpc_user_id);
 		xfree(msg->rpc_user_cnt);
 		xfree(msg->rpc_user_time);
+		xfree(msg->rpc_latency);
+		for (i = 0; i < msg->lock_site_size; i++) {
+			xfree(msg->lock_site[i].site);
+			xfree(msg->lock_site[i].locks);
+		}
+		xfree(msg->lock_site);
 		xfree(msg);
 	}
 }
@@ -3489,6 +3497,8 @@ extern void slurm_free_slurmd_status(slurmd_status_t* slurmd_status_ptr)
 		xfree(slurmd_status_ptr->slurmd_logfile);
 		xfree(slurmd_status_ptr->step_list);
 		xfree(slurmd_status_ptr->version);
+		xfree(slurmd_status_ptr->launch_hist_pooled);
+		xfree(slurmd_status_ptr->launch_hist_forked);
 		xfree(slurmd_status_ptr);
 	}
 }
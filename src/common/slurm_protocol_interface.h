@@ -48,6 +48,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
@@ -107,6 +108,16 @@ extern ssize_t slurm_msg_sendto_timeout(int open_fd,
 					uint32_t flags,
 					int timeout);
 
+/* slurm_msg_sendto_buf
+ * Send the data packed in a buffer over the given connection, with the
+ * segments of a chained buffer sent in place, default timeout value
+ * IN open_fd - an open file descriptor
+ * IN buffer - data to transmit, get_buf_length() bytes
+ * IN flags - communication specific flags
+ * RET number of bytes written
+ */
+extern ssize_t slurm_msg_sendto_buf(int open_fd, Buf buffer, uint32_t flags);
+
 /********************/
 /* stream functions */
 /********************/
@@ -144,6 +155,8 @@ extern int slurm_get_stream_addr(int open_fd, slurm_addr_t *address);
 
 extern int slurm_send_timeout(int open_fd, char *buffer, size_t size,
 			      uint32_t flags, int timeout);
+extern int slurm_sendv_timeout(int open_fd, struct iovec *iov, int iovcnt,
+			       uint32_t flags, int timeout);
 extern int slurm_recv_timeout(int open_fd, char *buffer, size_t size,
 			      uint32_t flags, int timeout);
 
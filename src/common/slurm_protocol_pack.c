@@ -39,9 +39,11 @@
 \*****************************************************************************/
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "src/common/assoc_mgr.h"
 #include "src/common/bitstring.h"
@@ -79,6 +81,25 @@
 #define _pack_layout_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
 #define _pack_assoc_mgr_info_msg(msg,buf)      _pack_buffer_msg(msg,buf)
 
+/* Records per thread when unpacking a message with a record index */
+#define UNPACK_RECS_PER_THREAD	2000
+#define UNPACK_MAX_THREADS	8
+
+typedef int (*unpack_rec_func_t) (void *rec, Buf buffer,
+				  uint16_t protocol_version);
+
+typedef struct {
+	char *array;			/* records to unpack into */
+	size_t rec_size;
+	uint32_t first;			/* unpack records [first, last) */
+	uint32_t last;
+	char *data;			/* start of the first packed record */
+	uint32_t *offsets;		/* from pack_rec_index() */
+	unpack_rec_func_t unpack;
+	uint16_t protocol_version;
+	int rc;
+} unpack_recs_args_t;
+
 static void _pack_assoc_shares_object(void *in, uint32_t tres_cnt, Buf buffer,
 				      uint16_t protocol_version);
 static int _unpack_assoc_shares_object(void **object, uint32_t tres_cnt,
@@ -692,6 +713,7 @@ static void _pack_stats_request_msg(stats_info_request_msg_t *msg, Buf buffer,
 				    uint16_t protocol_version);
 static int  _unpack_stats_request_msg(stats_info_request_msg_t **msg_ptr,
 				      Buf buffer, uint16_t protocol_version);
+static int _unpack_lock_stats(stats_info_response_msg_t *msg, Buf buffer);
 static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				       Buf buffer, uint16_t protocol_version);
 
@@ -1563,6 +1585,26 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	return SLURM_SUCCESS;
 }
 
+/* unpack_msg_arena_ok
+ * tells whether the body of a message may be unpacked into the arena of its
+ * buffer. This is only the case for messages that slurmctld reads and
+ * releases without keeping any part of the unpacked data.
+ * IN msg_type - type of the message
+ * RET true if an arena may be used
+ */
+extern bool unpack_msg_arena_ok(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+	case REQUEST_COMPLETE_PROLOG:
+	case REQUEST_STEP_COMPLETE:
+	case MESSAGE_EPILOG_COMPLETE:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /* unpack_msg
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
@@ -4014,11 +4056,94 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void *_unpack_recs_thread(void *arg)
+{
+	unpack_recs_args_t *args = (unpack_recs_args_t *) arg;
+	uint32_t i, start = args->offsets[args->first];
+	Buf buffer;
+
+	/* A view of this thread's records, which must not free them */
+	buffer = create_buf(args->data + start,
+			    args->offsets[args->last] - start);
+	args->rc = SLURM_SUCCESS;
+	for (i = args->first; i < args->last; i++) {
+		if ((*args->unpack)(args->array + (i * args->rec_size), buffer,
+				    args->protocol_version) ||
+		    (get_buf_offset(buffer) != (args->offsets[i + 1] - start))) {
+			args->rc = SLURM_ERROR;
+			break;
+		}
+	}
+	buffer->head = NULL;
+	free_buf(buffer);
+
+	return NULL;
+}
+
+/*
+ * Unpack rec_cnt records of rec_size bytes each into array. If the sender
+ * appended a record index (see pack_rec_index()) and there are enough
+ * records, they are unpacked on several threads.
+ */
+static int _unpack_records(void *array, size_t rec_size, uint32_t rec_cnt,
+			   unpack_rec_func_t unpack, Buf buffer,
+			   uint16_t protocol_version)
+{
+	static int max_threads = -1;
+	unpack_recs_args_t args[UNPACK_MAX_THREADS];
+	pthread_t tids[UNPACK_MAX_THREADS];
+	uint32_t *offsets, i;
+	int rc = SLURM_SUCCESS, threads = 1;
+
+	offsets = unpack_rec_index(rec_cnt, buffer);
+	if (offsets) {
+		if (max_threads < 0) {
+			long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+			max_threads = MIN(MAX(cpus, 1), UNPACK_MAX_THREADS);
+		}
+		threads = MIN(max_threads, rec_cnt / UNPACK_RECS_PER_THREAD);
+	}
+
+	if (threads <= 1) {
+		for (i = 0; i < rec_cnt; i++) {
+			if ((*unpack)((char *) array + (i * rec_size), buffer,
+				      protocol_version)) {
+				rc = SLURM_ERROR;
+				break;
+			}
+		}
+		goto fini;
+	}
+
+	for (i = 0; i < threads; i++) {
+		args[i].array = array;
+		args[i].rec_size = rec_size;
+		args[i].first = ((uint64_t) rec_cnt * i) / threads;
+		args[i].last = ((uint64_t) rec_cnt * (i + 1)) / threads;
+		args[i].data = get_buf_data(buffer) + get_buf_offset(buffer);
+		args[i].offsets = offsets;
+		args[i].unpack = unpack;
+		args[i].protocol_version = protocol_version;
+		slurm_thread_create(&tids[i], _unpack_recs_thread, &args[i]);
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(tids[i], NULL);
+		if (args[i].rc != SLURM_SUCCESS)
+			rc = SLURM_ERROR;
+	}
+
+fini:
+	/* Skip over the record index */
+	if (offsets && (rc == SLURM_SUCCESS))
+		set_buf_offset(buffer, size_buf(buffer));
+	xfree(offsets);
+	return rc;
+}
+
 static int
 _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
 		      uint16_t protocol_version)
 {
-	int i;
 	node_info_t *node = NULL;
 
 	xassert(msg != NULL);
@@ -4033,12 +4158,12 @@ _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
 		node = (*msg)->node_array =
 			xmalloc(sizeof(node_info_t) * (*msg)->record_count);
 
-		/* load individual job info */
-		for (i = 0; i < (*msg)->record_count; i++) {
-			if (_unpack_node_info_members(&node[i], buffer,
-						      protocol_version))
-				goto unpack_error;
-		}
+		/* load individual node info */
+		if (_unpack_records(node, sizeof(node_info_t),
+				    (*msg)->record_count,
+				    (unpack_rec_func_t) _unpack_node_info_members,
+				    buffer, protocol_version))
+			goto unpack_error;
 	} else {
 		error("_unpack_node_info_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -5055,7 +5180,7 @@ _unpack_epilog_comp_msg(epilog_complete_msg_t ** msg, Buf buffer,
 	uint32_t uint32_tmp;
 	/* alloc memory for structure */
 	xassert(msg);
-	tmp_ptr = xmalloc(sizeof(epilog_complete_msg_t));
+	tmp_ptr = buf_xmalloc(buffer, sizeof(epilog_complete_msg_t));
 	*msg = tmp_ptr;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
@@ -5836,7 +5961,7 @@ static void
 _pack_buffer_msg(slurm_msg_t * msg, Buf buffer)
 {
 	xassert(msg != NULL);
-	packmem_array(msg->data, msg->data_size, buffer);
+	packmem_chain(msg->data, msg->data_size, buffer);
 }
 
 static void _pack_job_script_msg(char *msg, Buf buffer,
@@ -5865,7 +5990,6 @@ static int
 _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
 		     uint16_t protocol_version)
 {
-	int i;
 	job_info_t *job = NULL;
 
 	xassert(msg != NULL);
@@ -5880,11 +6004,11 @@ _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
 			job = (*msg)->job_array = xmalloc(sizeof(job_info_t) *
 							  (*msg)->record_count);
 		/* load individual job info */
-		for (i = 0; i < (*msg)->record_count; i++) {
-			if (_unpack_job_info_members(&job[i], buffer,
-						     protocol_version))
-				goto unpack_error;
-		}
+		if (_unpack_records(job, sizeof(job_info_t),
+				    (*msg)->record_count,
+				    (unpack_rec_func_t) _unpack_job_info_members,
+				    buffer, protocol_version))
+			goto unpack_error;
 	} else {
 		error("_unpack_job_info_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -11474,7 +11598,7 @@ _unpack_complete_prolog_msg(
 {
 	complete_prolog_msg_t *msg;
 
-	msg = xmalloc(sizeof(complete_prolog_msg_t));
+	msg = buf_xmalloc(buffer, sizeof(complete_prolog_msg_t));
 	*msg_ptr = msg;
 
 	safe_unpack32(&msg->job_id, buffer);
@@ -11697,7 +11821,7 @@ _unpack_complete_batch_script_msg(
 	complete_batch_script_msg_t *msg;
 	uint32_t uint32_tmp;
 
-	msg = xmalloc(sizeof(complete_batch_script_msg_t));
+	msg = buf_xmalloc(buffer, sizeof(complete_batch_script_msg_t));
 	*msg_ptr = msg;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
@@ -11843,7 +11967,7 @@ _unpack_step_complete_msg(step_complete_msg_t ** msg_ptr, Buf buffer,
 {
 	step_complete_msg_t *msg;
 
-	msg = xmalloc(sizeof(step_complete_msg_t));
+	msg = buf_xmalloc(buffer, sizeof(step_complete_msg_t));
 	*msg_ptr = msg;
 
 	safe_unpack32(&msg->job_id, buffer);
@@ -14481,6 +14605,16 @@ static void _pack_slurmd_status(slurmd_status_t *msg, Buf buffer,
 		packstr(msg->slurmd_logfile, buffer);
 		packstr(msg->step_list, buffer);
 		packstr(msg->version, buffer);
+
+		/* Appended within 17.11, see _unpack_slurmd_status() */
+		if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
+			pack32(msg->stepd_pool_size, buffer);
+			pack32(msg->stepd_pool_idle, buffer);
+			pack32_array(msg->launch_hist_pooled,
+				     msg->launch_hist_cnt, buffer);
+			pack32_array(msg->launch_hist_forked,
+				     msg->launch_hist_cnt, buffer);
+		}
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack_time(msg->booted, buffer);
 		pack_time(msg->last_slurmctld_msg, buffer);
@@ -14539,6 +14673,19 @@ static int _unpack_slurmd_status(slurmd_status_t **msg_ptr, Buf buffer,
 					&uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&msg->version,
 					&uint32_tmp, buffer);
+
+		/* Older 17.11 slurmd do not send the step launch fields */
+		if ((protocol_version >= SLURM_17_11_PROTOCOL_VERSION) &&
+		    remaining_buf(buffer)) {
+			safe_unpack32(&msg->stepd_pool_size, buffer);
+			safe_unpack32(&msg->stepd_pool_idle, buffer);
+			safe_unpack32_array(&msg->launch_hist_pooled,
+					    &msg->launch_hist_cnt, buffer);
+			safe_unpack32_array(&msg->launch_hist_forked,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->launch_hist_cnt)
+				goto unpack_error;
+		}
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		uint32_t tmp_mem;
 		safe_unpack_time(&msg->booted, buffer);
@@ -15081,6 +15228,76 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Unpack the RPC latency histograms, which omit trailing empty buckets */
+static int _unpack_rpc_latency(stats_info_response_msg_t *msg, Buf buffer)
+{
+	rpc_latency_t *latency;
+	uint32_t *hist = NULL, bucket_cnt;
+	int i, j;
+
+	safe_unpack32(&msg->rpc_latency_size, buffer);
+	if (msg->rpc_latency_size > NO_VAL16)
+		goto unpack_error;
+	msg->rpc_latency = xmalloc(sizeof(rpc_latency_t) *
+				   msg->rpc_latency_size);
+	for (i = 0, latency = msg->rpc_latency; i < msg->rpc_latency_size;
+	     i++, latency++) {
+		safe_unpack16(&latency->rpc_type, buffer);
+		for (j = 0; j < RPC_LATENCY_PHASES; j++) {
+			safe_unpack32_array(&hist, &bucket_cnt, buffer);
+			if (bucket_cnt > RPC_LATENCY_BUCKETS)
+				goto unpack_error;
+			if (bucket_cnt) {
+				memcpy(latency->hist[j], hist,
+				       sizeof(uint32_t) * bucket_cnt);
+			}
+			xfree(hist);
+			safe_unpack32(&latency->max[j], buffer);
+		}
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(hist);
+	xfree(msg->rpc_latency);
+	msg->rpc_latency_size = 0;
+	return SLURM_ERROR;
+}
+
+/* Unpack the lock statistics of each call site, see lock_stats_pack() */
+static int _unpack_lock_stats(stats_info_response_msg_t *msg, Buf buffer)
+{
+	lock_site_stats_t *site;
+	uint32_t uint32_tmp;
+	int i;
+
+	safe_unpack32(&msg->lock_site_size, buffer);
+	if (msg->lock_site_size > NO_VAL16)
+		goto unpack_error;
+	msg->lock_site = xmalloc(sizeof(lock_site_stats_t) *
+				 msg->lock_site_size);
+	for (i = 0, site = msg->lock_site; i < msg->lock_site_size;
+	     i++, site++) {
+		safe_unpackstr_xmalloc(&site->site, &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&site->locks, &uint32_tmp, buffer);
+		safe_unpack32(&site->count, buffer);
+		safe_unpack64(&site->wait_total, buffer);
+		safe_unpack32(&site->wait_max, buffer);
+		safe_unpack64(&site->hold_total, buffer);
+		safe_unpack32(&site->hold_max, buffer);
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	for (i = 0; msg->lock_site && (i < msg->lock_site_size); i++) {
+		xfree(msg->lock_site[i].site);
+		xfree(msg->lock_site[i].locks);
+	}
+	xfree(msg->lock_site);
+	msg->lock_site_size = 0;
+	return SLURM_ERROR;
+}
+
 static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				       Buf buffer, uint16_t protocol_version)
 {
@@ -15145,6 +15362,22 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 		safe_unpack32_array(&msg->rpc_user_id,   &uint32_tmp, buffer);
 		safe_unpack32_array(&msg->rpc_user_cnt,  &uint32_tmp, buffer);
 		safe_unpack64_array(&msg->rpc_user_time, &uint32_tmp, buffer);
+
+		/* Older 17.11 slurmctld do not send these, see
+		 * pack_all_stat_ext() */
+		if (msg->parts_packed && remaining_buf(buffer)) {
+			safe_unpack32(&msg->node_set_cache_hits, buffer);
+			safe_unpack32(&msg->node_set_cache_misses, buffer);
+			safe_unpack32(&msg->schedule_class_skip, buffer);
+			safe_unpack32(&msg->bf_class_skip, buffer);
+		}
+		/* Nor these, see _pack_rpc_latency() in proc_req.c */
+		if (msg->parts_packed && remaining_buf(buffer) &&
+		    (_unpack_rpc_latency(msg, buffer) != SLURM_SUCCESS))
+			goto unpack_error;
+		if (msg->parts_packed && remaining_buf(buffer) &&
+		    (_unpack_lock_stats(msg, buffer) != SLURM_SUCCESS))
+			goto unpack_error;
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->parts_packed,	buffer);
 		if (msg->parts_packed) {
@@ -89,6 +89,15 @@ extern int pack_msg ( slurm_msg_t const * msg , Buf buffer );
  */
 extern int unpack_msg ( slurm_msg_t * msg , Buf buffer );
 
+/* unpack_msg_arena_ok
+ * tells whether the body of a message may be unpacked into the arena of its
+ * buffer. This is only the case for messages that slurmctld reads and
+ * releases without keeping any part of the unpacked data.
+ * IN msg_type - type of the message
+ * RET true if an arena may be used
+ */
+extern bool unpack_msg_arena_ok(uint16_t msg_type);
+
 /***************************************************************************/
 /* specific case statement Pack / Unpack methods for slurm protocol bodies */
 /***************************************************************************/
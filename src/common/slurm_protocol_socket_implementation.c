@@ -40,6 +40,7 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <limits.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <poll.h>
@@ -52,6 +53,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "slurm/slurm_errno.h"
@@ -65,6 +67,10 @@
 #include "src/common/xmalloc.h"
 #include "src/common/util-net.h"
 
+#ifndef IOV_MAX
+#  define IOV_MAX	1024	/* Linux UIO_MAXIOV */
+#endif
+
 #define PORT_RETRIES    3
 #define MIN_USER_PORT   (IPPORT_RESERVED + 1)
 #define MAX_USER_PORT   0xffff
@@ -174,6 +180,7 @@ ssize_t slurm_msg_sendto_timeout(int fd, char *buffer, size_t size,
 	int   len;
 	uint32_t usize;
 	SigFunc *ohandler;
+	struct iovec iov[2];
 
 	/*
 	 *  Ignore SIGPIPE so that send can return a error code if the
@@ -181,19 +188,59 @@ ssize_t slurm_msg_sendto_timeout(int fd, char *buffer, size_t size,
 	 */
 	ohandler = xsignal(SIGPIPE, SIG_IGN);
 
+	/* Send the length and the message with a single system call */
 	usize = htonl(size);
+	iov[0].iov_base = &usize;
+	iov[0].iov_len = sizeof(usize);
+	iov[1].iov_base = buffer;
+	iov[1].iov_len = size;
+
+	if ((len = slurm_sendv_timeout(fd, iov, 2, 0, timeout)) >= 0)
+		len = size;
 
-	if ((len = slurm_send_timeout(
-				fd, (char *)&usize, sizeof(usize), 0,
-				timeout)) < 0)
-		goto done;
+	xsignal(SIGPIPE, ohandler);
+	return len;
+}
 
-	if ((len = slurm_send_timeout(fd, buffer, size, 0, timeout)) < 0)
-		goto done;
+extern ssize_t slurm_msg_sendto_buf(int fd, Buf buffer, uint32_t flags)
+{
+	struct iovec iov_local[4], *iov = iov_local;
+	uint32_t usize, offset = 0;
+	size_t size = get_buf_length(buffer);
+	int i, iovcnt = 0;
+	ssize_t len;
+	SigFunc *ohandler;
 
+	/* Each segment may be preceded by part of the head */
+	if (buffer->seg_cnt > 1)
+		iov = xmalloc(sizeof(struct iovec) * (2 * buffer->seg_cnt + 2));
 
-     done:
+	usize = htonl(size);
+	iov[iovcnt].iov_base = &usize;
+	iov[iovcnt++].iov_len = sizeof(usize);
+	for (i = 0; i < buffer->seg_cnt; i++) {
+		buf_seg_t *seg = &buffer->segs[i];
+		if (seg->offset > offset) {
+			iov[iovcnt].iov_base = buffer->head + offset;
+			iov[iovcnt++].iov_len = seg->offset - offset;
+			offset = seg->offset;
+		}
+		iov[iovcnt].iov_base = seg->data;
+		iov[iovcnt++].iov_len = seg->size;
+	}
+	if (buffer->processed > offset) {
+		iov[iovcnt].iov_base = buffer->head + offset;
+		iov[iovcnt++].iov_len = buffer->processed - offset;
+	}
+
+	ohandler = xsignal(SIGPIPE, SIG_IGN);
+	if ((len = slurm_sendv_timeout(fd, iov, iovcnt, 0,
+				       slurm_get_msg_timeout() * 1000)) >= 0)
+		len = size;
 	xsignal(SIGPIPE, ohandler);
+
+	if (iov != iov_local)
+		xfree(iov);
 	return len;
 }
 
@@ -202,14 +249,34 @@ ssize_t slurm_msg_sendto_timeout(int fd, char *buffer, size_t size,
 extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      uint32_t flags, int timeout)
 {
-	int rc;
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = size;
+	return slurm_sendv_timeout(fd, &iov, 1, flags, timeout);
+}
+
+/* Send the data described by iov with timeout, gathering it with sendmsg()
+ * like writev() does. The iov array is modified.
+ * RET total size of the data or SLURM_ERROR on error */
+extern int slurm_sendv_timeout(int fd, struct iovec *iov, int iovcnt,
+			       uint32_t flags, int timeout)
+{
+	int rc, i;
 	int sent = 0;
+	size_t size = 0;
 	int fd_flags;
 	struct pollfd ufds;
 	struct timeval tstart;
+	struct msghdr mh;
 	int timeleft = timeout;
 	char temp[2];
 
+	for (i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+	i = 0;
+	memset(&mh, 0, sizeof(mh));
+
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
 
@@ -266,7 +333,12 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = send(fd, &buf[sent], (size - sent), flags);
+		/* Skip the iovecs already sent */
+		while ((i < iovcnt) && (iov[i].iov_len == 0))
+			i++;
+		mh.msg_iov = &iov[i];
+		mh.msg_iovlen = MIN(iovcnt - i, IOV_MAX);
+		rc = sendmsg(fd, &mh, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -290,6 +362,15 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+		for ( ; (i < iovcnt) && rc; i++) {
+			if (rc < iov[i].iov_len) {
+				iov[i].iov_base = (char *) iov[i].iov_base + rc;
+				iov[i].iov_len -= rc;
+				break;
+			}
+			rc -= iov[i].iov_len;
+			iov[i].iov_len = 0;
+		}
 	}
 
     done:
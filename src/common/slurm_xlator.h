@@ -237,6 +237,7 @@
 #define	free_buf		slurm_free_buf
 #define grow_buf		slurm_grow_buf
 #define	init_buf		slurm_init_buf
+#define	init_buf_chain		slurm_init_buf_chain
 #define	xfer_buf_data		slurm_xfer_buf_data
 #define	pack_time		slurm_pack_time
 #define	unpack_time		slurm_unpack_time
@@ -264,6 +265,7 @@
 #define	packstr_array		slurm_packstr_array
 #define	unpackstr_array		slurm_unpackstr_array
 #define	packmem_array		slurm_packmem_array
+#define	packmem_chain		slurm_packmem_chain
 #define	unpackmem_array		slurm_unpackmem_array
 
 /* parse_time.[ch] functions */
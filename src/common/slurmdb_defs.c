@@ -666,8 +666,10 @@ extern void slurmdb_destroy_qos_usage(void *object)
 		(slurmdb_qos_usage_t *)object;
 
 	if (usage) {
+		slurmdb_destroy_used_limits_index(usage->acct_limit_index);
 		FREE_NULL_LIST(usage->acct_limit_list);
 		FREE_NULL_LIST(usage->job_list);
+		slurmdb_destroy_used_limits_index(usage->user_limit_index);
 		FREE_NULL_LIST(usage->user_limit_list);
 		xfree(usage->grp_used_tres_run_secs);
 		xfree(usage->grp_used_tres);
@@ -1248,6 +1250,180 @@ extern void slurmdb_destroy_update_object(void *object)
 	}
 }
 
+/*
+ * Open addressing hash table of the records in a QOS used limit list, keyed
+ * by account name or by uid. Records are never removed from those lists
+ * while the QOS usage exists, so the table only ever grows.
+ */
+typedef struct {
+	bool by_acct;
+	uint32_t cnt;		/* records in the table */
+	pthread_mutex_t mutex;	/* lookups happen under assoc_mgr read locks */
+	slurmdb_used_limits_t **recs;
+	uint32_t size;		/* slots in recs, always a power of 2 */
+} used_limits_index_t;
+
+static uint32_t _used_limits_hash(used_limits_index_t *index,
+				  const char *acct, uint32_t uid)
+{
+	uint32_t hash = 2166136261U;	/* FNV-1a */
+
+	if (!index->by_acct)
+		return uid * 2654435761U;
+	if (acct) {
+		while (*acct) {
+			hash ^= (uint8_t) *acct++;
+			hash *= 16777619U;
+		}
+	}
+	return hash;
+}
+
+static bool _used_limits_match(used_limits_index_t *index,
+			       slurmdb_used_limits_t *used_limits,
+			       const char *acct, uint32_t uid)
+{
+	if (index->by_acct)
+		return !xstrcmp(used_limits->acct, acct);
+	return (used_limits->uid == uid);
+}
+
+static void _used_limits_index_insert(used_limits_index_t *index,
+				      slurmdb_used_limits_t *used_limits)
+{
+	uint32_t i = _used_limits_hash(index, used_limits->acct,
+				       used_limits->uid);
+
+	for (i &= (index->size - 1); index->recs[i];
+	     i = (i + 1) & (index->size - 1))
+		;
+	index->recs[i] = used_limits;
+	index->cnt++;
+}
+
+/* Size the table for the list and (re)insert every record of it */
+static void _used_limits_index_build(used_limits_index_t *index,
+				     List limit_list)
+{
+	ListIterator itr;
+	slurmdb_used_limits_t *used_limits;
+	uint32_t need = list_count(limit_list) * 2;
+
+	if (index->size < need) {
+		if (!index->size)
+			index->size = 64;
+		while (index->size < need)
+			index->size *= 2;
+		xfree(index->recs);
+		index->recs = xmalloc(sizeof(slurmdb_used_limits_t *) *
+				      index->size);
+	} else
+		memset(index->recs, 0,
+		       sizeof(slurmdb_used_limits_t *) * index->size);
+	index->cnt = 0;
+
+	itr = list_iterator_create(limit_list);
+	while ((used_limits = list_next(itr)))
+		_used_limits_index_insert(index, used_limits);
+	list_iterator_destroy(itr);
+}
+
+/* Call with index->mutex locked */
+static slurmdb_used_limits_t *_used_limits_index_find(
+	used_limits_index_t *index, const char *acct, uint32_t uid)
+{
+	uint32_t i;
+
+	if (!index->size)
+		return NULL;
+
+	for (i = _used_limits_hash(index, acct, uid) & (index->size - 1);
+	     index->recs[i]; i = (i + 1) & (index->size - 1)) {
+		if (_used_limits_match(index, index->recs[i], acct, uid))
+			return index->recs[i];
+	}
+	return NULL;
+}
+
+static used_limits_index_t *_used_limits_index_get(void **index_ptr,
+						   bool by_acct)
+{
+	used_limits_index_t *index = *index_ptr;
+
+	if (!index) {
+		index = xmalloc(sizeof(used_limits_index_t));
+		index->by_acct = by_acct;
+		slurm_mutex_init(&index->mutex);
+		*index_ptr = index;
+	}
+	return index;
+}
+
+extern slurmdb_used_limits_t *slurmdb_find_used_limits(
+	List limit_list, void **index_ptr, bool by_acct,
+	const char *acct, uint32_t uid)
+{
+	used_limits_index_t *index;
+	slurmdb_used_limits_t *used_limits;
+
+	xassert(index_ptr);
+
+	if (!limit_list)
+		return NULL;
+
+	index = _used_limits_index_get(index_ptr, by_acct);
+	slurm_mutex_lock(&index->mutex);
+	/* The list may have been filled in without us (e.g. unpacked) */
+	if (index->cnt != list_count(limit_list))
+		_used_limits_index_build(index, limit_list);
+	used_limits = _used_limits_index_find(index, acct, uid);
+	slurm_mutex_unlock(&index->mutex);
+
+	return used_limits;
+}
+
+extern slurmdb_used_limits_t *slurmdb_add_used_limits(
+	List limit_list, void **index_ptr, bool by_acct,
+	slurmdb_used_limits_t *used_limits)
+{
+	used_limits_index_t *index;
+	slurmdb_used_limits_t *found;
+
+	xassert(limit_list);
+	xassert(index_ptr);
+
+	index = _used_limits_index_get(index_ptr, by_acct);
+	slurm_mutex_lock(&index->mutex);
+	if (index->cnt != list_count(limit_list))
+		_used_limits_index_build(index, limit_list);
+	/* Another thread may have added the same record meanwhile */
+	if ((found = _used_limits_index_find(index, used_limits->acct,
+					     used_limits->uid))) {
+		slurm_mutex_unlock(&index->mutex);
+		slurmdb_destroy_used_limits(used_limits);
+		return found;
+	}
+	list_append(limit_list, used_limits);
+	if (((index->cnt + 1) * 2) > index->size)
+		_used_limits_index_build(index, limit_list);
+	else
+		_used_limits_index_insert(index, used_limits);
+	slurm_mutex_unlock(&index->mutex);
+
+	return used_limits;
+}
+
+extern void slurmdb_destroy_used_limits_index(void *object)
+{
+	used_limits_index_t *index = (used_limits_index_t *) object;
+
+	if (index) {
+		slurm_mutex_destroy(&index->mutex);
+		xfree(index->recs);
+		xfree(index);
+	}
+}
+
 extern void slurmdb_destroy_used_limits(void *object)
 {
 	slurmdb_used_limits_t *slurmdb_used_limits =
@@ -279,6 +279,28 @@ extern int slurmdb_get_old_tres_pos(slurmdb_tres_rec_t **new_array,
 
 extern int slurmdb_get_tres_base_unit(char *tres_type);
 
+/*
+ * Find the record of an account (by_acct) or a user (by uid) in one of the
+ * used limit lists of a QOS usage. index_ptr points at the matching
+ * acct_limit_index or user_limit_index of the usage, which is created and
+ * kept in sync with the list here.
+ * RET record found or NULL
+ */
+extern slurmdb_used_limits_t *slurmdb_find_used_limits(
+	List limit_list, void **index_ptr, bool by_acct,
+	const char *acct, uint32_t uid);
+
+/*
+ * Append used_limits to limit_list and add it to the list's index.
+ * RET used_limits, or the matching record already in the list in which case
+ *     used_limits is freed
+ */
+extern slurmdb_used_limits_t *slurmdb_add_used_limits(
+	List limit_list, void **index_ptr, bool by_acct,
+	slurmdb_used_limits_t *used_limits);
+
+extern void slurmdb_destroy_used_limits_index(void *object);
+
 /* Setup cluster rec with plugin_id that indexes into select list */
 extern int slurmdb_setup_cluster_rec(slurmdb_cluster_rec_t *cluster_rec);
 
@@ -63,6 +63,44 @@ static void malloc_assert_failed(char *, const char *, int,
           } while (0)
 #endif /* NDEBUG */
 
+#define XARENA_ALIGN		(2 * sizeof(size_t))
+#define XARENA_CHUNK_SIZE	(8 * 1024)
+/* The arena and its first chunk are sized to stay in malloc's fast bins */
+#define XARENA_FIRST_SIZE	\
+	(1024 - sizeof(xarena_t) - sizeof(xarena_chunk_t))
+
+typedef struct xarena_chunk {
+	struct xarena_chunk *next;
+	size_t size;		/* bytes following this header */
+} xarena_chunk_t;
+
+struct xarena {
+	xarena_chunk_t *chunks;	/* chunk being filled first */
+	size_t used;		/* bytes used in that chunk */
+};
+
+/*
+ * Move a block allocated from an arena to memory of its own, so that it can
+ * be grown and freed like any other block. On failure *item is unchanged.
+ */
+static void _arena_realloc(void **item, size_t newsize, bool clear)
+{
+	size_t *old = (size_t *)*item - 2;
+	size_t *p;
+	size_t total_size = newsize + 2 * sizeof(size_t);
+
+	if (clear)
+		p = calloc(1, total_size);
+	else
+		p = malloc(total_size);
+	if (!p)
+		return;
+	memcpy(&p[2], &old[2], MIN(old[1], newsize));
+	p[0] = XMALLOC_MAGIC;
+	p[1] = newsize;
+	*item = &p[2];
+}
+
 
 /*
  * "Safe" version of malloc().
@@ -135,7 +173,12 @@ extern void * slurm_xrealloc(void **item, size_t newsize, bool clear,
 {
 	size_t *p = NULL;
 
-	if (*item != NULL) {
+	if ((*item != NULL) && (((size_t *)*item)[-2] == XMALLOC_ARENA_MAGIC)) {
+		_arena_realloc(item, newsize, clear);
+		p = (size_t *)*item - 2;
+		if (p[0] != XMALLOC_MAGIC)
+			goto error;
+	} else if (*item != NULL) {
 		size_t old_size;
 		p = (size_t *)*item - 2;
 
@@ -184,7 +227,12 @@ int slurm_try_xrealloc(void **item, size_t newsize,
 {
 	size_t *p = NULL;
 
-	if (*item != NULL) {
+	if ((*item != NULL) && (((size_t *)*item)[-2] == XMALLOC_ARENA_MAGIC)) {
+		_arena_realloc(item, newsize, true);
+		p = (size_t *)*item - 2;
+		if (p[0] != XMALLOC_MAGIC)
+			return 0;
+	} else if (*item != NULL) {
 		size_t old_size;
 		p = (size_t *)*item - 2;
 
@@ -225,7 +273,8 @@ size_t slurm_xsize(void *item, const char *file, int line, const char *func)
 {
 	size_t *p = (size_t *)item - 2;
 	xmalloc_assert(item != NULL);
-	xmalloc_assert(p[0] == XMALLOC_MAGIC); /* CLANG false positive here */
+	xmalloc_assert((p[0] == XMALLOC_MAGIC) ||	/* CLANG false positive */
+		       (p[0] == XMALLOC_ARENA_MAGIC));
 	return p[1];
 }
 
@@ -238,14 +287,121 @@ void slurm_xfree(void **item, const char *file, int line, const char *func)
 {
 	if (*item != NULL) {
 		size_t *p = (size_t *)*item - 2;
+		*item = NULL;
+		/* arena memory is only released with the whole arena */
+		if (p[0] == XMALLOC_ARENA_MAGIC)
+			return;
 		/* magic cookie still there? */
 		xmalloc_assert(p[0] == XMALLOC_MAGIC);
 		p[0] = 0;	/* make sure xfree isn't called twice */
 		free(p);
-		*item = NULL;
 	}
 }
 
+/*
+ * Create an arena. The first chunk is part of the same allocation, so an
+ * arena holding a small message costs a single malloc() and free().
+ */
+xarena_t *xarena_create(void)
+{
+	xarena_t *arena;
+
+	arena = malloc(sizeof(xarena_t) + sizeof(xarena_chunk_t) +
+		       XARENA_FIRST_SIZE);
+	if (!arena) {
+		log_oom(__FILE__, __LINE__, __func__);
+		abort();
+	}
+	arena->chunks = (xarena_chunk_t *) (arena + 1);
+	arena->chunks->next = NULL;
+	arena->chunks->size = XARENA_FIRST_SIZE;
+	arena->used = 0;
+
+	return arena;
+}
+
+/*
+ * Release an arena and all memory allocated from it.
+ */
+void xarena_destroy(xarena_t *arena)
+{
+	xarena_chunk_t *chunk, *next;
+
+	if (!arena)
+		return;
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		if (chunk != (xarena_chunk_t *) (arena + 1))
+			free(chunk);
+	}
+	free(arena);
+}
+
+static xarena_chunk_t *_arena_chunk(size_t size, const char *file, int line,
+				    const char *func)
+{
+	xarena_chunk_t *chunk = malloc(sizeof(xarena_chunk_t) + size);
+
+	if (!chunk) {
+		log_oom(file, line, func);
+		abort();
+	}
+	chunk->size = size;
+	return chunk;
+}
+
+/*
+ * Allocate memory from an arena, or with slurm_xmalloc() if arena is NULL.
+ *   arena (IN)	arena to allocate from
+ *   size (IN)	number of bytes to allocate
+ *   clear (IN) initialize to zero
+ *   RETURN	pointer to allocated space
+ */
+void *slurm_xarena_alloc(xarena_t *arena, uint64_t size, bool clear,
+			 const char *file, int line, const char *func)
+{
+	xarena_chunk_t *chunk;
+	size_t *p;
+	size_t total_size;
+
+	if (!arena)
+		return slurm_xmalloc(size, clear, file, line, func);
+
+	if (size > 0xffffffff)
+		fatal("attempt at overflow");
+
+	if (size <= 0)
+		return NULL;
+
+	total_size = (size + 2 * sizeof(size_t) + XARENA_ALIGN - 1) &
+		     ~(XARENA_ALIGN - 1);
+	if (total_size > (XARENA_CHUNK_SIZE / 4)) {
+		/* Large blocks get a chunk of their own behind the current
+		 * one, which keeps being filled */
+		chunk = _arena_chunk(total_size, file, line, func);
+		chunk->next = arena->chunks->next;
+		arena->chunks->next = chunk;
+		p = (size_t *) (chunk + 1);
+	} else {
+		if ((arena->used + total_size) > arena->chunks->size) {
+			chunk = _arena_chunk(XARENA_CHUNK_SIZE,
+					     file, line, func);
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+			arena->used = 0;
+		}
+		p = (size_t *) ((char *) (arena->chunks + 1) + arena->used);
+		arena->used += total_size;
+	}
+
+	if (clear)
+		memset(p, 0, total_size);
+	p[0] = XMALLOC_ARENA_MAGIC;	/* add "secret" magic cookie */
+	p[1] = size;			/* store size in buffer */
+
+	return &p[2];
+}
+
 #ifndef NDEBUG
 static void malloc_assert_failed(char *expr, const char *file,
 		                 int line, const char *caller, const char *func)
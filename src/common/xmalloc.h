@@ -71,6 +71,13 @@
  * p. The memory must have been allocated with [try_]xmalloc() or
  * [try_]xrealloc().
  *
+ * xarena_create() returns an arena which hands out memory from large chunks.
+ * xarena_alloc(arena, size) allocates size zeroed bytes from the arena, or
+ * behaves like xmalloc(size) if arena is NULL. Memory from an arena may be
+ * passed to xfree(), which only clears the pointer, and to xrealloc(), which
+ * moves the data to memory of its own. It is released all at once by
+ * xarena_destroy(arena).
+ *
 \*****************************************************************************/
 
 #ifndef _XMALLOC_H
@@ -108,6 +115,16 @@
 #define xsize(__p) \
 	slurm_xsize((void *)__p, __FILE__, __LINE__, __func__)
 
+#define xarena_alloc(__arena, __sz) \
+	slurm_xarena_alloc(__arena, (uint64_t) __sz, true, \
+			   __FILE__, __LINE__, __func__)
+
+#define xarena_alloc_nz(__arena, __sz) \
+	slurm_xarena_alloc(__arena, (uint64_t) __sz, false, \
+			   __FILE__, __LINE__, __func__)
+
+typedef struct xarena xarena_t;
+
 void *slurm_xmalloc(uint64_t, bool, const char *, int, const char *);
 void *slurm_try_xmalloc(size_t , const char *, int , const char *);
 void slurm_xfree(void **, const char *, int, const char *);
@@ -115,6 +132,12 @@ void *slurm_xrealloc(void **, size_t, bool, const char *, int, const char *);
 int  slurm_try_xrealloc(void **, size_t, const char *, int, const char *);
 size_t slurm_xsize(void *, const char *, int, const char *);
 
+xarena_t *xarena_create(void);
+void xarena_destroy(xarena_t *);
+void *slurm_xarena_alloc(xarena_t *, uint64_t, bool, const char *, int,
+			 const char *);
+
 #define XMALLOC_MAGIC 0x42
+#define XMALLOC_ARENA_MAGIC 0x43	/* block is part of an xarena_t */
 
 #endif /* !_XMALLOC_H */
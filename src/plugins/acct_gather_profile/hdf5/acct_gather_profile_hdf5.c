@@ -64,12 +64,13 @@
 #include "src/slurmd/common/proctrack.h"
 #include "hdf5_api.h"
 
-#define HDF5_CHUNK_SIZE 10
+/* Number of records per HDF5 chunk, also the number of samples buffered in
+ * memory for each table before they are appended to the file. */
+#define HDF5_DEFAULT_CHUNK_SIZE 10
 /* Compression level, a value of 0 through 9. Level 0 is faster but offers the
  * least compression; level 9 is slower but offers maximum compression.
  * A setting of -1 indicates that no compression is desired. */
-/* TODO: Make this configurable with a parameter */
-#define HDF5_COMPRESS 0
+#define HDF5_DEFAULT_COMPRESS 0
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -101,13 +102,19 @@ const char plugin_type[] = "acct_gather_profile/hdf5";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 typedef struct {
+	uint32_t chunk_size;
+	int32_t compress;
 	char *dir;
 	uint32_t def;
+	uint32_t flush_interval;
 } slurm_hdf5_conf_t;
 
 typedef struct {
-	hid_t  table_id;
-	size_t type_size;
+	uint8_t *buf;		/* chunk_size records waiting to be written */
+	size_t  buf_rows;	/* number of records currently in buf */
+	time_t  last_flush;	/* time buf was last written to the table */
+	hid_t   table_id;
+	size_t  type_size;
 } table_t;
 
 // Global HDF5 Variables
@@ -135,8 +142,32 @@ static size_t   tables_cur_len = 0;
 
 static void _reset_slurm_profile_conf(void)
 {
+	hdf5_conf.chunk_size = HDF5_DEFAULT_CHUNK_SIZE;
+	hdf5_conf.compress = HDF5_DEFAULT_COMPRESS;
 	xfree(hdf5_conf.dir);
 	hdf5_conf.def = ACCT_GATHER_PROFILE_NONE;
+	hdf5_conf.flush_interval = 0;
+}
+
+/*
+ * Append the records buffered for a table to the HDF5 file in one call.
+ * Batching the samples this way means the shared file system sees one
+ * chunk-sized write instead of one small write per sample.
+ */
+static int _flush_table(table_t *table, time_t now)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (table->buf_rows &&
+	    (H5PTappend(table->table_id, table->buf_rows, table->buf) < 0)) {
+		error("PROFILE: Impossible to add %"PRIu64" records to a table",
+		      (uint64_t) table->buf_rows);
+		rc = SLURM_ERROR;
+	}
+	table->buf_rows = 0;
+	table->last_flush = now;
+
+	return rc;
 }
 
 static uint32_t _determine_profile(void)
@@ -233,6 +264,10 @@ extern int init(void)
 
 extern int fini(void)
 {
+	size_t i;
+
+	for (i = 0; i < tables_cur_len; ++i)
+		xfree(tables[i].buf);
 	xfree(tables);
 	xfree(groups);
 	xfree(hdf5_conf.dir);
@@ -243,8 +278,11 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 					       int *full_options_cnt)
 {
 	s_p_options_t options[] = {
+		{"ProfileHDF5ChunkSize", S_P_UINT32},
+		{"ProfileHDF5Compress", S_P_LONG},
 		{"ProfileHDF5Dir", S_P_STRING},
 		{"ProfileHDF5Default", S_P_STRING},
+		{"ProfileHDF5FlushInterval", S_P_UINT32},
 		{NULL} };
 
 	transfer_s_p_options(full_options, options, full_options_cnt);
@@ -254,8 +292,23 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 {
 	char *tmp = NULL;
+	long compress;
+
 	_reset_slurm_profile_conf();
 	if (tbl) {
+		s_p_get_uint32(&hdf5_conf.chunk_size, "ProfileHDF5ChunkSize",
+			       tbl);
+		if (!hdf5_conf.chunk_size)
+			fatal("ProfileHDF5ChunkSize must be greater than 0");
+
+		if (s_p_get_long(&compress, "ProfileHDF5Compress", tbl)) {
+			if ((compress < -1) || (compress > 9))
+				fatal("ProfileHDF5Compress can not be set to "
+				      "%ld, valid values are -1 through 9",
+				      compress);
+			hdf5_conf.compress = compress;
+		}
+
 		s_p_get_string(&hdf5_conf.dir, "ProfileHDF5Dir", tbl);
 
 		if (s_p_get_string(&tmp, "ProfileHDF5Default", tbl)) {
@@ -267,6 +320,9 @@ extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 			}
 			xfree(tmp);
 		}
+
+		s_p_get_uint32(&hdf5_conf.flush_interval,
+			       "ProfileHDF5FlushInterval", tbl);
 	}
 
 	if (!hdf5_conf.dir)
@@ -422,10 +478,14 @@ extern int acct_gather_profile_p_node_step_end(void)
 	if (debug_flags & DEBUG_FLAG_PROFILE)
 		info("PROFILE: node_step_end (shutdown)");
 
-	/* close tables */
+	/* write out buffered samples and close tables */
 	for (i = 0; i < tables_cur_len; ++i) {
+		if (_flush_table(&tables[i], time(NULL)) != SLURM_SUCCESS)
+			rc = SLURM_ERROR;
 		H5PTclose(tables[i].table_id);
+		xfree(tables[i].buf);
 	}
+	tables_cur_len = 0;
 	/* close groups */
 	for (i = 0; i < groups_len; ++i) {
 		H5Gclose(groups[i]);
@@ -562,8 +622,8 @@ extern int acct_gather_profile_p_create_dataset(
 	/* create the table */
 	if (parent < 0)
 		parent = gid_node; /* default parent is the node group */
-	table_id = H5PTcreate_fl(parent, name, dtype_id, HDF5_CHUNK_SIZE,
-	                         HDF5_COMPRESS);
+	table_id = H5PTcreate_fl(parent, name, dtype_id, hdf5_conf.chunk_size,
+				 hdf5_conf.compress);
 	if (table_id < 0) {
 		error("PROFILE: Impossible to create the table %s", name);
 		H5Tclose(dtype_id);
@@ -580,6 +640,9 @@ extern int acct_gather_profile_p_create_dataset(
 	}
 
 	/* reserve a new table */
+	tables[tables_cur_len].buf = xmalloc(hdf5_conf.chunk_size * type_size);
+	tables[tables_cur_len].buf_rows = 0;
+	tables[tables_cur_len].last_flush = time(NULL);
 	tables[tables_cur_len].table_id  = table_id;
 	tables[tables_cur_len].type_size = type_size;
 	++tables_cur_len;
@@ -590,8 +653,8 @@ extern int acct_gather_profile_p_create_dataset(
 extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 						 time_t sample_time)
 {
-	table_t *ds = &tables[table_id];
-	uint8_t send_data[ds->type_size];
+	table_t *ds;
+	uint8_t *send_data;
 	int header_size = 0;
 	debug("acct_gather_profile_p_add_sample_data %d", table_id);
 
@@ -614,6 +677,9 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
 		return SLURM_ERROR;
 
+	ds = &tables[table_id];
+	send_data = ds->buf + (ds->buf_rows * ds->type_size);
+
 	/* prepend timestampe and relative time */
 	((uint64_t *)send_data)[0] = difftime(sample_time, step_start_time);
 	header_size += sizeof(uint64_t);
@@ -622,11 +688,20 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 
 	memcpy(send_data + header_size, data, ds->type_size - header_size);
 
-	/* append the record to the table */
-	if (H5PTappend(ds->table_id, 1, send_data) < 0) {
-		error("PROFILE: Impossible to add data to the table %d; "
-		      "maybe the table has not been created?", table_id);
-		return SLURM_ERROR;
+	/*
+	 * The record stays in memory until a full chunk is buffered or
+	 * ProfileHDF5FlushInterval has elapsed since the last write.
+	 */
+	if ((++ds->buf_rows >= hdf5_conf.chunk_size) ||
+	    (hdf5_conf.flush_interval &&
+	     (difftime(sample_time, ds->last_flush) >=
+	      hdf5_conf.flush_interval))) {
+		if (_flush_table(ds, sample_time) != SLURM_SUCCESS) {
+			error("PROFILE: Impossible to add data to the table %d; "
+			      "maybe the table has not been created?",
+			      table_id);
+			return SLURM_ERROR;
+		}
 	}
 
 	return SLURM_SUCCESS;
@@ -638,6 +713,16 @@ extern void acct_gather_profile_p_conf_values(List *data)
 
 	xassert(*data);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5ChunkSize");
+	key_pair->value = xstrdup_printf("%u", hdf5_conf.chunk_size);
+	list_append(*data, key_pair);
+
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5Compress");
+	key_pair->value = xstrdup_printf("%d", hdf5_conf.compress);
+	list_append(*data, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("ProfileHDF5Dir");
 	key_pair->value = xstrdup(hdf5_conf.dir);
@@ -648,6 +733,11 @@ extern void acct_gather_profile_p_conf_values(List *data)
 	key_pair->value = xstrdup(acct_gather_profile_to_string(hdf5_conf.def));
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5FlushInterval");
+	key_pair->value = xstrdup_printf("%u sec", hdf5_conf.flush_interval);
+	list_append(*data, key_pair);
+
 	return;
 
 }
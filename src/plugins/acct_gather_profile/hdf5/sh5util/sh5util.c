@@ -52,12 +52,15 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <unistd.h>
 
+#include "src/common/macros.h"
 #include "src/common/uid.h"
 #include "src/common/read_config.h"
 #include "src/common/proc_args.h"
@@ -67,6 +70,8 @@
 #include "sh5util.h"
 
 #define MAX_PROFILE_PATH 1024
+#define PREFETCH_BUF_SIZE (1024 * 1024)
+#define PREFETCH_DEFAULT_THREADS 4
 // #define MAX_ATTR_NAME 64
 #define MAX_GROUP_NAME 64
 // #define MAX_DATASET_NAME 64
@@ -137,6 +142,24 @@ typedef struct {
 	int step_id;
 } sh5util_file_t;
 
+/*
+ * State shared by the merge loop and the read-ahead threads. The HDF5
+ * library serializes its own calls, so the object copies into the job file
+ * stay in the main thread while the prefetch threads stream the next
+ * node-step files from the shared file system into the page cache. At most
+ * "window" files are read ahead of the merge so memory use stays bounded.
+ */
+typedef struct {
+	pthread_cond_t cond;
+	int file_cnt;
+	char **file_paths;
+	int merged;		/* files merged into the job file so far */
+	pthread_mutex_t mutex;
+	int next;		/* next file to be read ahead */
+	bool shutdown;
+	int window;
+} prefetch_t;
+
 static FILE* output_file;
 static bool group_mode = false;
 static const char *current_step;
@@ -186,6 +209,8 @@ static void _help_msg(void)
 	       " -p, --profiledir     Profile directory location where node-step files exist\n"
 	       "		               default is what is set in acct_gather.conf\n"
 	       " -S, --savefiles      Don't remove node-step files after merging them \n"
+	       " -T, --threads        Number of threads reading node-step files ahead\n"
+	       "                      of the merge (default 4, 0 to disable)\n"
 	       " --user               User who profiled job. (Handy for root user, defaults to \n"
 	       "		               user running this command.)\n"
 	       " --usage              Display brief usage message\n");
@@ -330,6 +355,7 @@ static void _init_opts(void)
 	params.job_id = -1;
 	params.mode = SH5UTIL_MODE_MERGE;
 	params.step_id = -1;
+	params.threads = PREFETCH_DEFAULT_THREADS;
 }
 
 static int _set_options(const int argc, char **argv)
@@ -354,6 +380,7 @@ static int _set_options(const int argc, char **argv)
 		{"profiledir", required_argument, 0, 'p'},
 		{"series", required_argument, 0, 's'},
 		{"savefiles", no_argument, 0, 'S'},
+		{"threads", required_argument, 0, 'T'},
 		{"usage", no_argument, 0, 'U'},
 		{"user", required_argument, 0, 'u'},
 		{"verbose", no_argument, 0, 'v'},
@@ -373,7 +400,7 @@ static int _set_options(const int argc, char **argv)
 
 	_init_opts();
 
-	while ((cc = getopt_long(argc, argv, "d:Ehi:Ij:l:LN:o:p:s:Su:UvV",
+	while ((cc = getopt_long(argc, argv, "d:Ehi:Ij:l:LN:o:p:s:ST:u:UvV",
 	                         long_options, &option_index)) != EOF) {
 		switch (cc) {
 		case 'd':
@@ -430,6 +457,14 @@ static int _set_options(const int argc, char **argv)
 		case 'S':
 			params.keepfiles = 1;
 			break;
+		case 'T':
+			params.threads = strtol(optarg, &next_str, 10);
+			if ((next_str[0] != '\0') || (params.threads < 0)) {
+				error("Bad value for --threads=\"%s\"",
+				      optarg);
+				return -1;
+			}
+			break;
 		case 'u':
 			if (uid_from_string(optarg, &u) < 0) {
 				error("No such user --uid=\"%s\"",
@@ -569,6 +604,48 @@ endit:
 	return rc;
 }
 
+/* Read a file sequentially so its blocks are cached before H5Ocopy runs */
+static void _prefetch_file(const char *path, char *buf)
+{
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		debug("%s: open(%s): %m", __func__, path);
+		return;
+	}
+#ifdef POSIX_FADV_SEQUENTIAL
+	(void) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	while (read(fd, buf, PREFETCH_BUF_SIZE) > 0)
+		;
+	close(fd);
+}
+
+static void *_prefetch_thread(void *arg)
+{
+	prefetch_t *pf = (prefetch_t *) arg;
+	char *buf = xmalloc(PREFETCH_BUF_SIZE);
+	int inx;
+
+	slurm_mutex_lock(&pf->mutex);
+	while (!pf->shutdown && (pf->next < pf->file_cnt)) {
+		if (pf->next >= (pf->merged + pf->window)) {
+			slurm_cond_wait(&pf->cond, &pf->mutex);
+			continue;
+		}
+		inx = pf->next++;
+		slurm_mutex_unlock(&pf->mutex);
+
+		_prefetch_file(pf->file_paths[inx], buf);
+
+		slurm_mutex_lock(&pf->mutex);
+	}
+	slurm_mutex_unlock(&pf->mutex);
+
+	xfree(buf);
+	return NULL;
+}
+
 /* Look for step and node files and merge them together into one job file */
 static int _merge_step_files(void)
 {
@@ -593,6 +670,13 @@ static int _merge_step_files(void)
 	ListIterator itr;
 	List file_list = NULL;
 	sh5util_file_t *sh5util_file = NULL;
+	prefetch_t prefetch;
+	pthread_t *prefetch_tids = NULL;
+	int i, file_inx = 0;
+
+	memset(&prefetch, 0, sizeof(prefetch_t));
+	slurm_mutex_init(&prefetch.mutex);
+	slurm_cond_init(&prefetch.cond, NULL);
 
 	step_dir = xstrdup_printf("%s/%s", params.dir, params.user);
 
@@ -674,10 +758,34 @@ static int _merge_step_files(void)
 	/* sort the files so they are in step order */
 	list_sort(file_list, (ListCmpF) _sh5util_sort_files_dec);
 
+	/* start reading the node-step files ahead of the merge */
+	prefetch.file_cnt = list_count(file_list);
+	prefetch.file_paths = xmalloc(sizeof(char *) * prefetch.file_cnt);
+	prefetch.window = params.threads * 2;
+	itr = list_iterator_create(file_list);
+	while ((sh5util_file = list_next(itr)))
+		prefetch.file_paths[file_inx++] = xstrdup_printf(
+			"%s/%s", step_dir, sh5util_file->file_name);
+	list_iterator_destroy(itr);
+	file_inx = 0;
+	if (params.threads) {
+		prefetch_tids = xmalloc(sizeof(pthread_t) * params.threads);
+		for (i = 0; i < params.threads; i++)
+			slurm_thread_create(&prefetch_tids[i],
+					    _prefetch_thread, &prefetch);
+	}
+
 	node_cnt = 0;
 	itr = list_iterator_create(file_list);
 	while ((sh5util_file = list_next(itr))) {
 		//info("got file of %s", sh5util_file->file_name);
+		step_path = prefetch.file_paths[file_inx];
+
+		/* let the read-ahead window slide past this file */
+		slurm_mutex_lock(&prefetch.mutex);
+		prefetch.merged = file_inx++;
+		slurm_cond_broadcast(&prefetch.cond);
+		slurm_mutex_unlock(&prefetch.mutex);
 
 		/* make a group for each step */
 		if (sh5util_file->step_id != last_step) {
@@ -727,12 +835,8 @@ static int _merge_step_files(void)
 		node_cnt++;
 
 		/* append onto the step */
-		step_path = xstrdup_printf(
-			"%s/%s", step_dir, sh5util_file->file_name);
 		rc = _merge_node_step_data(
 			step_path, jgid_nodes, sh5util_file);
-		xfree(step_path);
-
 	}
 	list_iterator_destroy(itr);
 
@@ -740,6 +844,21 @@ static int _merge_step_files(void)
 
 
 endit:
+	if (prefetch_tids) {
+		slurm_mutex_lock(&prefetch.mutex);
+		prefetch.shutdown = true;
+		slurm_cond_broadcast(&prefetch.cond);
+		slurm_mutex_unlock(&prefetch.mutex);
+		for (i = 0; i < params.threads; i++)
+			pthread_join(prefetch_tids[i], NULL);
+		xfree(prefetch_tids);
+	}
+	for (i = 0; i < prefetch.file_cnt; i++)
+		xfree(prefetch.file_paths[i]);
+	xfree(prefetch.file_paths);
+	slurm_mutex_destroy(&prefetch.mutex);
+	slurm_cond_destroy(&prefetch.cond);
+
 	FREE_NULL_LIST(file_list);
 	xfree(file_name);
 	xfree(step_dir);
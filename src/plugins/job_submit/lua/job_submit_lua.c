@@ -94,19 +94,42 @@ const char plugin_name[]       	= "Job submit lua plugin";
 const char plugin_type[]       	= "job_submit/lua";
 const uint32_t plugin_version   = SLURM_VERSION_NUMBER;
 
+#define DEFAULT_LUA_STATES 1
+
+/*
+ * Each lua_State in the pool is used by one thread at a time. The script is
+ * loaded separately into every state, so global variables set by the script
+ * are not shared between states.
+ */
+typedef struct {
+	bool in_use;
+	lua_State *L;
+	uint32_t script_gen;	/* lua_script_gen this state was loaded from */
+	time_t last_jobs_update;	/* last_job_update seen by slurm.jobs */
+	time_t last_resv_update;	/* last_resv_update seen by
+					 * slurm.reservations */
+} lua_pool_state_t;
+
 static const char lua_script_path[] = DEFAULT_SCRIPT_DIR "/job_submit.lua";
 static time_t lua_script_last_loaded = (time_t) 0;
-static lua_State *L = NULL;
-static char *user_msg = NULL;
+static time_t lua_script_last_failed = (time_t) 0;
+static uint32_t lua_script_gen = 0;
+
+static lua_pool_state_t *lua_pool = NULL;
+static int lua_pool_size = 0;
 
-time_t last_lua_jobs_update = (time_t) 0;
-time_t last_lua_resv_update = (time_t) 0;
+/* State held by the calling thread, set by _acquire_state() */
+static __thread lua_pool_state_t *lua_state = NULL;
+static __thread lua_State *L = NULL;
+static __thread char *user_msg = NULL;
 
 /*
- *  Mutex for protecting multi-threaded access to this plugin.
- *   (Only 1 thread at a time should be in here)
+ *  Mutex and condition protecting the pool of lua states and the script
+ *   load bookkeeping above. The lua states themselves are only touched by
+ *   the thread that acquired them.
  */
 static pthread_mutex_t lua_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t lua_cond = PTHREAD_COND_INITIALIZER;
 
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
@@ -446,7 +469,7 @@ static void _update_jobs_global(void)
 	ListIterator iter;
 	struct job_record *job_ptr;
 
-	if (last_lua_jobs_update >= last_job_update) {
+	if (lua_state->last_jobs_update >= last_job_update) {
 		return;
 	}
 
@@ -475,7 +498,7 @@ static void _update_jobs_global(void)
 		         "%d", job_ptr->job_id);
 		lua_setfield(L, -2, job_id_buf);
 	}
-	last_lua_jobs_update = last_job_update;
+	lua_state->last_jobs_update = last_job_update;
 	list_iterator_destroy(iter);
 
 	lua_setfield(L, -2, "jobs");
@@ -542,7 +565,7 @@ static void _update_resvs_global(void)
 	ListIterator iter;
 	slurmctld_resv_t *resv_ptr;
 
-	if (last_lua_resv_update >= last_resv_update) {
+	if (lua_state->last_resv_update >= last_resv_update) {
 		return;
 	}
 
@@ -568,7 +591,7 @@ static void _update_resvs_global(void)
 
 		lua_setfield(L, -2, resv_ptr->name);
 	}
-	last_lua_resv_update = last_resv_update;
+	lua_state->last_resv_update = last_resv_update;
 	list_iterator_destroy(iter);
 
 	lua_setfield(L, -2, "reservations");
@@ -1461,9 +1484,9 @@ static void _register_lua_slurm_output_functions (void)
 
 	lua_setglobal (L, "slurm");
 
-	last_lua_jobs_update = 0;
+	lua_state->last_jobs_update = 0;
 	_update_jobs_global();
-	last_lua_resv_update = 0;
+	lua_state->last_resv_update = 0;
 	_update_resvs_global();
 }
 
@@ -1520,6 +1543,21 @@ static int _check_lua_script_functions(void)
 	return (rc);
 }
 
+/* Remember a script that failed to load so other states do not retry it */
+static void _load_failed(time_t mtime)
+{
+	slurm_mutex_lock(&lua_lock);
+	lua_script_last_failed = mtime;
+	slurm_mutex_unlock(&lua_lock);
+}
+
+/*
+ * Load the script into the calling thread's lua state if it has changed.
+ * The first state to see a new script validates it and bumps
+ * lua_script_gen, the other states in the pool pick up that generation the
+ * next time they are used. A script that fails to load leaves every state
+ * running the previous one.
+ */
 static int _load_script(void)
 {
 	int rc = SLURM_SUCCESS;
@@ -1536,10 +1574,16 @@ static int _load_script(void)
 		return error("Unable to stat %s: %s",
 		             lua_script_path, strerror(errno));
 	}
-	
-	if (st.st_mtime <= lua_script_last_loaded) {
+
+	slurm_mutex_lock(&lua_lock);
+	if (L_orig &&
+	    (((st.st_mtime <= lua_script_last_loaded) &&
+	      (lua_state->script_gen == lua_script_gen)) ||
+	     (st.st_mtime == lua_script_last_failed))) {
+		slurm_mutex_unlock(&lua_lock);
 		return SLURM_SUCCESS;
 	}
+	slurm_mutex_unlock(&lua_lock);
 
 	/*
 	 *  Initilize lua
@@ -1550,6 +1594,7 @@ static int _load_script(void)
 		if (L_orig) {
 			(void) error("lua: %s: %s, using previous script",
 			             lua_script_path, lua_tostring(L, -1));
+			_load_failed(st.st_mtime);
 			lua_close(L);
 			L = L_orig;
 			return SLURM_SUCCESS;
@@ -1575,6 +1620,7 @@ static int _load_script(void)
 			(void) error("job_submit/lua: %s: %s, "
 			             "using previous script",
 			             lua_script_path, lua_tostring(L, -1));
+			_load_failed(st.st_mtime);
 			lua_close(L);
 			L = L_orig;
 			return SLURM_SUCCESS;
@@ -1594,6 +1640,7 @@ static int _load_script(void)
 			(void) error("job_submit/lua: %s: returned %d "
 			             "on load, using previous script",
 			             lua_script_path, rc);
+			_load_failed(st.st_mtime);
 			lua_close(L);
 			L = L_orig;
 			return SLURM_SUCCESS;
@@ -1614,6 +1661,7 @@ static int _load_script(void)
 			             "required function(s) not present, "
 			             "using previous script",
 			             lua_script_path);
+			_load_failed(st.st_mtime);
 			lua_close(L);
 			L = L_orig;
 			return SLURM_SUCCESS;
@@ -1623,10 +1671,75 @@ static int _load_script(void)
 
 	if (L_orig)
 		lua_close(L_orig);
-	lua_script_last_loaded = time(NULL);
+	lua_state->L = L;
+
+	slurm_mutex_lock(&lua_lock);
+	if (st.st_mtime > lua_script_last_loaded) {
+		lua_script_last_loaded = st.st_mtime;
+		lua_script_gen++;
+	}
+	lua_state->script_gen = lua_script_gen;
+	slurm_mutex_unlock(&lua_lock);
+
 	return SLURM_SUCCESS;
 }
 
+/* Get the number of lua states from SchedulerParameters */
+static int _get_pool_size(void)
+{
+	char *params = slurm_get_sched_params();
+	char *opt;
+	int size = DEFAULT_LUA_STATES;
+
+	/*                                   01234567890123456789012 */
+	if (params && (opt = strstr(params, "job_submit_lua_states="))) {
+		size = atoi(opt + 22);
+		if (size < 1) {
+			error("job_submit/lua: Invalid job_submit_lua_states, "
+			      "using %d", DEFAULT_LUA_STATES);
+			size = DEFAULT_LUA_STATES;
+		}
+	}
+	xfree(params);
+
+	return size;
+}
+
+/*
+ * Wait for an idle lua state and make it the calling thread's state.
+ */
+static void _acquire_state(void)
+{
+	int i;
+
+	slurm_mutex_lock(&lua_lock);
+	while (true) {
+		for (i = 0; i < lua_pool_size; i++) {
+			if (!lua_pool[i].in_use)
+				break;
+		}
+		if (i < lua_pool_size)
+			break;
+		slurm_cond_wait(&lua_cond, &lua_lock);
+	}
+	lua_pool[i].in_use = true;
+	slurm_mutex_unlock(&lua_lock);
+
+	lua_state = &lua_pool[i];
+	L = lua_state->L;
+}
+
+static void _release_state(void)
+{
+	slurm_mutex_lock(&lua_lock);
+	lua_state->in_use = false;
+	slurm_cond_signal(&lua_cond);
+	slurm_mutex_unlock(&lua_lock);
+
+	lua_state = NULL;
+	L = NULL;
+}
+
 /*
  *  NOTE: The init callback should never be called multiple times,
  *   let alone called from multiple threads. Therefore, locking
@@ -1634,7 +1747,7 @@ static int _load_script(void)
  */
 int init(void)
 {
-	int rc = SLURM_SUCCESS;
+	int i, rc = SLURM_SUCCESS;
 
 	/*
 	 * Need to dlopen() the Lua library to ensure plugins see
@@ -1643,12 +1756,32 @@ int init(void)
 	if ((rc = xlua_dlopen()) != SLURM_SUCCESS)
 		return rc;
 
-	return _load_script();
+	lua_pool_size = _get_pool_size();
+	lua_pool = xmalloc(sizeof(lua_pool_state_t) * lua_pool_size);
+	for (i = 0; (i < lua_pool_size) && (rc == SLURM_SUCCESS); i++) {
+		lua_state = &lua_pool[i];
+		L = NULL;
+		rc = _load_script();
+	}
+	lua_state = NULL;
+	L = NULL;
+	if (lua_pool_size > 1)
+		debug("job_submit/lua: loaded %d lua states", lua_pool_size);
+
+	return rc;
 }
 
 int fini(void)
 {
-	lua_close (L);
+	int i;
+
+	for (i = 0; i < lua_pool_size; i++) {
+		if (lua_pool[i].L)
+			lua_close(lua_pool[i].L);
+	}
+	xfree(lua_pool);
+	lua_pool_size = 0;
+
 	return SLURM_SUCCESS;
 }
 
@@ -1658,7 +1791,7 @@ extern int job_submit(struct job_descriptor *job_desc, uint32_t submit_uid,
 		      char **err_msg)
 {
 	int rc = SLURM_ERROR;
-	slurm_mutex_lock (&lua_lock);
+	_acquire_state();
 
 	(void) _load_script();
 
@@ -1696,7 +1829,7 @@ extern int job_submit(struct job_descriptor *job_desc, uint32_t submit_uid,
 		user_msg = NULL;
 	}
 
-out:	slurm_mutex_unlock (&lua_lock);
+out:	_release_state();
 	return rc;
 }
 
@@ -1705,7 +1838,7 @@ extern int job_modify(struct job_descriptor *job_desc,
 		      struct job_record *job_ptr, uint32_t submit_uid)
 {
 	int rc = SLURM_ERROR;
-	slurm_mutex_lock (&lua_lock);
+	_acquire_state();
 
 	/*
 	 *  All lua script functions should have been verified during
@@ -1743,6 +1876,6 @@ extern int job_modify(struct job_descriptor *job_desc,
 		xfree(user_msg);
 	}
 
-out:	slurm_mutex_unlock (&lua_lock);
+out:	_release_state();
 	return rc;
 }
@@ -40,13 +40,39 @@
 #endif
 
 #include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <unistd.h>
 
+#include "src/common/macros.h"
 #include "fair_tree.h"
 
+/* User associations per worker thread when sorting the tree in parallel */
+#define FT_USERS_PER_THREAD	5000
+#define FT_MAX_THREADS		8
+
+/* The children of an account, sorted by level_fs */
+typedef struct {
+	slurmdb_assoc_rec_t *assoc;
+	slurmdb_assoc_rec_t **children;	/* NULL terminated */
+	size_t child_cnt;
+} ft_level_t;
+
+/* The sorted levels of the association tree, see _calc_levels() */
+typedef struct {
+	ft_level_t *levels;		/* open addressing, index by assoc */
+	uint32_t level_cnt;
+	uint32_t size;			/* power of 2 */
+	size_t next_subtree;		/* next child of root to process */
+	ft_level_t root;		/* children of root, owned by levels */
+	pthread_mutex_t mutex;
+} ft_tree_t;
+
 static int  _ft_decay_apply_new_usage(struct job_record *job, time_t *start);
 static void _apply_priority_fs(void);
 
+static int ft_max_threads = -1;	/* worker threads, set on first use */
+
 /* Fair Tree code called from the decay thread loop */
 extern void fair_tree_decay(List jobs, time_t start)
 {
@@ -235,6 +261,158 @@ static slurmdb_assoc_rec_t** _append_list_to_array(
 	return merged;
 }
 
+static uint32_t _level_hash(slurmdb_assoc_rec_t *assoc, uint32_t size)
+{
+	uintptr_t key = (uintptr_t) assoc;
+
+	return (uint32_t) ((key >> 4) ^ (key >> 16)) & (size - 1);
+}
+
+static void _level_insert(ft_level_t *levels, uint32_t size, ft_level_t *level)
+{
+	uint32_t inx;
+
+	for (inx = _level_hash(level->assoc, size); levels[inx].assoc;
+	     inx = (inx + 1) & (size - 1))
+		;
+	levels[inx] = *level;
+}
+
+/* Add the sorted children of an account to the tree. Thread safe. */
+static void _add_level(ft_tree_t *tree, ft_level_t *level)
+{
+	ft_level_t *old_levels;
+	uint32_t i, old_size;
+
+	slurm_mutex_lock(&tree->mutex);
+	if ((tree->level_cnt + 1) * 2 > tree->size) {
+		old_levels = tree->levels;
+		old_size = tree->size;
+		tree->size = MAX(1024, tree->size * 2);
+		tree->levels = xmalloc(sizeof(ft_level_t) * tree->size);
+		for (i = 0; i < old_size; i++) {
+			if (old_levels[i].assoc)
+				_level_insert(tree->levels, tree->size,
+					      &old_levels[i]);
+		}
+		xfree(old_levels);
+	}
+	_level_insert(tree->levels, tree->size, level);
+	tree->level_cnt++;
+	slurm_mutex_unlock(&tree->mutex);
+}
+
+static ft_level_t *_find_level(ft_tree_t *tree, slurmdb_assoc_rec_t *assoc)
+{
+	uint32_t inx;
+
+	if (!tree->size)
+		return NULL;
+	for (inx = _level_hash(assoc, tree->size); tree->levels[inx].assoc;
+	     inx = (inx + 1) & (tree->size - 1)) {
+		if (tree->levels[inx].assoc == assoc)
+			return &tree->levels[inx];
+	}
+	return NULL;
+}
+
+/* Calculate level_fs for each child of an account, then sort them by
+ * level_fs. If recurse is set, do the same below each child account. */
+static void _calc_level(ft_tree_t *tree, slurmdb_assoc_rec_t *assoc,
+			bool recurse)
+{
+	ft_level_t level;
+	size_t i;
+
+	level.assoc = assoc;
+	level.child_cnt = 0;
+	level.children = xmalloc(sizeof(slurmdb_assoc_rec_t *));
+	if (assoc->usage->children_list) {
+		level.children = _append_list_to_array(
+			assoc->usage->children_list, level.children,
+			&level.child_cnt);
+	}
+
+	for (i = 0; i < level.child_cnt; i++)
+		_calc_assoc_fs(level.children[i]);
+	qsort(level.children, level.child_cnt, sizeof(slurmdb_assoc_rec_t *),
+	      _cmp_level_fs);
+	_add_level(tree, &level);
+
+	if (!recurse)
+		return;
+	for (i = 0; i < level.child_cnt; i++) {
+		if (!level.children[i]->user)
+			_calc_level(tree, level.children[i], true);
+	}
+}
+
+/* Worker thread processing the subtrees below root, one at a time */
+static void *_calc_levels_thread(void *arg)
+{
+	ft_tree_t *tree = (ft_tree_t *) arg;
+	slurmdb_assoc_rec_t *assoc;
+
+	while (1) {
+		slurm_mutex_lock(&tree->mutex);
+		if (tree->next_subtree < tree->root.child_cnt)
+			assoc = tree->root.children[tree->next_subtree++];
+		else
+			assoc = NULL;
+		slurm_mutex_unlock(&tree->mutex);
+		if (!assoc)
+			break;
+		if (!assoc->user)
+			_calc_level(tree, assoc, true);
+	}
+
+	return NULL;
+}
+
+/* Calculate level_fs for every association and sort the children of every
+ * account. The level_fs of an association only depends on its own usage and
+ * that of its parent, so the subtrees below root of a large tree are handed
+ * out to worker threads. Call assoc_mgr_lock before this.
+ * OUT tree - sorted levels, free with _free_levels()
+ */
+static void _calc_levels(ft_tree_t *tree)
+{
+	pthread_t tids[FT_MAX_THREADS];
+	int i, threads;
+
+	memset(tree, 0, sizeof(ft_tree_t));
+	slurm_mutex_init(&tree->mutex);
+
+	if (ft_max_threads < 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		ft_max_threads = MIN(MAX(cpus, 1), FT_MAX_THREADS);
+	}
+
+	_calc_level(tree, assoc_mgr_root_assoc, false);
+	tree->root = *_find_level(tree, assoc_mgr_root_assoc);
+
+	threads = MIN(ft_max_threads, g_user_assoc_count / FT_USERS_PER_THREAD);
+	threads = MIN(threads, tree->root.child_cnt);
+	if (threads <= 1) {
+		_calc_levels_thread(tree);
+		return;
+	}
+	for (i = 0; i < threads; i++)
+		slurm_thread_create(&tids[i], _calc_levels_thread, tree);
+	for (i = 0; i < threads; i++)
+		pthread_join(tids[i], NULL);
+}
+
+static void _free_levels(ft_tree_t *tree)
+{
+	uint32_t i;
+
+	for (i = 0; i < tree->size; i++)
+		xfree(tree->levels[i].children);
+	xfree(tree->levels);
+	slurm_mutex_destroy(&tree->mutex);
+}
+
 /* Returns number of tied sibling accounts.
  * IN assocs - array of siblings, sorted by level_fs
  * IN begin_ndx - begin looking for ties at this index
@@ -260,7 +438,9 @@ static size_t _count_tied_accounts(slurmdb_assoc_rec_t** assocs,
 }
 
 
-/* Copy the children of accounts [begin, end] into a single array.
+/* Copy the children of accounts [begin, end] into a single array, sorted by
+ * level_fs.
+ * IN tree - sorted levels of the tree
  * IN siblings - array of siblings, sorted by level_fs
  * IN begin - index of first account to merge
  * IN end - index of last account to merge
@@ -268,7 +448,7 @@ static size_t _count_tied_accounts(slurmdb_assoc_rec_t** assocs,
  * RET - Array of the children. Must be freed.
  */
 static slurmdb_assoc_rec_t** _merge_accounts(
-	slurmdb_assoc_rec_t** siblings,
+	ft_tree_t *tree, slurmdb_assoc_rec_t** siblings,
 	size_t begin, size_t end, uint16_t assoc_level)
 {
 	size_t i;
@@ -277,27 +457,33 @@ static slurmdb_assoc_rec_t** _merge_accounts(
 	/* merged is a null terminated array */
 	slurmdb_assoc_rec_t** merged = (slurmdb_assoc_rec_t **)
 		xmalloc(sizeof(slurmdb_assoc_rec_t *));
-	merged[0] = NULL;
+	ft_level_t *level;
 
 	for (i = begin; i <= end; i++) {
-		List children = siblings[i]->usage->children_list;
-
 		/* the first account's debug was already printed */
 		if (priority_debug && i > begin)
 			_ft_debug(siblings[i], assoc_level, true);
 
-		if (!children || list_is_empty(children)) {
+		level = _find_level(tree, siblings[i]);
+		if (!level || !level->child_cnt)
 			continue;
-		}
 
-		merged = _append_list_to_array(children, merged, &merged_size);
+		merged = xrealloc(merged, sizeof(slurmdb_assoc_rec_t *) *
+				  (merged_size + level->child_cnt + 1));
+		memcpy(merged + merged_size, level->children,
+		       sizeof(slurmdb_assoc_rec_t *) * level->child_cnt);
+		merged_size += level->child_cnt;
 	}
+	merged[merged_size] = NULL;
+
+	qsort(merged, merged_size, sizeof(slurmdb_assoc_rec_t *),
+	      _cmp_level_fs);
 	return merged;
 }
 
 
-/* Calculate fairshare for each child then sort children by fairshare value
- * (level_fs). Once they are sorted, operate on each child in sorted order.
+/* Operate on each child in the order of their fairshare value (level_fs),
+ * which were calculated and sorted by _calc_levels().
  * This portion of the tree is now sorted and users are given a fairshare value
  * based on the order they are operated on. The basic equation is
  * (rank / g_user_assoc_count), though ties are allowed. The rank is
@@ -310,13 +496,14 @@ static slurmdb_assoc_rec_t** _merge_accounts(
  *	3) A user with the same level_fs as a sibling account will receive
  *	   the same rank as the account's highest ranked user
  *
- * IN siblings - array of siblings
+ * IN tree - sorted levels of the tree
+ * IN siblings - array of siblings, sorted by level_fs
  * IN assoc_level - depth in the tree (root is 0)
  * IN/OUT rank - current user ranking, starting at g_user_assoc_count
  * IN/OUT rnt - rank, no ties (what rank would be if no tie exists)
  * IN account_tied - is this account tied with the previous user
  */
-static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
+static void _calc_tree_fs(ft_tree_t *tree, slurmdb_assoc_rec_t** siblings,
 			  uint16_t assoc_level, uint32_t *rank,
 			  uint32_t *rnt, bool account_tied)
 {
@@ -325,13 +512,6 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 	bool tied = false;
 	size_t i;
 
-	/* Calculate level_fs for each child */
-	for (i = 0; (assoc = siblings[i]); i++)
-		_calc_assoc_fs(assoc);
-
-	/* Sort children by level_fs */
-	qsort(siblings, i, sizeof(slurmdb_assoc_rec_t *), _cmp_level_fs);
-
 	/* Iterate through children in sorted order. If it's a user, calculate
 	 * fs_factor, otherwise recurse. */
 	for (i = 0; (assoc = siblings[i]); i++) {
@@ -362,15 +542,27 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 		} else {
 			slurmdb_assoc_rec_t** children;
 			size_t merge_count = _count_tied_accounts(siblings, i);
+			ft_level_t *level;
+
+			if (merge_count == 0) {
+				level = _find_level(tree, assoc);
+				if (level) {
+					_calc_tree_fs(tree, level->children,
+						      assoc_level + 1, rank,
+						      rnt, tied);
+				}
+				prev_level_fs = assoc->usage->level_fs;
+				continue;
+			}
 
 			/* Merging does not affect child level_fs calculations
 			 * since the necessary information is stored on each
 			 * assoc's usage struct */
-			children = _merge_accounts(siblings, i,
+			children = _merge_accounts(tree, siblings, i,
 						   i + merge_count,
 						   assoc_level);
 
-			_calc_tree_fs(children, assoc_level+1,
+			_calc_tree_fs(tree, children, assoc_level+1,
 				      rank, rnt, tied);
 
 			/* Skip over any merged accounts */
@@ -387,23 +579,16 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 /* Start fairshare calculations at root. Call assoc_mgr_lock before this. */
 static void _apply_priority_fs(void)
 {
-	slurmdb_assoc_rec_t** children = NULL;
+	ft_tree_t tree;
 	uint32_t rank = g_user_assoc_count;
 	uint32_t rnt = rank;
-	size_t child_count = 0;
 
 	if (priority_debug)
 		info("Fair Tree fairshare algorithm, starting at root:");
 
 	assoc_mgr_root_assoc->usage->level_fs = (long double) NO_VAL;
 
-	/* _calc_tree_fs requires an array instead of List */
-	children = _append_list_to_array(
-		assoc_mgr_root_assoc->usage->children_list,
-		children,
-		&child_count);
-
-	_calc_tree_fs(children, 0, &rank, &rnt, false);
-
-	xfree(children);
+	_calc_levels(&tree);
+	_calc_tree_fs(&tree, tree.root.children, 0, &rank, &rnt, false);
+	_free_levels(&tree);
 }
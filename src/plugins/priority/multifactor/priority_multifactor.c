@@ -147,6 +147,8 @@ static uint32_t flags;       /* Priority Flags */
 static uint32_t prevflags;    /* Priority Flags before _internal_setup() resets
 			       * flags after a reconfigure */
 static time_t g_last_ran = 0; /* when the last poll ran */
+static uint32_t prio_gen = 0;  /* changed with the configuration, see
+				* _job_prio_sig() */
 static double decay_factor = 1; /* The decay factor when decaying time. */
 
 /* variables defined in prirority_multifactor.h */
@@ -490,6 +492,155 @@ static double _get_fairshare_priority(struct job_record *job_ptr)
 	return priority_fs;
 }
 
+/* Returns the age factor of a job, 0 -> 1 */
+static double _get_age_priority(time_t start_time, struct job_record *job_ptr)
+{
+	uint32_t diff = 0;
+	time_t use_time;
+
+	if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
+		use_time = job_ptr->details->submit_time;
+	else
+		use_time = job_ptr->details->begin_time;
+
+	/* Only really add an age priority if the use_time is
+	   past the start_time.
+	*/
+	if (start_time > use_time)
+		diff = start_time - use_time;
+
+	if (!job_ptr->details->begin_time &&
+	    !(flags & PRIORITY_FLAGS_ACCRUE_ALWAYS))
+		return 0.0;
+	if (diff < max_age)
+		return (double)diff / (double)max_age;
+	return 1.0;
+}
+
+static uint32_t _sig_add(uint32_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ p[i]) * 16777619U;
+	return hash;
+}
+
+/*
+ * Hash all inputs of a job's priority other than its age: the configuration,
+ * its fairshare factor and its QOS, partition and size. While the signature
+ * does not change, only the age factor of the job needs to be recalculated.
+ * RET the signature, never 0
+ */
+static uint32_t _job_prio_sig(struct job_record *job_ptr, double fs_factor)
+{
+	struct job_details *details = job_ptr->details;
+	struct part_record *part_ptr = job_ptr->part_ptr;
+	slurmdb_qos_rec_t *qos_ptr = job_ptr->qos_ptr;
+	uint64_t *tres_cnt;
+	uint32_t hash = 2166136261U;
+
+#define _SIG_ADD(_v) hash = _sig_add(hash, &(_v), sizeof(_v))
+	_SIG_ADD(prio_gen);
+	_SIG_ADD(cluster_cpus);
+	_SIG_ADD(node_record_count);
+	_SIG_ADD(slurmctld_tres_cnt);
+	_SIG_ADD(fs_factor);
+	_SIG_ADD(job_ptr->assoc_ptr);
+	_SIG_ADD(job_ptr->total_cpus);
+	_SIG_ADD(job_ptr->time_limit);
+	_SIG_ADD(details->begin_time);
+	_SIG_ADD(details->submit_time);
+	_SIG_ADD(details->max_cpus);
+	_SIG_ADD(details->min_cpus);
+	_SIG_ADD(details->min_nodes);
+	_SIG_ADD(details->nice);
+	_SIG_ADD(qos_ptr);
+	if (qos_ptr) {
+		_SIG_ADD(qos_ptr->priority);
+		_SIG_ADD(qos_ptr->usage->norm_priority);
+	}
+	_SIG_ADD(part_ptr);
+	if (part_ptr) {
+		_SIG_ADD(part_ptr->max_time);
+		_SIG_ADD(part_ptr->norm_priority);
+		_SIG_ADD(part_ptr->priority_job_factor);
+		if (weight_tres && part_ptr->tres_cnt) {
+			hash = _sig_add(hash, part_ptr->tres_cnt,
+					sizeof(uint64_t) * slurmctld_tres_cnt);
+		}
+	}
+	if (weight_tres) {
+		tres_cnt = job_ptr->tres_alloc_cnt ? job_ptr->tres_alloc_cnt :
+						     job_ptr->tres_req_cnt;
+		_SIG_ADD(tres_cnt);
+		if (tres_cnt) {
+			hash = _sig_add(hash, tres_cnt,
+					sizeof(uint64_t) * slurmctld_tres_cnt);
+		}
+	}
+#undef _SIG_ADD
+
+	return hash ? hash : 1;
+}
+
+/*
+ * Recalculate the priority of a job whose inputs other than its age did not
+ * change since the last calculation, reusing its weighted factors
+ * RET true if new_prio was set, false if a full calculation is needed
+ */
+static bool _get_priority_age_only(time_t start_time,
+				   struct job_record *job_ptr,
+				   uint32_t *new_prio)
+{
+	priority_factors_object_t *factors = job_ptr->prio_factors;
+	double fs_factor = 0.0, priority, tmp_tres = 0.0;
+	uint64_t tmp_64;
+	int i;
+
+	if (!job_ptr->prio_sig || !factors || !job_ptr->details ||
+	    job_ptr->part_ptr_list || job_ptr->direct_set_prio ||
+	    priority_debug)
+		return false;
+
+	if (job_ptr->assoc_ptr && weight_fs)
+		fs_factor = _get_fairshare_priority(job_ptr);
+	if (_job_prio_sig(job_ptr, fs_factor) != job_ptr->prio_sig)
+		return false;
+
+	if (weight_age) {
+		factors->priority_age = _get_age_priority(start_time, job_ptr) *
+					(double)weight_age;
+	}
+	if (weight_tres && factors->priority_tres) {
+		for (i = 0; i < slurmctld_tres_cnt; i++)
+			tmp_tres += factors->priority_tres[i];
+	}
+
+	/* Same as _get_priority_internal() */
+	priority = factors->priority_age
+		+ factors->priority_fs
+		+ factors->priority_js
+		+ factors->priority_part
+		+ factors->priority_qos
+		+ tmp_tres
+		- (double)(((int64_t)factors->nice) - NICE_OFFSET);
+
+	/* Priority 0 is reserved for held jobs */
+	if (priority < 1)
+		priority = 1;
+
+	tmp_64 = (uint64_t) priority;
+	if (tmp_64 > 0xffffffff) {
+		error("Job %u priority exceeds 32 bits", job_ptr->job_id);
+		priority = (double) 0xffffffff;
+	}
+
+	*new_prio = (uint32_t) priority;
+	return true;
+}
+
 /* Returns the priority after applying the weight factors */
 static uint32_t _get_priority_internal(time_t start_time,
 				       struct job_record *job_ptr)
@@ -499,6 +650,7 @@ static uint32_t _get_priority_internal(time_t start_time,
 	uint64_t tmp_64;
 	double tmp_tres = 0.0;
 
+	job_ptr->prio_sig = 0;
 	if (job_ptr->direct_set_prio && (job_ptr->priority > 0)) {
 		if (job_ptr->prio_factors) {
 			xfree(job_ptr->prio_factors->tres_weights);
@@ -523,6 +675,10 @@ static uint32_t _get_priority_internal(time_t start_time,
 	}
 
 	set_priority_factors(start_time, job_ptr);
+	if (!job_ptr->part_ptr_list) {
+		job_ptr->prio_sig = _job_prio_sig(job_ptr,
+					job_ptr->prio_factors->priority_fs);
+	}
 
 	if (priority_debug) {
 		memcpy(&pre_factors, job_ptr->prio_factors,
@@ -1488,6 +1644,7 @@ static void _internal_setup(void)
 	}
 	xfree(tres_weights_str);
 	flags = slurm_get_priority_flags();
+	prio_gen++;	/* recalculate all job priorities in full */
 
 	if (priority_debug) {
 		info("priority: Damp Factor is %u", damp_factor);
@@ -1992,7 +2149,8 @@ extern int decay_apply_weighted_factors(struct job_record *job_ptr,
 	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
 		return SLURM_SUCCESS;
 
-	new_prio = _get_priority_internal(*start_time_ptr, job_ptr);
+	if (!_get_priority_age_only(*start_time_ptr, job_ptr, &new_prio))
+		new_prio = _get_priority_internal(*start_time_ptr, job_ptr);
 	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
 	    (job_ptr->priority < new_prio)) {
 		job_ptr->priority = new_prio;
@@ -2025,28 +2183,8 @@ extern void set_priority_factors(time_t start_time, struct job_record *job_ptr)
 	qos_ptr = job_ptr->qos_ptr;
 
 	if (weight_age) {
-		uint32_t diff = 0;
-		time_t use_time;
-
-		if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
-			use_time = job_ptr->details->submit_time;
-		else
-			use_time = job_ptr->details->begin_time;
-
-		/* Only really add an age priority if the use_time is
-		   past the start_time.
-		*/
-		if (start_time > use_time)
-			diff = start_time - use_time;
-
-		if (job_ptr->details->begin_time
-		    || (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)) {
-			if (diff < max_age) {
-				job_ptr->prio_factors->priority_age =
-					(double)diff / (double)max_age;
-			} else
-				job_ptr->prio_factors->priority_age = 1.0;
-		}
+		job_ptr->prio_factors->priority_age =
+			_get_age_priority(start_time, job_ptr);
 	}
 
 	if (job_ptr->assoc_ptr && weight_fs) {
@@ -213,6 +213,10 @@ static void _pack_start_set(struct job_record *job_ptr, time_t latest_start,
 static void _pack_start_test(node_space_map_t *node_space);
 static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
 				  node_space_map_t *node_space);
+static void _sched_class_fail(sched_class_tbl_t *tbl,
+			      struct job_record *job_ptr,
+			      uint32_t job_no_reserve, uint32_t orig_time_limit,
+			      int error_code, time_t start_time);
 static int  _start_job(struct job_record *job_ptr, bitstr_t *avail_bitmap);
 static bool _test_resv_overlap(node_space_map_t *node_space,
 			       bitstr_t *use_bitmap, uint32_t start_time,
@@ -1051,6 +1055,8 @@ static int _attempt_backfill(void)
 	int part_inx = -1, user_inx = -1;
 	uint32_t qos_flags = 0;
 	time_t qos_blocked_until = 0, qos_part_blocked_until = 0;
+	sched_class_tbl_t *failed_class = NULL;
+	time_t class_start_time;
 	/* QOS Read lock */
 	assoc_mgr_lock_t qos_read_lock =
 		{ NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
@@ -1178,7 +1184,7 @@ static int _attempt_backfill(void)
 		assoc_mgr_unlock(&qos_read_lock);
 	}
 
-	sort_job_queue(job_queue);
+	failed_class = sched_class_tbl_create();
 	while (1) {
 		uint32_t bf_job_id, bf_array_task_id, bf_job_priority;
 
@@ -1225,6 +1231,8 @@ static int _attempt_backfill(void)
 			}
 			if (stop_backfill)
 				break;
+			/* Resources may have been released, retest classes */
+			sched_class_tbl_clear(failed_class);
 			/* Reset backfill scheduling timers, resume testing */
 			sched_start = time(NULL);
 			gettimeofday(&start_tv, NULL);
@@ -1626,6 +1634,23 @@ next_task:
 			deadline_time_limit = (job_ptr->deadline - now) / 60;
 		}
 
+		/* Reuse the result of a job with the same requirements */
+		if (sched_class_failed(failed_class, job_ptr, job_no_reserve,
+				       NULL, NULL, &class_start_time)) {
+			if (debug_flags & DEBUG_FLAG_BACKFILL)
+				info("backfill: job %u has the requirements of "
+				     "a job which could not start",
+				     job_ptr->job_id);
+			slurmctld_diag_stats.bf_class_skip++;
+			if (class_start_time &&
+			    ((orig_start_time == 0) ||
+			     (class_start_time < orig_start_time)))
+				job_ptr->start_time = class_start_time;
+			else
+				job_ptr->start_time = orig_start_time;
+			continue;
+		}
+
 		/* Determine job's expected completion time */
 		if (part_ptr->max_time == INFINITE)
 			part_time_limit = YEAR_MINUTES;
@@ -1706,6 +1731,8 @@ next_task:
 			if (stop_backfill)
 				break;
 
+			/* Resources may have been released, retest classes */
+			sched_class_tbl_clear(failed_class);
 			/* Reset backfill scheduling timers, resume testing */
 			sched_start = time(NULL);
 			gettimeofday(&start_tv, NULL);
@@ -1802,6 +1829,8 @@ next_task:
 
 			/* Job can not start until too far in the future */
 			_set_job_time_limit(job_ptr, orig_time_limit);
+			_sched_class_fail(failed_class, job_ptr, job_no_reserve,
+					  orig_time_limit, ESLURM_NODES_BUSY, 0);
 			job_ptr->start_time = 0;
 			if ((orig_start_time != 0) &&
 			    (orig_start_time < job_ptr->start_time)) {
@@ -1913,6 +1942,8 @@ next_task:
 				job_ptr->start_time = 0;
 				goto TRY_LATER;
 			}
+			_sched_class_fail(failed_class, job_ptr, job_no_reserve,
+					  orig_time_limit, j, 0);
 			if (orig_start_time != 0)  /* Can start in other part */
 				job_ptr->start_time = orig_start_time;
 			else
@@ -2123,6 +2154,9 @@ skip_start:
 		}
 
 		if ((job_ptr->start_time > now) && (job_no_reserve != 0)) {
+			_sched_class_fail(failed_class, job_ptr, job_no_reserve,
+					  orig_time_limit, ESLURM_NODES_BUSY,
+					  job_ptr->start_time);
 			if ((orig_start_time != 0) &&
 			    (orig_start_time < job_ptr->start_time)) {
 				/* Can start earlier in different partition */
@@ -2155,6 +2189,9 @@ skip_start:
 			if (debug_flags & DEBUG_FLAG_BACKFILL)
 				_dump_job_sched(job_ptr, end_reserve,
 						avail_bitmap);
+			_sched_class_fail(failed_class, job_ptr, job_no_reserve,
+					  orig_time_limit, ESLURM_NODES_BUSY,
+					  job_ptr->start_time);
 			if ((orig_start_time != 0) &&
 			    (orig_start_time < job_ptr->start_time)) {
 				/* Can start earlier in different partition */
@@ -2338,6 +2375,7 @@ skip_start:
 	}
 	xfree(node_space);
 	FREE_NULL_LIST(job_queue);
+	sched_class_tbl_destroy(failed_class);
 
 	gettimeofday(&bf_time2, NULL);
 	_do_diag_stats(&bf_time1, &bf_time2);
@@ -2355,6 +2393,23 @@ skip_start:
 	return rc;
 }
 
+/*
+ * Record that a job could not be started, see sched_class_fail(). Its time
+ * limit may have been changed while testing, but its class is defined by the
+ * original value.
+ */
+static void _sched_class_fail(sched_class_tbl_t *tbl,
+			      struct job_record *job_ptr,
+			      uint32_t job_no_reserve, uint32_t orig_time_limit,
+			      int error_code, time_t start_time)
+{
+	uint32_t save_time_limit = job_ptr->time_limit;
+
+	job_ptr->time_limit = orig_time_limit;
+	sched_class_fail(tbl, job_ptr, job_no_reserve, error_code, start_time);
+	job_ptr->time_limit = save_time_limit;
+}
+
 /* Try to start the job on any non-reserved nodes */
 static int _start_job(struct job_record *job_ptr, bitstr_t *resv_bitmap)
 {
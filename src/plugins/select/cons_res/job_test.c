@@ -761,8 +761,7 @@ static int _is_node_busy(struct part_res_record *p_ptr, uint32_t node_i,
 			 int sharing_only, struct part_record *my_part_ptr,
 			 bool qos_preemptor)
 {
-	uint32_t r, cpu_begin = cr_get_coremap_offset(node_i);
-	uint32_t i, cpu_end   = cr_get_coremap_offset(node_i+1);
+	uint32_t r;
 	uint16_t num_rows;
 
 	for (; p_ptr; p_ptr = p_ptr->next) {
@@ -775,12 +774,9 @@ static int _is_node_busy(struct part_res_record *p_ptr, uint32_t node_i,
 		if (!p_ptr->row)
 			continue;
 		for (r = 0; r < num_rows; r++) {
-			if (!p_ptr->row[r].row_bitmap)
-				continue;
-			for (i = cpu_begin; i < cpu_end; i++) {
-				if (bit_test(p_ptr->row[r].row_bitmap, i))
-					return 1;
-			}
+			if (p_ptr->row[r].node_bitmap &&
+			    bit_test(p_ptr->row[r].node_bitmap, node_i))
+				return 1;
 		}
 	}
 	return 0;
@@ -328,6 +328,9 @@ static struct part_row_data *_dup_row_data(struct part_row_data *orig_row,
 		if (orig_row[i].row_bitmap)
 			new_row[i].row_bitmap = bit_copy(orig_row[i].
 							 row_bitmap);
+		if (orig_row[i].node_bitmap)
+			new_row[i].node_bitmap = bit_copy(orig_row[i].
+							  node_bitmap);
 		if (new_row[i].job_list_size == 0)
 			continue;
 		/* copy the job list */
@@ -354,8 +357,9 @@ static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr)
 	while (orig_ptr) {
 		new_ptr->part_ptr = orig_ptr->part_ptr;
 		new_ptr->num_rows = orig_ptr->num_rows;
-		new_ptr->row = _dup_row_data(orig_ptr->row,
-					     orig_ptr->num_rows);
+		/* rows are copied by _own_part_rows() when first updated */
+		new_ptr->row = orig_ptr->row;
+		new_ptr->rows_shared = true;
 		if (orig_ptr->next) {
 			new_ptr->next = xmalloc(sizeof(struct part_res_record));
 			new_ptr = new_ptr->next;
@@ -366,11 +370,20 @@ static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr)
 }
 
 
-/* Create a duplicate part_res_record list */
+/* Give a partition record duplicated by _dup_part_data() its own rows */
+static void _own_part_rows(struct part_res_record *p_ptr)
+{
+	if (!p_ptr->rows_shared)
+		return;
+	p_ptr->row = _dup_row_data(p_ptr->row, p_ptr->num_rows);
+	p_ptr->rows_shared = false;
+}
+
+
+/* Create a duplicate node_use_record array */
 static struct node_use_record *_dup_node_usage(struct node_use_record *orig_ptr)
 {
 	struct node_use_record *new_use_ptr, *new_ptr;
-	List gres_list;
 	uint32_t i;
 
 	if (orig_ptr == NULL)
@@ -382,20 +395,41 @@ static struct node_use_record *_dup_node_usage(struct node_use_record *orig_ptr)
 	for (i = 0; i < select_node_cnt; i++) {
 		new_ptr[i].node_state   = orig_ptr[i].node_state;
 		new_ptr[i].alloc_memory = orig_ptr[i].alloc_memory;
-		if (orig_ptr[i].gres_list)
-			gres_list = orig_ptr[i].gres_list;
-		else
-			gres_list = node_record_table_ptr[i].gres_list;
-		new_ptr[i].gres_list = gres_plugin_node_state_dup(gres_list);
+		if (orig_ptr[i].gres_list) {
+			new_ptr[i].gres_list =
+				gres_plugin_node_state_dup(orig_ptr[i].
+							   gres_list);
+		} else {
+			/* gres_list is copied by _get_node_gres_list() when
+			 * first updated */
+			new_ptr[i].gres_list_shared = true;
+		}
 	}
 	return new_use_ptr;
 }
 
+
+/* Return the gres_list of a node, if it is to be updated and still shared
+ * copy it first */
+static List _get_node_gres_list(struct node_use_record *node_usage, int i,
+				bool update)
+{
+	if (update && node_usage[i].gres_list_shared) {
+		node_usage[i].gres_list = gres_plugin_node_state_dup(
+			node_record_table_ptr[i].gres_list);
+		node_usage[i].gres_list_shared = false;
+	}
+	if (node_usage[i].gres_list)
+		return node_usage[i].gres_list;
+	return node_record_table_ptr[i].gres_list;
+}
+
 /* delete the given row data */
 static void _destroy_row_data(struct part_row_data *row, uint16_t num_rows) {
 	uint16_t i;
 	for (i = 0; i < num_rows; i++) {
 		FREE_NULL_BITMAP(row[i].row_bitmap);
+		FREE_NULL_BITMAP(row[i].node_bitmap);
 		xfree(row[i].job_list);
 	}
 	xfree(row);
@@ -409,10 +443,9 @@ static void _destroy_part_data(struct part_res_record *this_ptr)
 		this_ptr = this_ptr->next;
 		tmp->part_ptr = NULL;
 
-		if (tmp->row) {
+		if (tmp->row && !tmp->rows_shared)
 			_destroy_row_data(tmp->row, tmp->num_rows);
-			tmp->row = NULL;
-		}
+		tmp->row = NULL;
 		xfree(tmp);
 	}
 }
@@ -506,16 +539,77 @@ static void _destroy_node_data(struct node_use_record *node_usage,
 }
 
 
+/* clear the row_bitmap and node_bitmap of a row */
+static void _clear_row_bitmaps(struct part_row_data *r_ptr)
+{
+	if (r_ptr->row_bitmap)
+		bit_clear_all(r_ptr->row_bitmap);
+	if (r_ptr->node_bitmap)
+		bit_clear_all(r_ptr->node_bitmap);
+}
+
+
+/* add the cores of a job to the row_bitmap and node_bitmap of a row */
+static void _add_job_to_row_bitmaps(struct job_resources *job,
+				    struct part_row_data *r_ptr)
+{
+	add_job_to_cores(job, &(r_ptr->row_bitmap), cr_node_num_cores);
+	if (!job->core_bitmap)
+		return;
+	if (!r_ptr->node_bitmap)
+		r_ptr->node_bitmap = bit_alloc(select_node_cnt);
+	bit_or(r_ptr->node_bitmap, job->node_bitmap);
+}
+
+
+/* remove the cores of a job from the row_bitmap and node_bitmap of a row,
+ * only the nodes of the job are examined */
+static void _rm_job_from_row_bitmaps(struct job_resources *job,
+				     struct part_row_data *r_ptr)
+{
+	int i, i_first, i_last;
+
+	if (!r_ptr->row_bitmap || !job->core_bitmap)
+		return;
+	remove_job_from_cores(job, &(r_ptr->row_bitmap), cr_node_num_cores);
+	if (!r_ptr->node_bitmap)
+		return;
+	i_first = bit_ffs(job->node_bitmap);
+	if (i_first == -1)
+		return;
+	i_last = bit_fls(job->node_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(job->node_bitmap, i) ||
+		    !bit_test(r_ptr->node_bitmap, i))
+			continue;
+		if (bit_set_count_range(r_ptr->row_bitmap,
+					cr_get_coremap_offset(i),
+					cr_get_coremap_offset(i + 1)) == 0)
+			bit_clear(r_ptr->node_bitmap, i);
+	}
+}
+
+
+/* rebuild the row_bitmap and node_bitmap of a row from its job_list */
+static void _rebuild_row_bitmaps(struct part_row_data *r_ptr)
+{
+	uint32_t j;
+
+	_clear_row_bitmaps(r_ptr);
+	for (j = 0; j < r_ptr->num_jobs; j++)
+		_add_job_to_row_bitmaps(r_ptr->job_list[j], r_ptr);
+}
+
+
 static void _add_job_to_row(struct job_resources *job,
 			    struct part_row_data *r_ptr)
 {
 	/* add the job to the row_bitmap */
-	if (r_ptr->row_bitmap && r_ptr->num_jobs == 0) {
+	if (r_ptr->num_jobs == 0) {
 		/* if no jobs, clear the existing row_bitmap first */
-		uint32_t size = bit_size(r_ptr->row_bitmap);
-		bit_nclear(r_ptr->row_bitmap, 0, size-1);
+		_clear_row_bitmaps(r_ptr);
 	}
-	add_job_to_cores(job, &(r_ptr->row_bitmap), cr_node_num_cores);
+	_add_job_to_row_bitmaps(job, r_ptr);
 
 	/*  add the job to the job_list */
 	if (r_ptr->num_jobs >= r_ptr->job_list_size) {
@@ -534,6 +628,11 @@ static int _can_job_fit_in_row(struct job_resources *job,
 	if ((r_ptr->num_jobs == 0) || !r_ptr->row_bitmap)
 		return 1;
 
+	/* only the nodes in use by both need their cores tested */
+	if (r_ptr->node_bitmap &&
+	    !bit_overlap(job->node_bitmap, r_ptr->node_bitmap))
+		return 1;
+
 	return job_fits_into_cores(job, r_ptr->row_bitmap, cr_node_num_cores);
 }
 
@@ -544,16 +643,19 @@ static void _swap_rows(struct part_row_data *a, struct part_row_data *b)
 	struct part_row_data tmprow;
 
 	tmprow.row_bitmap    = a->row_bitmap;
+	tmprow.node_bitmap   = a->node_bitmap;
 	tmprow.num_jobs      = a->num_jobs;
 	tmprow.job_list      = a->job_list;
 	tmprow.job_list_size = a->job_list_size;
 
 	a->row_bitmap    = b->row_bitmap;
+	a->node_bitmap   = b->node_bitmap;
 	a->num_jobs      = b->num_jobs;
 	a->job_list      = b->job_list;
 	a->job_list_size = b->job_list_size;
 
 	b->row_bitmap    = tmprow.row_bitmap;
+	b->node_bitmap   = tmprow.node_bitmap;
 	b->num_jobs      = tmprow.num_jobs;
 	b->job_list      = tmprow.job_list;
 	b->job_list_size = tmprow.job_list_size;
@@ -583,6 +685,7 @@ extern void cr_sort_part_rows(struct part_res_record *p_ptr)
 				b = a[j];
 				a[j] = a[i];
 				a[i] = b;
+				_own_part_rows(p_ptr);
 				_swap_rows(&(p_ptr->row[i]), &(p_ptr->row[j]));
 			}
 		}
@@ -598,59 +701,37 @@ extern void cr_sort_part_rows(struct part_res_record *p_ptr)
  *                     and make the lower rows as dense as possible.
  *
  * IN/OUT: p_ptr   - the partition that has jobs to be optimized
+ * IN: job_ptr     - job whose cores were already removed from its row with
+ *                   _rm_job_from_row_bitmaps(), or NULL if the cores of
+ *                   some job changed and all bitmaps must be rebuilt
  */
 static void _build_row_bitmaps(struct part_res_record *p_ptr,
 			       struct job_record *job_ptr)
 {
-	uint32_t i, j, num_jobs, size;
+	uint32_t i, j, num_jobs;
 	int x;
-	struct part_row_data *this_row, *orig_row;
+	struct part_row_data *orig_row;
 	struct sort_support *ss;
 
 	if (!p_ptr->row)
 		return;
 
-	if (p_ptr->num_rows == 1) {
-		this_row = &(p_ptr->row[0]);
-		if (this_row->num_jobs == 0) {
-			if (this_row->row_bitmap) {
-				size = bit_size(this_row->row_bitmap);
-				bit_nclear(this_row->row_bitmap, 0, size-1);
-			}
-		} else {
-			if (job_ptr) { /* just remove the job */
-				xassert(job_ptr->job_resrcs);
-				remove_job_from_cores(job_ptr->job_resrcs,
-						      &(this_row->row_bitmap),
-						      cr_node_num_cores);
-			} else { /* totally rebuild the bitmap */
-				size = bit_size(this_row->row_bitmap);
-				bit_nclear(this_row->row_bitmap, 0, size-1);
-				for (j = 0; j < this_row->num_jobs; j++) {
-					add_job_to_cores(this_row->job_list[j],
-							 &(this_row->row_bitmap),
-							 cr_node_num_cores);
-				}
-			}
-		}
-		return;
+	if (!job_ptr) { /* totally rebuild the bitmaps */
+		for (i = 0; i < p_ptr->num_rows; i++)
+			_rebuild_row_bitmaps(&(p_ptr->row[i]));
 	}
 
 	/* gather data */
 	num_jobs = 0;
-	for (i = 0; i < p_ptr->num_rows; i++) {
+	for (i = 1; i < p_ptr->num_rows; i++) {
 		num_jobs += p_ptr->row[i].num_jobs;
 	}
 	if (num_jobs == 0) {
-		size = bit_size(p_ptr->row[0].row_bitmap);
-		for (i = 0; i < p_ptr->num_rows; i++) {
-			if (p_ptr->row[i].row_bitmap) {
-				bit_nclear(p_ptr->row[i].row_bitmap, 0,
-					   size-1);
-			}
-		}
+		/* All jobs are in the first row, the rows are as dense as
+		 * they can be and their bitmaps are current */
 		return;
 	}
+	num_jobs += p_ptr->row[0].num_jobs;
 
 	if (select_debug_flags & DEBUG_FLAG_SELECT_TYPE) {
 		info("DEBUG: _build_row_bitmaps (before):");
@@ -663,10 +744,6 @@ static void _build_row_bitmaps(struct part_res_record *p_ptr,
 	if (orig_row == NULL)
 		return;
 
-	/* get row_bitmap size from first row (we can safely assume that the
-	 * first row_bitmap exists because there exists at least one job. */
-	size = bit_size(p_ptr->row[0].row_bitmap);
-
 	/* create a master job list and clear out ALL row data */
 	ss = xmalloc(num_jobs * sizeof(struct sort_support));
 	x = 0;
@@ -680,9 +757,7 @@ static void _build_row_bitmaps(struct part_res_record *p_ptr,
 			x++;
 		}
 		p_ptr->row[i].num_jobs = 0;
-		if (p_ptr->row[i].row_bitmap) {
-			bit_nclear(p_ptr->row[i].row_bitmap, 0, size-1);
-		}
+		_clear_row_bitmaps(&(p_ptr->row[i]));
 	}
 
 	/* VERY difficult: Optimal placement of jobs in the matrix
@@ -748,19 +823,10 @@ static void _build_row_bitmaps(struct part_res_record *p_ptr,
 		p_ptr->row = orig_row;
 		orig_row = NULL;
 
-		/* still need to rebuild row_bitmaps */
-		for (i = 0; i < p_ptr->num_rows; i++) {
-			if (p_ptr->row[i].row_bitmap)
-				bit_nclear(p_ptr->row[i].row_bitmap, 0,
-					   size-1);
-			if (p_ptr->row[i].num_jobs == 0)
-				continue;
-			for (j = 0; j < p_ptr->row[i].num_jobs; j++) {
-				add_job_to_cores(p_ptr->row[i].job_list[j],
-						 &(p_ptr->row[i].row_bitmap),
-						 cr_node_num_cores);
-			}
-		}
+		/* still need to rebuild row_bitmaps, the cores removed with
+		 * the job may also be used by another job of its row */
+		for (i = 0; i < p_ptr->num_rows; i++)
+			_rebuild_row_bitmaps(&(p_ptr->row[i]));
 	}
 
 	if (select_debug_flags & DEBUG_FLAG_SELECT_TYPE) {
@@ -1214,10 +1280,9 @@ static int _rm_job_from_res(struct part_res_record *part_record_ptr,
 
 		node_ptr = node_record_table_ptr + i;
 		if (action != 2) {
-			if (node_usage[i].gres_list)
-				gres_list = node_usage[i].gres_list;
-			else
-				gres_list = node_ptr->gres_list;
+			gres_list = _get_node_gres_list(node_usage, i,
+							(job_ptr->gres_list !=
+							 NULL));
 			gres_plugin_job_dealloc(job_ptr->gres_list, gres_list,
 						n, job_ptr->job_id,
 						node_ptr->name);
@@ -1270,6 +1335,7 @@ static int _rm_job_from_res(struct part_res_record *part_record_ptr,
 
 		if (!p_ptr->row)
 			return SLURM_SUCCESS;
+		_own_part_rows(p_ptr);
 
 		/* remove the job from the job_list */
 		n = 0;
@@ -1288,6 +1354,7 @@ static int _rm_job_from_res(struct part_res_record *part_record_ptr,
 				}
 				p_ptr->row[i].job_list[j] = NULL;
 				p_ptr->row[i].num_jobs--;
+				_rm_job_from_row_bitmaps(job, &(p_ptr->row[i]));
 				/* found job - we're done */
 				n = 1;
 				i = p_ptr->num_rows;
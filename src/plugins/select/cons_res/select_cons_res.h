@@ -68,6 +68,8 @@
 struct part_row_data {
 	bitstr_t *row_bitmap;		/* contains core bitmap for all jobs in
 					 * this row */
+	bitstr_t *node_bitmap;		/* nodes with any core set in
+					 * row_bitmap */
 	struct job_resources **job_list;/* List of jobs in this row */
 	uint32_t job_list_size;		/* Size of job_list array */
 	uint32_t num_jobs;		/* Number of occupied entries in job_list array */
@@ -79,6 +81,9 @@ struct part_res_record {
 	uint16_t num_rows;		/* Number of elements in "row" array */
 	struct part_record *part_ptr;   /* controller part record pointer */
 	struct part_row_data *row;	/* array of rows containing jobs */
+	bool rows_shared;		/* row array belongs to the record this
+					 * one was duplicated from, copy it
+					 * before any update */
 };
 
 /* per-node resource data */
@@ -101,6 +106,9 @@ struct node_use_record {
 					 * scheduled jobs */
 	List gres_list;			/* list of gres state info managed by 
 					 * plugins */
+	bool gres_list_shared;		/* gres_list NULL while the node's own
+					 * gres_list is shared, copy it before
+					 * any update */
 	uint16_t node_state;		/* see node_cr_state comments */
 };
 
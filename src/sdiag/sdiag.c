@@ -52,6 +52,8 @@
  * Global Variables *
  ********************/
 int sdiag_param = STAT_COMMAND_GET;
+bool lock_sites    = false;
+bool parsable      = false;
 bool sort_by_id    = false;
 bool sort_by_time  = false;
 bool sort_by_time2 = false;
@@ -59,6 +61,8 @@ bool sort_by_time2 = false;
 stats_info_response_msg_t *buf;
 uint32_t *rpc_type_ave_time = NULL, *rpc_user_ave_time = NULL;
 
+static void _print_latency_parsable(void);
+static void _print_lock_sites(void);
 static int  _print_stats(void);
 static void _sort_rpc(void);
 
@@ -84,7 +88,11 @@ int main(int argc, char **argv)
 		req.command_id = STAT_COMMAND_GET;
 		rc = slurm_get_statistics(&buf,
 					  (stats_info_request_msg_t *)&req);
-		if (rc == SLURM_SUCCESS) {
+		if ((rc == SLURM_SUCCESS) && lock_sites) {
+			_print_lock_sites();
+		} else if ((rc == SLURM_SUCCESS) && parsable) {
+			_print_latency_parsable();
+		} else if (rc == SLURM_SUCCESS) {
 			_sort_rpc();
 			rc = _print_stats();
 #ifdef MEMORY_LEAK_DEBUG
@@ -100,6 +108,101 @@ int main(int argc, char **argv)
 	exit(rc);
 }
 
+/* Return the latency histograms of an RPC type or NULL if not reported */
+static rpc_latency_t *_find_latency(uint16_t rpc_type)
+{
+	int i;
+
+	for (i = 0; i < buf->rpc_latency_size; i++) {
+		if (buf->rpc_latency[i].rpc_type == rpc_type)
+			return &buf->rpc_latency[i];
+	}
+	return NULL;
+}
+
+static uint32_t _latency_count(rpc_latency_t *latency, int phase)
+{
+	uint32_t count = 0;
+	int i;
+
+	for (i = 0; i < RPC_LATENCY_BUCKETS; i++)
+		count += latency->hist[phase][i];
+	return count;
+}
+
+/*
+ * Return the pct percentile of the latencies of an RPC processing phase in
+ * usec: the upper bound of the histogram bucket it falls into, or the
+ * maximum latency if that is lower.
+ */
+static uint32_t _latency_percentile(rpc_latency_t *latency, int phase,
+				    double pct)
+{
+	double rank = _latency_count(latency, phase) * pct;
+	uint64_t sum = 0, target = rank;
+	uint32_t bound;
+	int i;
+
+	if (target < rank)
+		target++;
+	if (target == 0)
+		return 0;
+	for (i = 0; i < (RPC_LATENCY_BUCKETS - 1); i++) {
+		sum += latency->hist[phase][i];
+		if (sum >= target)
+			break;
+	}
+	if (i == (RPC_LATENCY_BUCKETS - 1))
+		return latency->max[phase];
+	bound = (1U << i) - 1;
+	return MIN(bound, latency->max[phase]);
+}
+
+static void _print_latency_parsable(void)
+{
+	static const char *phase_name[] = { "queue", "lock", "run" };
+	rpc_latency_t *latency;
+	int i, j, phase, last;
+
+	printf("MsgType|MsgTypeId|Phase|Count|P50|P99|Max|Histogram\n");
+	for (i = 0; i < buf->rpc_latency_size; i++) {
+		latency = &buf->rpc_latency[i];
+		for (phase = 0; phase < RPC_LATENCY_PHASES; phase++) {
+			printf("%s|%u|%s|%u|%u|%u|%u|",
+			       rpc_num2string(latency->rpc_type),
+			       latency->rpc_type, phase_name[phase],
+			       _latency_count(latency, phase),
+			       _latency_percentile(latency, phase, 0.50),
+			       _latency_percentile(latency, phase, 0.99),
+			       latency->max[phase]);
+			for (last = RPC_LATENCY_BUCKETS - 1; last > 0; last--) {
+				if (latency->hist[phase][last])
+					break;
+			}
+			for (j = 0; j <= last; j++) {
+				printf("%s%u", j ? "," : "",
+				       latency->hist[phase][j]);
+			}
+			printf("\n");
+		}
+	}
+}
+
+/* Print the lock statistics of all call sites, '|' delimited */
+static void _print_lock_sites(void)
+{
+	lock_site_stats_t *site;
+	int i;
+
+	printf("Site|Locks|Count|WaitTotal|WaitMax|HoldTotal|HoldMax\n");
+	for (i = 0, site = buf->lock_site; i < buf->lock_site_size;
+	     i++, site++) {
+		printf("%s|%s|%u|%"PRIu64"|%u|%"PRIu64"|%u\n",
+		       site->site, site->locks, site->count, site->wait_total,
+		       site->wait_max, site->hold_total, site->hold_max);
+	}
+}
+
 static int _print_stats(void)
 {
 	int i;
@@ -146,6 +249,8 @@ static int _print_stats(void)
 		       ((buf->req_time - buf->req_time_start) / 60)));
 	}
 	printf("\tLast queue length: %u\n", buf->schedule_queue_len);
+	printf("\tJobs skipped (same requirements as failed job): %u\n",
+	       buf->schedule_class_skip);
 
 	if (buf->bf_active) {
 		printf("\nBackfilling stats (WARNING: data obtained"
@@ -181,6 +286,17 @@ static int _print_stats(void)
 		printf("\tQueue length mean: %u\n",
 		       buf->bf_queue_len_sum / buf->bf_cycle_counter);
 	}
+	printf("\tJobs skipped (same requirements as failed job): %u\n",
+	       buf->bf_class_skip);
+
+	printf("\nNode set cache\n");
+	printf("\tHits:   %u\n", buf->node_set_cache_hits);
+	printf("\tMisses: %u\n", buf->node_set_cache_misses);
+	if (buf->node_set_cache_hits + buf->node_set_cache_misses) {
+		printf("\tHit rate: %.1f%%\n",
+		       100.0 * buf->node_set_cache_hits /
+		       (buf->node_set_cache_hits + buf->node_set_cache_misses));
+	}
 
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
@@ -200,6 +316,41 @@ static int _print_stats(void)
 		       rpc_user_ave_time[i], buf->rpc_user_time[i]);
 	}
 
+	if (buf->rpc_latency_size) {
+		printf("\nRemote Procedure Call latency by message type "
+		       "(p50/p99/max usec)\n");
+	}
+	for (i = 0; buf->rpc_latency_size && (i < buf->rpc_type_size); i++) {
+		rpc_latency_t *latency = _find_latency(buf->rpc_type_id[i]);
+		if (!latency)
+			continue;
+		printf("\t%-40s(%5u) queue:%u/%u/%u lock:%u/%u/%u "
+		       "run:%u/%u/%u\n",
+		       rpc_num2string(buf->rpc_type_id[i]),
+		       buf->rpc_type_id[i],
+		       _latency_percentile(latency, RPC_LATENCY_QUEUE, 0.50),
+		       _latency_percentile(latency, RPC_LATENCY_QUEUE, 0.99),
+		       latency->max[RPC_LATENCY_QUEUE],
+		       _latency_percentile(latency, RPC_LATENCY_LOCK, 0.50),
+		       _latency_percentile(latency, RPC_LATENCY_LOCK, 0.99),
+		       latency->max[RPC_LATENCY_LOCK],
+		       _latency_percentile(latency, RPC_LATENCY_RUN, 0.50),
+		       _latency_percentile(latency, RPC_LATENCY_RUN, 0.99),
+		       latency->max[RPC_LATENCY_RUN]);
+	}
+
+	if (buf->lock_site_size) {
+		printf("\nLock statistics by call site (top %d by total hold "
+		       "time, usec)\n", MIN(buf->lock_site_size, 10));
+	}
+	for (i = 0; (i < buf->lock_site_size) && (i < 10); i++) {
+		lock_site_stats_t *site = &buf->lock_site[i];
+		printf("\t%-48s %-34s count:%-6u wait_max:%-8u "
+		       "hold_max:%-8u hold_total:%"PRIu64"\n",
+		       site->site, site->locks, site->count, site->wait_max,
+		       site->hold_max, site->hold_total);
+	}
+
 	return 0;
 }
 
@@ -403,35 +403,25 @@ static void _set_qos_order(struct job_record *job_ptr,
 	return;
 }
 
-static int _find_used_limits_for_acct(void *x, void *key)
-{
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	char *account = (char *)key;
-
-	if (!xstrcmp(account, used_limits->acct))
-		return 1;
-
-	return 0;
-}
-
-/* Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
+/* Checks for record in the qos acct_limit_list of acct if the
+ * acct_limit_list doesn't exist it will create it, if the acct
  * record doesn't exist it will add it to the list.
- * In all cases the user record is returned.
+ * In all cases the acct record is returned.
  */
 static slurmdb_used_limits_t *_get_acct_used_limits(
-	List *acct_limit_list, char *acct)
+	slurmdb_qos_usage_t *usage, char *acct)
 {
 	slurmdb_used_limits_t *used_limits;
 
-	xassert(acct_limit_list);
+	xassert(usage);
 
-	if (!*acct_limit_list)
-		*acct_limit_list = list_create(slurmdb_destroy_used_limits);
+	if (!usage->acct_limit_list)
+		usage->acct_limit_list =
+			list_create(slurmdb_destroy_used_limits);
 
-	if (!(used_limits = list_find_first(*acct_limit_list,
-					    _find_used_limits_for_acct,
-					    acct))) {
+	if (!(used_limits = slurmdb_find_used_limits(usage->acct_limit_list,
+						     &usage->acct_limit_index,
+						     true, acct, 0))) {
 		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
 
 		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
@@ -440,41 +430,33 @@ static slurmdb_used_limits_t *_get_acct_used_limits(
 		used_limits->tres = xmalloc(i);
 		used_limits->tres_run_mins = xmalloc(i);
 
-		list_append(*acct_limit_list, used_limits);
+		used_limits = slurmdb_add_used_limits(usage->acct_limit_list,
+						      &usage->acct_limit_index,
+						      true, used_limits);
 	}
 
 	return used_limits;
 }
 
-static int _find_used_limits_for_user(void *x, void *key)
-{
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	uint32_t user_id = *(uint32_t *)key;
-
-	if (used_limits->uid == user_id)
-		return 1;
-
-	return 0;
-}
-
-/* Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
+/* Checks for record in the qos user_limit_list of user_id if the
+ * user_limit_list doesn't exist it will create it, if the user_id
  * record doesn't exist it will add it to the list.
  * In all cases the user record is returned.
  */
 static slurmdb_used_limits_t *_get_user_used_limits(
-	List *user_limit_list, uint32_t user_id)
+	slurmdb_qos_usage_t *usage, uint32_t user_id)
 {
 	slurmdb_used_limits_t *used_limits;
 
-	xassert(user_limit_list);
+	xassert(usage);
 
-	if (!*user_limit_list)
-		*user_limit_list = list_create(slurmdb_destroy_used_limits);
+	if (!usage->user_limit_list)
+		usage->user_limit_list =
+			list_create(slurmdb_destroy_used_limits);
 
-	if (!(used_limits = list_find_first(*user_limit_list,
-					    _find_used_limits_for_user,
-					    &user_id))) {
+	if (!(used_limits = slurmdb_find_used_limits(usage->user_limit_list,
+						     &usage->user_limit_index,
+						     false, NULL, user_id))) {
 		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
 
 		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
@@ -483,7 +465,9 @@ static slurmdb_used_limits_t *_get_user_used_limits(
 		used_limits->tres = xmalloc(i);
 		used_limits->tres_run_mins = xmalloc(i);
 
-		list_append(*user_limit_list, used_limits);
+		used_limits = slurmdb_add_used_limits(usage->user_limit_list,
+						      &usage->user_limit_index,
+						      false, used_limits);
 	}
 
 	return used_limits;
@@ -528,10 +512,10 @@ static void _qos_adjust_limit_usage(int type, struct job_record *job_ptr,
 	if (!qos_ptr || !job_ptr->assoc_ptr)
 		return;
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr->usage,
 					      job_ptr->assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr->usage,
 					    job_ptr->user_id);
 
 	switch(type) {
@@ -1683,9 +1667,8 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	if ((qos_out_ptr->max_submit_jobs_pa == INFINITE) &&
 	    (qos_ptr->max_submit_jobs_pa != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
-			_get_acct_used_limits(
-				&qos_ptr->usage->acct_limit_list,
-				assoc_ptr->acct);
+			_get_acct_used_limits(qos_ptr->usage,
+					      assoc_ptr->acct);
 
 		qos_out_ptr->max_submit_jobs_pa = qos_ptr->max_submit_jobs_pa;
 
@@ -1706,9 +1689,8 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	if ((qos_out_ptr->max_submit_jobs_pu == INFINITE) &&
 	    (qos_ptr->max_submit_jobs_pu != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
-			_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
-				job_desc->user_id);
+			_get_user_used_limits(qos_ptr->usage,
+					      job_desc->user_id);
 
 		qos_out_ptr->max_submit_jobs_pu = qos_ptr->max_submit_jobs_pu;
 
@@ -1778,10 +1760,10 @@ static int _qos_job_runnable_pre_select(struct job_record *job_ptr,
 
 	wall_mins = qos_ptr->usage->grp_used_wall / 60;
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr->usage,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr->usage,
 					    job_ptr->user_id);
 
 
@@ -1984,10 +1966,10 @@ static int _qos_job_runnable_post_select(struct job_record *job_ptr,
 			(uint64_t)(qos_ptr->usage->usage_tres_raw[i] / 60.0);
 	}
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr->usage,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr->usage,
 					    job_ptr->user_id);
 
 	tres_usage = _validate_tres_usage_limits_for_qos(
@@ -96,6 +96,7 @@
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/ping_nodes.h"
+#include "src/slurmctld/simulator.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/state_save.h"
 #include "src/slurmctld/srun_comm.h"
@@ -1527,6 +1528,12 @@ void agent_queue_request(agent_arg_t *agent_arg_ptr)
 		message_timeout = MAX(slurm_get_msg_timeout(), 30);
 	}
 
+	if (sim_agent_request(agent_arg_ptr)) {
+		/* virtual nodes of the simulator */
+		_purge_agent_args(agent_arg_ptr);
+		return;
+	}
+
 	if (agent_arg_ptr->msg_type == REQUEST_SHUTDOWN) {
 		/* execute now */
 		slurm_thread_create_detached(NULL, agent, agent_arg_ptr);
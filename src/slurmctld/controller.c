@@ -65,6 +65,7 @@
 #include "src/common/group_cache.h"
 #include "src/common/hostlist.h"
 #include "src/common/layouts_mgr.h"
+#include "src/common/lock_stats.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
 #include "src/common/node_features.h"
@@ -102,6 +103,7 @@
 #include "src/slurmctld/job_submit.h"
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
+#include "src/slurmctld/node_scheduler.h"
 #include "src/slurmctld/ping_nodes.h"
 #include "src/slurmctld/port_mgr.h"
 #include "src/slurmctld/power_save.h"
@@ -111,6 +113,7 @@
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/sched_plugin.h"
+#include "src/slurmctld/simulator.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
 #include "src/slurmctld/srun_comm.h"
@@ -242,6 +245,8 @@ inline static void  _update_cred_key(void);
 static bool	    _verify_clustername(void);
 static void	    _create_clustername_file(void);
 static void *       _purge_files_thread(void *no_data);
+static void         _update_lock_stats(void);
+static void         _update_log_async(void);
 static void         _update_nice(void);
 inline static void  _usage(char *prog_name);
 static bool         _valid_controller(void);
@@ -305,6 +310,7 @@ int main(int argc, char **argv)
 			  slurmctld_conf.slurmctld_logfile);
 		sched_log_alter(sched_log_opts, LOG_DAEMON,
 				slurmctld_conf.sched_logfile);
+		_update_log_async();	/* writer thread lost in fork */
 		debug("sched: slurmctld starting");
 	} else {
 		slurmctld_config.daemonize = 0;
@@ -599,6 +605,11 @@ int main(int argc, char **argv)
 		slurm_thread_create(&slurmctld_config.thread_id_purge_files,
 				    _purge_files_thread, NULL);
 
+		/*
+		 * create attached thread for the scheduler simulator
+		 */
+		start_simulator(&slurmctld_config.thread_id_sim);
+
 		/*
 		 * process slurm background activities, could run as pthread
 		 */
@@ -616,10 +627,13 @@ int main(int argc, char **argv)
 		pthread_join(slurmctld_config.thread_id_sig,  NULL);
 		pthread_join(slurmctld_config.thread_id_rpc,  NULL);
 		pthread_join(slurmctld_config.thread_id_save, NULL);
+		if (slurmctld_config.thread_id_sim)
+			pthread_join(slurmctld_config.thread_id_sim, NULL);
 		slurmctld_config.thread_id_purge_files = (pthread_t) 0;
 		slurmctld_config.thread_id_sig  = (pthread_t) 0;
 		slurmctld_config.thread_id_rpc  = (pthread_t) 0;
 		slurmctld_config.thread_id_save = (pthread_t) 0;
+		slurmctld_config.thread_id_sim  = (pthread_t) 0;
 		bb_g_fini();
 		power_g_fini();
 		slurm_mcs_fini();
@@ -692,6 +706,8 @@ int main(int argc, char **argv)
 
 	/* Purge our local data structures */
 	job_fini();
+	node_set_cache_clear();
+	job_queue_cache_fini();
 	part_fini();	/* part_fini() must precede node_fini() */
 	node_fini();
 	node_features_g_fini();
@@ -1057,6 +1073,7 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		conn_arg = xmalloc(sizeof(connection_arg_t));
 		conn_arg->newsockfd = newsockfd;
 		memcpy(&conn_arg->cli_addr, &cli_addr, sizeof(slurm_addr_t));
+		gettimeofday(&conn_arg->accept_time, NULL);
 
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
 			char inetbuf[64];
@@ -1103,7 +1120,7 @@ static void *_service_connection(void *arg)
 	}
 #endif
 	slurm_msg_t_init(&msg);
-	msg.flags |= SLURM_MSG_KEEP_BUFFER;
+	msg.flags |= SLURM_MSG_KEEP_BUFFER | SLURM_MSG_UNPACK_ARENA;
 	/*
 	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
 	 * possibility for slurmctld_req() to close accepted connection.
@@ -2437,7 +2454,7 @@ static void _parse_commandline(int argc, char **argv)
 	bool bg_recover_override = 0;
 
 	opterr = 0;
-	while ((c = getopt(argc, argv, "BcdDf:hiL:n:rRvV")) != -1)
+	while ((c = getopt(argc, argv, "BcdDf:hiL:n:rRS:vV")) != -1)
 		switch (c) {
 		case 'B':
 			bg_recover = 0;
@@ -2486,6 +2503,10 @@ static void _parse_commandline(int argc, char **argv)
 			if (!bg_recover_override)
 				bg_recover = 1;
 			break;
+		case 'S':
+			xfree(sim_trace_file);
+			sim_trace_file = xstrdup(optarg);
+			break;
 		case 'v':
 			debug_level++;
 			break;
@@ -2535,6 +2556,8 @@ static void _usage(char *prog_name)
 	fprintf(stderr, "  -R      "
 			"\tRecover full state from last checkpoint.\n");
 #endif
+	fprintf(stderr, "  -S trace "
+			"\tSimulate the nodes and run the workload trace.\n");
 	fprintf(stderr, "  -v      "
 			"\tVerbose mode. Multiple -v's increase verbosity.\n");
 	fprintf(stderr, "  -V      "
@@ -2649,6 +2672,8 @@ void update_logging(void)
 		  slurmctld_conf.slurmctld_logfile);
 
 	log_set_timefmt(slurmctld_conf.log_fmt);
+	_update_log_async();
+	_update_lock_stats();
 
 	debug("Log file re-opened");
 
@@ -2681,6 +2706,47 @@ void update_logging(void)
 	}
 }
 
+/* Enable or disable asynchronous log file writes per SchedulerParameters */
+static void _update_log_async(void)
+{
+	char *tmp_ptr;
+	long ring_size = 0;
+
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.sched_params,
+				   "log_async="))) {
+		ring_size = strtol(tmp_ptr + 10, NULL, 10);
+		if ((ring_size < 0) || (ring_size > 1000000)) {
+			error("Invalid SchedulerParameters log_async: %ld",
+			      ring_size);
+			ring_size = 0;
+		}
+	}
+	log_set_async((uint32_t) ring_size);
+}
+
+/* Enable or disable lock hold and wait time statistics per
+ * SchedulerParameters */
+static void _update_lock_stats(void)
+{
+	char *tmp_ptr;
+	bool enable = false;
+	long warn_msec = 0;
+
+	if (xstrcasestr(slurmctld_conf.sched_params, "lock_stats"))
+		enable = true;
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.sched_params,
+				   "lock_warn_time="))) {
+		warn_msec = strtol(tmp_ptr + 15, NULL, 10);
+		if ((warn_msec < 0) || (warn_msec > 1000000)) {
+			error("Invalid SchedulerParameters lock_warn_time: %ld",
+			      warn_msec);
+			warn_msec = 0;
+		} else if (warn_msec)
+			enable = true;
+	}
+	lock_stats_config(enable, (uint32_t) warn_msec * 1000);
+}
+
 /* Reset slurmd nice value */
 static void _update_nice(void)
 {
@@ -9423,7 +9423,8 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			  uint16_t protocol_version)
 {
-	uint32_t jobs_packed = 0, tmp_offset;
+	uint32_t jobs_packed = 0, tmp_offset, first_offset, prev_packed;
+	uint32_t *rec_offsets = NULL;
 	_foreach_pack_job_info_t pack_info = {0};
 	Buf buffer;
 	ListIterator itr;
@@ -9447,12 +9448,27 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	pack_info.show_flags       = show_flags;
 	pack_info.uid              = uid;
 
+	if (show_flags & SHOW_REC_INDEX) {
+		rec_offsets = xmalloc(sizeof(uint32_t) *
+				      (list_count(job_list) + 1));
+	}
+	first_offset = get_buf_offset(buffer);
+
 	itr = list_iterator_create(job_list);
 	while ((job_ptr = (struct job_record *) list_next(itr))) {
+		tmp_offset = get_buf_offset(buffer);
+		prev_packed = jobs_packed;
 		_pack_job(job_ptr, &pack_info);
+		if (rec_offsets && (jobs_packed != prev_packed))
+			rec_offsets[prev_packed] = tmp_offset - first_offset;
 	}
 	list_iterator_destroy(itr);
 
+	if (rec_offsets) {
+		pack_rec_index(rec_offsets, jobs_packed, buffer);
+		xfree(rec_offsets);
+	}
+
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
 	set_buf_offset(buffer, 0);
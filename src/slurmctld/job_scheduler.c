@@ -106,12 +106,45 @@ typedef struct epilog_arg {
 	char **my_env;
 } epilog_arg_t;
 
+/*
+ * Persistent job queue entry. The sort key of the last pass is kept so that
+ * pairs whose key did not change can keep their position in the queue.
+ */
+typedef struct job_queue_ent {
+	job_queue_rec_t rec;		/* must be first, see sort_job_queue2() */
+	uint32_t pass;			/* last pass which added this pair */
+	bool changed;			/* new or sort key changed in this pass */
+	bool has_resv;			/* sort key of the last pass */
+	uint16_t priority_tier;
+	uint32_t priority;
+	time_t submit_time;
+} job_queue_ent_t;
+
+/*
+ * Job queue kept in priority order between scheduling passes, one for the
+ * main scheduler and one for backfill as they test different time limits
+ */
+typedef struct job_queue_cache {
+	job_queue_ent_t **ent;		/* entries in queue order */
+	int ent_cnt;
+	int ent_size;
+	job_queue_ent_t **merge;	/* merge buffer, ent_size entries */
+	job_queue_ent_t **changed;	/* new or changed entries of this pass */
+	int changed_cnt;
+	int changed_size;
+	job_queue_ent_t **hash;		/* index by job and partition */
+	int hash_size;			/* power of 2 */
+	uint32_t pass;
+	bool full_sort;			/* sort every entry in this pass */
+} job_queue_cache_t;
+
 static char **	_build_env(struct job_record *job_ptr, bool is_epilog);
 static batch_job_launch_msg_t *_build_launch_job_msg(struct job_record *job_ptr,
 						     uint16_t protocol_version);
 static void	_depend_list_del(void *dep_ptr);
 static void	_feature_list_delete(void *x);
-static void	_job_queue_append(List job_queue, struct job_record *job_ptr,
+static void	_job_queue_append(job_queue_cache_t *cache,
+				  struct job_record *job_ptr,
 				  struct part_record *part_ptr, uint32_t priority);
 static void	_job_queue_rec_del(void *x);
 static bool	_job_runnable_test1(struct job_record *job_ptr,
@@ -130,6 +163,7 @@ static int	_valid_node_feature(char *feature, bool can_reboot);
 static void *	_wait_boot(void *arg);
 #endif
 static int	build_queue_timeout = BUILD_TIMEOUT;
+static job_queue_cache_t job_queue_cache[2];
 static int	save_last_part_update = 0;
 
 static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -227,18 +261,212 @@ static List _build_user_job_list(uint32_t user_id, char* job_name)
 	return job_queue;
 }
 
-static void _job_queue_append(List job_queue, struct job_record *job_ptr,
+static uint32_t _job_queue_hash(struct job_record *job_ptr,
+				struct part_record *part_ptr)
+{
+	uintptr_t key[2] = { (uintptr_t) job_ptr, (uintptr_t) part_ptr };
+	unsigned char *p = (unsigned char *) key;
+	uint32_t hash = 2166136261U;
+	int i;
+
+	for (i = 0; i < sizeof(key); i++)
+		hash = (hash ^ p[i]) * 16777619U;
+	return hash;
+}
+
+static void _job_queue_hash_add(job_queue_cache_t *cache,
+				job_queue_ent_t *ent)
+{
+	uint32_t inx = _job_queue_hash(ent->rec.job_ptr, ent->rec.part_ptr);
+
+	for (inx &= (cache->hash_size - 1); cache->hash[inx];
+	     inx = (inx + 1) & (cache->hash_size - 1))
+		;
+	cache->hash[inx] = ent;
+}
+
+/* Rebuild the index of entries, keeping it at most half full */
+static void _job_queue_hash_build(job_queue_cache_t *cache)
+{
+	int i, size = 1024;
+
+	while (size < (cache->ent_cnt * 2))
+		size *= 2;
+	if (size != cache->hash_size) {
+		xfree(cache->hash);
+		cache->hash = xmalloc(sizeof(job_queue_ent_t *) * size);
+		cache->hash_size = size;
+	} else {
+		memset(cache->hash, 0, sizeof(job_queue_ent_t *) * size);
+	}
+	for (i = 0; i < cache->ent_cnt; i++)
+		_job_queue_hash_add(cache, cache->ent[i]);
+}
+
+static job_queue_ent_t *_job_queue_hash_find(job_queue_cache_t *cache,
+					     struct job_record *job_ptr,
+					     struct part_record *part_ptr)
+{
+	job_queue_ent_t *ent;
+	uint32_t inx = _job_queue_hash(job_ptr, part_ptr);
+
+	/*
+	 * Entries of jobs purged since the last pass may still be indexed.
+	 * Their job_ptr is never dereferenced, and the job ID tells a new job
+	 * record at the same address apart.
+	 */
+	for (inx &= (cache->hash_size - 1); (ent = cache->hash[inx]);
+	     inx = (inx + 1) & (cache->hash_size - 1)) {
+		if ((ent->rec.job_ptr == job_ptr) &&
+		    (ent->rec.part_ptr == part_ptr) &&
+		    (ent->rec.job_id == job_ptr->job_id) &&
+		    (ent->rec.array_task_id == job_ptr->array_task_id))
+			return ent;
+	}
+	return NULL;
+}
+
+/* Start a pass of build_job_queue() using the given job queue cache */
+static void _job_queue_cache_start(job_queue_cache_t *cache)
+{
+	static time_t config_update = 0;
+	static bool preemption_enabled = true;
+
+	if (!cache->hash)
+		_job_queue_hash_build(cache);
+	cache->pass++;
+	cache->changed_cnt = 0;
+
+	/*
+	 * Preemption plugins order jobs by state which is not part of the
+	 * sort key, such as QOS relations, so the queue is sorted in full
+	 */
+	if (config_update != slurmctld_conf.last_update) {
+		preemption_enabled = slurm_preemption_enabled();
+		config_update = slurmctld_conf.last_update;
+	}
+	cache->full_sort = preemption_enabled;
+}
+
+static void _job_queue_append(job_queue_cache_t *cache,
+			      struct job_record *job_ptr,
 			      struct part_record *part_ptr, uint32_t prio)
 {
+	job_queue_ent_t *ent;
+	bool has_resv = (job_ptr->resv_id != 0);
+	uint16_t priority_tier = part_ptr ? part_ptr->priority_tier : 0;
+	time_t submit_time = job_ptr->details ?
+			     job_ptr->details->submit_time : 0;
+
+	ent = _job_queue_hash_find(cache, job_ptr, part_ptr);
+	if (ent && (ent->pass == cache->pass))
+		ent = NULL;	/* Partition listed twice, add another pair */
+	if (!ent) {
+		ent = xmalloc(sizeof(job_queue_ent_t));
+		ent->rec.array_task_id = job_ptr->array_task_id;
+		ent->rec.job_id   = job_ptr->job_id;
+		ent->rec.job_ptr  = job_ptr;
+		ent->rec.part_ptr = part_ptr;
+		ent->changed = true;
+	} else if (cache->full_sort ||
+		   (ent->rec.priority != prio) ||
+		   (ent->has_resv != has_resv) ||
+		   (ent->priority_tier != priority_tier) ||
+		   (ent->submit_time != submit_time)) {
+		ent->changed = true;
+	}
+	ent->rec.priority = prio;
+	ent->pass = cache->pass;
+	ent->has_resv = has_resv;
+	ent->priority_tier = priority_tier;
+	ent->submit_time = submit_time;
+
+	if (ent->changed) {
+		if (cache->changed_cnt >= cache->changed_size) {
+			cache->changed_size = MAX(1024,
+						  cache->changed_size * 2);
+			xrealloc(cache->changed, sizeof(job_queue_ent_t *) *
+						 cache->changed_size);
+		}
+		cache->changed[cache->changed_cnt++] = ent;
+	}
+}
+
+/*
+ * Complete a pass of build_job_queue(). Drop the pairs which were not added
+ * in this pass, sort the new and changed ones and merge them with the others,
+ * which are still in order.
+ * RET the job queue in priority order
+ */
+static List _job_queue_cache_finish(job_queue_cache_t *cache)
+{
+	job_queue_ent_t *ent, **tmp;
 	job_queue_rec_t *job_queue_rec;
+	List job_queue;
+	int i, j, k, n, cnt;
+
+	for (i = 0, cnt = 0; i < cache->ent_cnt; i++) {
+		ent = cache->ent[i];
+		if (ent->pass != cache->pass)
+			xfree(ent);
+		else if (!ent->changed)
+			cache->ent[cnt++] = ent;
+	}
+
+	n = cnt + cache->changed_cnt;
+	if (n > cache->ent_size) {
+		cache->ent_size = MAX(n, cache->ent_size * 2);
+		xrealloc(cache->ent, sizeof(job_queue_ent_t *) *
+				     cache->ent_size);
+		xrealloc(cache->merge, sizeof(job_queue_ent_t *) *
+				       cache->ent_size);
+	}
+
+	qsort(cache->changed, cache->changed_cnt, sizeof(job_queue_ent_t *),
+	      (__compar_fn_t) sort_job_queue2);
+	for (i = 0, j = 0, k = 0; k < n; k++) {
+		if ((j >= cache->changed_cnt) ||
+		    ((i < cnt) &&
+		     (sort_job_queue2(&cache->ent[i], &cache->changed[j]) < 0)))
+			cache->merge[k] = cache->ent[i++];
+		else
+			cache->merge[k] = cache->changed[j++];
+		cache->merge[k]->changed = false;
+	}
+	tmp = cache->ent;
+	cache->ent = cache->merge;
+	cache->merge = tmp;
+	cache->ent_cnt = n;
+	_job_queue_hash_build(cache);
+
+	job_queue = list_create(_job_queue_rec_del);
+	for (i = 0; i < n; i++) {
+		job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
+		memcpy(job_queue_rec, &cache->ent[i]->rec,
+		       sizeof(job_queue_rec_t));
+		list_append(job_queue, job_queue_rec);
+	}
+	return job_queue;
+}
 
-	job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
-	job_queue_rec->array_task_id = job_ptr->array_task_id;
-	job_queue_rec->job_id   = job_ptr->job_id;
-	job_queue_rec->job_ptr  = job_ptr;
-	job_queue_rec->part_ptr = part_ptr;
-	job_queue_rec->priority = prio;
-	list_append(job_queue, job_queue_rec);
+/*
+ * job_queue_cache_fini - free the job queues kept between scheduling passes
+ */
+extern void job_queue_cache_fini(void)
+{
+	job_queue_cache_t *cache;
+	int i, j;
+
+	for (i = 0; i < 2; i++) {	/* main and backfill */
+		cache = &job_queue_cache[i];
+		for (j = 0; j < cache->ent_cnt; j++)
+			xfree(cache->ent[j]);
+		xfree(cache->ent);
+		xfree(cache->merge);
+		xfree(cache->changed);
+		xfree(cache->hash);
+		memset(cache, 0, sizeof(job_queue_cache_t));
+	}
 }
 
 static void _job_queue_rec_del(void *x)
@@ -371,17 +599,17 @@ static bool _job_runnable_test2(struct job_record *job_ptr, bool check_min_time)
 }
 
 /*
- * build_job_queue - build (non-priority ordered) list of pending jobs
+ * build_job_queue - build list of pending jobs in priority order
  * IN clear_start - if set then clear the start_time for pending jobs,
  *		    true when called from sched/backfill or sched/builtin
  * IN backfill - true if running backfill scheduler, enforce min time limit
- * RET the job queue
+ * RET the job queue, in the order of sort_job_queue()
  * NOTE: the caller must call FREE_NULL_LIST() on RET value to free memory
  */
 extern List build_job_queue(bool clear_start, bool backfill)
 {
 	static time_t last_log_time = 0;
-	List job_queue;
+	job_queue_cache_t *cache = &job_queue_cache[backfill ? 1 : 0];
 	ListIterator depend_iter, job_iterator, part_iterator;
 	struct job_record *job_ptr = NULL, *new_job_ptr;
 	struct part_record *part_ptr;
@@ -395,7 +623,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 
 	/* init the timer */
 	(void) slurm_delta_tv(&start_tv);
-	job_queue = list_create(_job_queue_rec_del);
+	_job_queue_cache_start(cache);
 
 	/* Create individual job records for job arrays that need burst buffer
 	 * staging */
@@ -537,12 +765,12 @@ extern List build_job_queue(bool clear_start, bool backfill)
 					continue;
 				job_part_pairs++;
 				if (job_ptr->priority_array) {
-					_job_queue_append(job_queue, job_ptr,
+					_job_queue_append(cache, job_ptr,
 							  part_ptr,
 							  job_ptr->
 							  priority_array[inx]);
 				} else {
-					_job_queue_append(job_queue, job_ptr,
+					_job_queue_append(cache, job_ptr,
 							  part_ptr,
 							  job_ptr->priority);
 				}
@@ -565,13 +793,13 @@ extern List build_job_queue(bool clear_start, bool backfill)
 			if (!_job_runnable_test2(job_ptr, backfill))
 				continue;
 			job_part_pairs++;
-			_job_queue_append(job_queue, job_ptr,
+			_job_queue_append(cache, job_ptr,
 					  job_ptr->part_ptr, job_ptr->priority);
 		}
 	}
 	list_iterator_destroy(job_iterator);
 
-	return job_queue;
+	return _job_queue_cache_finish(cache);
 }
 
 /*
@@ -693,6 +921,248 @@ static bool _failed_partition(struct part_record *part_ptr,
 	return false;
 }
 
+/* Fields which define a scheduling class, see sched_class_failed() */
+typedef struct sched_class_key {
+	struct part_record *part_ptr;	/* NULL if record unused */
+	slurmdb_qos_rec_t *qos_ptr;
+	struct slurmctld_resv *resv_ptr;
+	uint64_t pn_min_memory;
+	uint32_t assoc_id;
+	uint32_t bit_flags;
+	uint32_t flags;
+	uint32_t max_cpus;
+	uint32_t max_nodes;
+	uint32_t min_cpus;
+	uint32_t min_nodes;
+	uint32_t num_tasks;
+	uint32_t pn_min_cpus;
+	uint32_t pn_min_tmp_disk;
+	uint32_t priority;		/* only with preempt/job_prio */
+	uint32_t req_switch;
+	uint32_t task_dist;
+	uint32_t time_limit;
+	uint32_t time_min;
+	uint32_t user_id;
+	uint32_t wait4switch;
+	uint16_t contiguous;
+	uint16_t core_spec;
+	uint16_t cpus_per_task;
+	uint16_t ntasks_per_node;
+	uint16_t plane_size;
+	multi_core_data_t mc;
+	uint8_t overcommit;
+	uint8_t power_flags;
+	uint8_t reboot;
+	uint8_t share_res;
+	uint8_t whole_node;
+} sched_class_key_t;
+
+typedef struct sched_class {
+	sched_class_key_t key;
+	uint32_t hash;
+	char *features;
+	char *gres;
+	char *licenses;
+	char *mcs_label;
+	char *network;
+
+	int error_code;			/* result of the failed test */
+	time_t start_time;
+	uint32_t state_reason;
+} sched_class_t;
+
+#define SCHED_CLASS_TBL_SIZE 1024	/* power of 2 */
+
+struct sched_class_tbl {
+	int cnt;
+	bool use_prio;			/* preemption depends upon priority */
+	sched_class_t rec[SCHED_CLASS_TBL_SIZE];
+};
+
+/* Fill in the scheduling class of a job, RET false if it has none */
+static bool _sched_class_set(sched_class_tbl_t *tbl,
+			     struct job_record *job_ptr, uint32_t flags,
+			     sched_class_t *cls)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	sched_class_key_t *key = &cls->key;
+	unsigned char *p;
+	uint32_t hash = 2166136261U;
+	int i;
+
+	if (!detail_ptr || !job_ptr->part_ptr ||
+	    detail_ptr->req_node_bitmap || detail_ptr->exc_node_bitmap ||
+	    (job_ptr->deadline && (job_ptr->deadline != NO_VAL)) ||
+	    job_ptr->burst_buffer || job_ptr->pack_job_id)
+		return false;
+
+	memset(cls, 0, sizeof(sched_class_t));
+	key->part_ptr = job_ptr->part_ptr;
+	key->qos_ptr = job_ptr->qos_ptr;
+	key->resv_ptr = job_ptr->resv_ptr;
+	key->pn_min_memory = detail_ptr->pn_min_memory;
+	key->assoc_id = job_ptr->assoc_id;
+	key->bit_flags = job_ptr->bit_flags;
+	key->flags = flags;
+	key->max_cpus = detail_ptr->max_cpus;
+	key->max_nodes = detail_ptr->max_nodes;
+	key->min_cpus = detail_ptr->min_cpus;
+	key->min_nodes = detail_ptr->min_nodes;
+	key->num_tasks = detail_ptr->num_tasks;
+	key->pn_min_cpus = detail_ptr->pn_min_cpus;
+	key->pn_min_tmp_disk = detail_ptr->pn_min_tmp_disk;
+	if (tbl->use_prio)
+		key->priority = job_ptr->priority;
+	key->req_switch = job_ptr->req_switch;
+	key->task_dist = detail_ptr->task_dist;
+	key->time_limit = job_ptr->time_limit;
+	key->time_min = job_ptr->time_min;
+	key->user_id = job_ptr->user_id;
+	key->wait4switch = job_ptr->wait4switch;
+	key->contiguous = detail_ptr->contiguous;
+	key->core_spec = detail_ptr->core_spec;
+	key->cpus_per_task = detail_ptr->cpus_per_task;
+	key->ntasks_per_node = detail_ptr->ntasks_per_node;
+	key->plane_size = detail_ptr->plane_size;
+	if (detail_ptr->mc_ptr)
+		key->mc = *detail_ptr->mc_ptr;
+	key->overcommit = detail_ptr->overcommit;
+	key->power_flags = job_ptr->power_flags;
+	key->reboot = job_ptr->reboot;
+	key->share_res = detail_ptr->share_res;
+	key->whole_node = detail_ptr->whole_node;
+
+	cls->features = detail_ptr->features;
+	cls->gres = job_ptr->gres;
+	cls->licenses = job_ptr->licenses;
+	cls->mcs_label = job_ptr->mcs_label;
+	cls->network = job_ptr->network;
+
+	/* FNV-1a hash */
+	p = (unsigned char *) key;
+	for (i = 0; i < sizeof(sched_class_key_t); i++)
+		hash = (hash ^ p[i]) * 16777619U;
+	for (p = (unsigned char *) cls->features; p && *p; p++)
+		hash = (hash ^ *p) * 16777619U;
+	for (p = (unsigned char *) cls->gres; p && *p; p++)
+		hash = (hash ^ *p) * 16777619U;
+	for (p = (unsigned char *) cls->licenses; p && *p; p++)
+		hash = (hash ^ *p) * 16777619U;
+	cls->hash = hash;
+
+	return true;
+}
+
+/* Return the table record of a scheduling class, or the free slot for it */
+static sched_class_t *_sched_class_find(sched_class_tbl_t *tbl,
+					sched_class_t *cls)
+{
+	sched_class_t *rec;
+	int i, inx = cls->hash & (SCHED_CLASS_TBL_SIZE - 1);
+
+	for (i = 0; i < SCHED_CLASS_TBL_SIZE; i++) {
+		rec = &tbl->rec[inx];
+		if (!rec->key.part_ptr)
+			return rec;
+		if ((rec->hash == cls->hash) &&
+		    !memcmp(&rec->key, &cls->key, sizeof(sched_class_key_t)) &&
+		    !xstrcmp(rec->features, cls->features) &&
+		    !xstrcmp(rec->gres, cls->gres) &&
+		    !xstrcmp(rec->licenses, cls->licenses) &&
+		    !xstrcmp(rec->mcs_label, cls->mcs_label) &&
+		    !xstrcmp(rec->network, cls->network))
+			return rec;
+		inx = (inx + 1) & (SCHED_CLASS_TBL_SIZE - 1);
+	}
+	return NULL;
+}
+
+extern sched_class_tbl_t *sched_class_tbl_create(void)
+{
+	sched_class_tbl_t *tbl = xmalloc(sizeof(sched_class_tbl_t));
+	char *preempt_type = slurm_get_preempt_type();
+
+	tbl->use_prio = !xstrcmp(preempt_type, "preempt/job_prio");
+	xfree(preempt_type);
+
+	return tbl;
+}
+
+extern void sched_class_tbl_clear(sched_class_tbl_t *tbl)
+{
+	sched_class_t *rec;
+	int i;
+
+	if (!tbl || !tbl->cnt)
+		return;
+	for (i = 0, rec = tbl->rec; i < SCHED_CLASS_TBL_SIZE; i++, rec++) {
+		if (!rec->key.part_ptr)
+			continue;
+		xfree(rec->features);
+		xfree(rec->gres);
+		xfree(rec->licenses);
+		xfree(rec->mcs_label);
+		xfree(rec->network);
+		memset(rec, 0, sizeof(sched_class_t));
+	}
+	tbl->cnt = 0;
+}
+
+extern void sched_class_tbl_destroy(sched_class_tbl_t *tbl)
+{
+	if (!tbl)
+		return;
+	sched_class_tbl_clear(tbl);
+	xfree(tbl);
+}
+
+extern void sched_class_fail(sched_class_tbl_t *tbl,
+			     struct job_record *job_ptr, uint32_t flags,
+			     int error_code, time_t start_time)
+{
+	sched_class_t cls, *rec;
+
+	/* Keep probe sequences short */
+	if (tbl->cnt >= (SCHED_CLASS_TBL_SIZE * 3 / 4))
+		return;
+	if (!_sched_class_set(tbl, job_ptr, flags, &cls))
+		return;
+	if (!(rec = _sched_class_find(tbl, &cls)) || rec->key.part_ptr)
+		return;
+
+	memcpy(rec, &cls, sizeof(sched_class_t));
+	rec->features = xstrdup(cls.features);
+	rec->gres = xstrdup(cls.gres);
+	rec->licenses = xstrdup(cls.licenses);
+	rec->mcs_label = xstrdup(cls.mcs_label);
+	rec->network = xstrdup(cls.network);
+	rec->error_code = error_code;
+	rec->start_time = start_time;
+	rec->state_reason = job_ptr->state_reason;
+	tbl->cnt++;
+}
+
+extern bool sched_class_failed(sched_class_tbl_t *tbl,
+			       struct job_record *job_ptr, uint32_t flags,
+			       int *error_code, uint32_t *state_reason,
+			       time_t *start_time)
+{
+	sched_class_t cls, *rec;
+
+	if (!tbl->cnt || !_sched_class_set(tbl, job_ptr, flags, &cls))
+		return false;
+	if (!(rec = _sched_class_find(tbl, &cls)) || !rec->key.part_ptr)
+		return false;
+
+	if (error_code)
+		*error_code = rec->error_code;
+	if (state_reason)
+		*state_reason = rec->state_reason;
+	if (start_time)
+		*start_time = rec->start_time;
+	return true;
+}
+
 static void _do_diag_stats(long delta_t)
 {
 	if (delta_t > slurmctld_diag_stats.schedule_cycle_max)
@@ -1193,6 +1663,7 @@ static int _schedule(uint32_t job_limit)
 	struct part_record *part_ptr, **failed_parts = NULL;
 	struct part_record *skip_part_ptr = NULL;
 	struct slurmctld_resv **failed_resv = NULL;
+	sched_class_tbl_t *failed_class = NULL;
 	bitstr_t *save_avail_node_bitmap;
 	struct part_record **sched_part_ptr = NULL;
 	int *sched_part_jobs = NULL, bb_wait_cnt = 0;
@@ -1221,6 +1692,7 @@ static int _schedule(uint32_t job_limit)
 	uint32_t reject_array_job_id = 0;
 	struct part_record *reject_array_part = NULL;
 	uint16_t reject_state_reason = WAIT_NO_REASON;
+	uint32_t class_state_reason;
 	char job_id_buf[32];
 	bool fail_by_part;
 	uint32_t deadline_time_limit, save_time_limit = 0;
@@ -1489,6 +1961,7 @@ static int _schedule(uint32_t job_limit)
 	part_cnt = list_count(part_list);
 	failed_parts = xmalloc(sizeof(struct part_record *) * part_cnt);
 	failed_resv = xmalloc(sizeof(struct slurmctld_resv*) * MAX_FAILED_RESV);
+	failed_class = sched_class_tbl_create();
 	save_avail_node_bitmap = bit_copy(avail_node_bitmap);
 	bit_and_not(avail_node_bitmap, booting_node_bitmap);
 
@@ -1558,7 +2031,6 @@ static int _schedule(uint32_t job_limit)
 	} else {
 		job_queue = build_job_queue(false, false);
 		slurmctld_diag_stats.schedule_queue_len = list_count(job_queue);
-		sort_job_queue(job_queue);
 	}
 	while (1) {
 		if (fifo_sched) {
@@ -1876,6 +2348,22 @@ next_task:
 
 		last_job_sched_start = MAX(last_job_sched_start,
 					   job_ptr->start_time);
+
+		/* A job with the same requirements could not be placed */
+		if (sched_class_failed(failed_class, job_ptr, 0, &error_code,
+				       &class_state_reason, NULL)) {
+			if (job_ptr->state_reason != class_state_reason) {
+				job_ptr->state_reason = class_state_reason;
+				xfree(job_ptr->state_desc);
+				last_job_update = now;
+			}
+			debug3("sched: JobId=%u has the requirements of a job "
+			       "which could not start: %s",
+			       job_ptr->job_id, slurm_strerror(error_code));
+			slurmctld_diag_stats.schedule_class_skip++;
+			goto skip_start;
+		}
+
 		if (deadline_time_limit) {
 			save_time_limit = job_ptr->time_limit;
 			job_ptr->time_limit = deadline_time_limit;
@@ -2070,6 +2558,14 @@ skip_start:
 				job_ptr->details->req_node_bitmap);
 		}
 #endif
+		if ((error_code == ESLURM_NODES_BUSY) ||
+		    (error_code == ESLURM_POWER_NOT_AVAIL) ||
+		    (error_code == ESLURM_POWER_RESERVED) ||
+		    (error_code == ESLURM_ACCOUNTING_POLICY)) {
+			/* Resources and limits only tighten in this pass */
+			sched_class_fail(failed_class, job_ptr, 0, error_code,
+					 0);
+		}
 		if (fail_by_part && job_ptr->resv_name) {
 		 	/* do not schedule more jobs in this reservation, but
 			 * other jobs in this partition can be scheduled. */
@@ -2130,6 +2626,7 @@ fail_this_part:	if (fail_by_part) {
 	avail_node_bitmap = save_avail_node_bitmap;
 	xfree(failed_parts);
 	xfree(failed_resv);
+	sched_class_tbl_destroy(failed_class);
 	if (fifo_sched) {
 		if (job_iterator)
 			list_iterator_destroy(job_iterator);
@@ -53,6 +53,15 @@ typedef struct job_queue_rec {
 	uint32_t priority;		/* Job priority in THIS partition */
 } job_queue_rec_t;
 
+/*
+ * Pending jobs with identical partition, QOS, association, reservation,
+ * resource shape and constraints form a scheduling class. Once one job of a
+ * class can not be placed, the others of the class can not either until
+ * resources are released, so the schedulers record failed classes in a
+ * sched_class_tbl_t for the duration of a pass and skip their other jobs.
+ */
+typedef struct sched_class_tbl sched_class_tbl_t;
+
 /*
  * build_feature_list - Translate a job's feature string into a feature_list
  * IN  details->features
@@ -62,11 +71,14 @@ typedef struct job_queue_rec {
 extern int build_feature_list(struct job_record *job_ptr);
 
 /*
- * build_job_queue - build (non-priority ordered) list of pending jobs
+ * build_job_queue - build list of pending jobs in priority order
  * IN clear_start - if set then clear the start_time for pending jobs
  * IN backfill - true if running backfill scheduler, enforce min time limit
- * RET the job queue
+ * RET the job queue, in the order of sort_job_queue()
  * NOTE: the caller must call list_destroy() on RET value to free memory
+ * NOTE: The order is kept between calls, so only jobs which are new or
+ *	 whose priority, partition tier, reservation or submit time changed
+ *	 need to be sorted
  */
 extern List build_job_queue(bool clear_start, bool backfill);
 
@@ -102,6 +114,11 @@ extern void epilog_slurmctld(struct job_record *job_ptr);
  */
 extern bool job_is_completing(bitstr_t *eff_cg_bitmap);
 
+/*
+ * job_queue_cache_fini - free the job queues kept between scheduling passes
+ */
+extern void job_queue_cache_fini(void);
+
 /* Determine if a pending job will run using only the specified nodes
  * (in job_desc_msg->req_nodes), build response message and return
  * SLURM_SUCCESS on success. Otherwise return an error code. Caller
@@ -175,6 +192,46 @@ extern void rebuild_job_part_list(struct job_record *job_ptr);
  */
 extern bool replace_batch_job(slurm_msg_t * msg, void *fini_job, bool locked);
 
+/*
+ * sched_class_tbl_create - create an empty table of failed scheduling classes
+ * RET the table, free with sched_class_tbl_destroy()
+ */
+extern sched_class_tbl_t *sched_class_tbl_create(void);
+
+/* Remove all records from a table of failed scheduling classes */
+extern void sched_class_tbl_clear(sched_class_tbl_t *tbl);
+
+extern void sched_class_tbl_destroy(sched_class_tbl_t *tbl);
+
+/*
+ * sched_class_fail - record that a job could not be placed
+ * IN tbl - table of failed scheduling classes
+ * IN job_ptr - the job, its state_reason is recorded for the class
+ * IN flags - scheduler specific requirements, part of the class
+ * IN error_code - result of the failed test
+ * IN start_time - expected start time of the job, 0 if unknown
+ */
+extern void sched_class_fail(sched_class_tbl_t *tbl,
+			     struct job_record *job_ptr, uint32_t flags,
+			     int error_code, time_t start_time);
+
+/*
+ * sched_class_failed - test if another job of a job's scheduling class could
+ *	not be placed. Jobs with required or excluded nodes, a deadline, a
+ *	burst buffer or which are part of a heterogeneous job never match.
+ * IN tbl - table of failed scheduling classes
+ * IN job_ptr - the job to test
+ * IN flags - scheduler specific requirements, part of the class
+ * OUT error_code - result of the failed test, may be NULL
+ * OUT state_reason - state_reason of the failed job, may be NULL
+ * OUT start_time - expected start time of the failed job, may be NULL
+ * RET true if a job of the same class could not be placed
+ */
+extern bool sched_class_failed(sched_class_tbl_t *tbl,
+			       struct job_record *job_ptr, uint32_t flags,
+			       int *error_code, uint32_t *state_reason,
+			       time_t *start_time);
+
 /*
  * schedule - attempt to schedule all pending jobs
  *	pending jobs for each partition will be scheduled in priority
@@ -75,7 +75,12 @@ static int g_context_cnt = -1;
 static slurm_submit_ops_t *ops = NULL;
 static plugin_context_t **g_context = NULL;
 static char *submit_plugin_list = NULL;
-static pthread_mutex_t g_context_lock = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * Plugin calls only read the context, so they take g_context_lock as readers
+ * and may run concurrently. Plugins with internal state must serialize
+ * access to it themselves.
+ */
+static pthread_rwlock_t g_context_lock = PTHREAD_RWLOCK_INITIALIZER;
 static bool init_run = false;
 
 /*
@@ -93,7 +98,7 @@ extern int job_submit_plugin_init(void)
 	if (init_run && (g_context_cnt >= 0))
 		return rc;
 
-	slurm_mutex_lock(&g_context_lock);
+	pthread_rwlock_wrlock(&g_context_lock);
 	if (g_context_cnt >= 0)
 		goto fini;
 
@@ -129,7 +134,7 @@ extern int job_submit_plugin_init(void)
 	init_run = true;
 
 fini:
-	slurm_mutex_unlock(&g_context_lock);
+	pthread_rwlock_unlock(&g_context_lock);
 
 	if (rc != SLURM_SUCCESS)
 		job_submit_plugin_fini();
@@ -146,7 +151,7 @@ extern int job_submit_plugin_fini(void)
 {
 	int i, j, rc = SLURM_SUCCESS;
 
-	slurm_mutex_lock(&g_context_lock);
+	pthread_rwlock_wrlock(&g_context_lock);
 	if (g_context_cnt < 0)
 		goto fini;
 
@@ -163,7 +168,7 @@ extern int job_submit_plugin_fini(void)
 	xfree(submit_plugin_list);
 	g_context_cnt = -1;
 
-fini:	slurm_mutex_unlock(&g_context_lock);
+fini:	pthread_rwlock_unlock(&g_context_lock);
 	return rc;
 }
 
@@ -185,13 +190,13 @@ extern int job_submit_plugin_reconfig(void)
 	if (!plugin_names && !submit_plugin_list)
 		return rc;
 
-	slurm_mutex_lock(&g_context_lock);
+	pthread_rwlock_rdlock(&g_context_lock);
 	if (plugin_names && submit_plugin_list &&
 	    xstrcmp(plugin_names, submit_plugin_list))
 		plugin_change = true;
 	else
 		plugin_change = false;
-	slurm_mutex_unlock(&g_context_lock);
+	pthread_rwlock_unlock(&g_context_lock);
 
 	if (plugin_change) {
 		info("JobSubmitPlugins changed to %s", plugin_names);
@@ -220,14 +225,14 @@ extern int job_submit_plugin_submit(struct job_descriptor *job_desc,
 
 	START_TIMER;
 	rc = job_submit_plugin_init();
-	slurm_mutex_lock(&g_context_lock);
+	pthread_rwlock_rdlock(&g_context_lock);
 	/* NOTE: On function entry read locks are set on config, job, node and
 	 * partition structures. Do not attempt to unlock them and then
 	 * lock again (say with a write lock) since doing so will trigger
 	 * a deadlock with the g_context_lock above. */
 	for (i = 0; ((i < g_context_cnt) && (rc == SLURM_SUCCESS)); i++)
 		rc = (*(ops[i].submit))(job_desc, submit_uid, err_msg);
-	slurm_mutex_unlock(&g_context_lock);
+	pthread_rwlock_unlock(&g_context_lock);
 	END_TIMER2("job_submit_plugin_submit");
 
 	return rc;
@@ -247,10 +252,10 @@ extern int job_submit_plugin_modify(struct job_descriptor *job_desc,
 
 	START_TIMER;
 	rc = job_submit_plugin_init();
-	slurm_mutex_lock(&g_context_lock);
+	pthread_rwlock_rdlock(&g_context_lock);
 	for (i = 0; ((i < g_context_cnt) && (rc == SLURM_SUCCESS)); i++)
 		rc = (*(ops[i].modify))(job_desc, job_ptr, submit_uid);
-	slurm_mutex_unlock(&g_context_lock);
+	pthread_rwlock_unlock(&g_context_lock);
 	END_TIMER2("job_submit_plugin_modify");
 
 	return rc;
@@ -40,8 +40,10 @@
 #include <errno.h>
 #include <pthread.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 
+#include "src/common/lock_stats.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
 
@@ -51,6 +53,11 @@ static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static slurmctld_lock_flags_t slurmctld_locks;
 
+/* Per thread accumulator of lock wait time, see lock_wait_account() */
+static pthread_key_t lock_wait_key;
+static pthread_once_t lock_wait_once = PTHREAD_ONCE_INIT;
+static bool lock_wait_used = false;
+
 static void _wr_rdlock(lock_datatype_t datatype);
 static void _wr_rdunlock(lock_datatype_t datatype);
 static void _wr_wrlock(lock_datatype_t datatype);
@@ -117,11 +124,37 @@ void init_locks(void)
 	memset((void *) &slurmctld_locks, 0, sizeof(slurmctld_locks));
 }
 
+static void _lock_wait_key_create(void)
+{
+	if (pthread_key_create(&lock_wait_key, NULL))
+		fatal("%s: pthread_key_create: %m", __func__);
+	lock_wait_used = true;
+}
+
+/* lock_wait_account - Add the time the calling thread spends waiting in
+ *	lock_slurmctld() to *wait_usec from now on, stop when called with NULL
+ */
+extern void lock_wait_account(uint64_t *wait_usec)
+{
+	pthread_once(&lock_wait_once, _lock_wait_key_create);
+	pthread_setspecific(lock_wait_key, wait_usec);
+}
+
 /* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld(slurmctld_lock_t lock_levels)
+extern void lock_slurmctld_at(slurmctld_lock_t lock_levels, const char *file,
+			      int line, const char *func)
 {
+	uint64_t *wait_usec = NULL;
+	bool stats = lock_stats_enabled;
+	struct timeval tv1, tv2;
+
 	xassert(_store_locks(lock_levels));
 
+	if (lock_wait_used)
+		wait_usec = pthread_getspecific(lock_wait_key);
+	if (wait_usec || stats)
+		gettimeofday(&tv1, NULL);
+
 	if (lock_levels.config == READ_LOCK)
 		_wr_rdlock(CONFIG_LOCK);
 	else if (lock_levels.config == WRITE_LOCK)
@@ -146,6 +179,17 @@ extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 		_wr_rdlock(FED_LOCK);
 	else if (lock_levels.federation == WRITE_LOCK)
 		_wr_wrlock(FED_LOCK);
+
+	if (wait_usec) {
+		gettimeofday(&tv2, NULL);
+		*wait_usec += (tv2.tv_sec - tv1.tv_sec) * 1000000 +
+			      (tv2.tv_usec - tv1.tv_usec);
+	}
+	if (stats) {
+		lock_stats_acquired(LOCK_STATS_SLURMCTLD,
+				    (lock_level_t *) &lock_levels, file, line,
+				    func, &tv1);
+	}
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
@@ -178,6 +222,8 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 		_wr_rdunlock(CONFIG_LOCK);
 	else if (lock_levels.config == WRITE_LOCK)
 		_wr_wrunlock(CONFIG_LOCK);
+
+	lock_stats_released(LOCK_STATS_SLURMCTLD);
 }
 
 /* _wr_rdlock - Issue a read lock on the specified data type
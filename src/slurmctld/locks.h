@@ -92,6 +92,7 @@
 #define _SLURMCTLD_LOCKS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /* levels of locking required for each data structure */
 typedef enum {
@@ -149,13 +150,22 @@ extern void get_lock_values (slurmctld_lock_flags_t *lock_flags);
  *	control */
 extern void init_locks ( void );
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld (slurmctld_lock_t lock_levels);
+/* lock_slurmctld - Issue the required lock requests in a well defined order
+ *	The call site is recorded for SchedulerParameters=lock_stats */
+#define lock_slurmctld(lock_levels) \
+	lock_slurmctld_at(lock_levels, __FILE__, __LINE__, __func__)
+extern void lock_slurmctld_at(slurmctld_lock_t lock_levels, const char *file,
+			      int line, const char *func);
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
 extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
+/* lock_wait_account - Add the time the calling thread spends waiting in
+ *	lock_slurmctld() to *wait_usec from now on, stop when called with NULL
+ */
+extern void lock_wait_account(uint64_t *wait_usec);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
@@ -72,6 +72,7 @@
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/locks.h"
+#include "src/slurmctld/node_scheduler.h"
 #include "src/slurmctld/ping_nodes.h"
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
@@ -798,7 +799,8 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t protocol_version)
 {
 	int inx;
-	uint32_t nodes_packed, tmp_offset, node_scaling;
+	uint32_t nodes_packed, tmp_offset, node_scaling, first_offset;
+	uint32_t *rec_offsets = NULL;
 	Buf buffer;
 	time_t now = time(NULL);
 	struct node_record *node_ptr = node_record_table_ptr;
@@ -822,12 +824,23 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 
 		pack_time(now, buffer);
 
+		if (show_flags & SHOW_REC_INDEX) {
+			rec_offsets = xmalloc(sizeof(uint32_t) *
+					      (node_record_count + 1));
+		}
+		first_offset = get_buf_offset(buffer);
+
 		/* write node records */
 		for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
 			xassert (node_ptr->magic == NODE_MAGIC);
 			xassert (node_ptr->config_ptr->magic ==
 				 CONFIG_MAGIC);
 
+			if (rec_offsets) {
+				rec_offsets[nodes_packed] =
+					get_buf_offset(buffer) - first_offset;
+			}
+
 			/* We can't avoid packing node records without breaking
 			 * the node index pointers. So pack a node
 			 * with a name of NULL and let the caller deal
@@ -857,6 +870,11 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			}
 			nodes_packed++;
 		}
+
+		if (rec_offsets) {
+			pack_rec_index(rec_offsets, nodes_packed, buffer);
+			xfree(rec_offsets);
+		}
 	} else {
 		error("select_g_select_jobinfo_pack: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -1848,6 +1866,7 @@ static int _update_node_weight(char *node_names, uint32_t weight)
 	}
 	list_iterator_destroy(config_iterator);
 	FREE_NULL_BITMAP(node_bitmap);
+	node_set_cache_clear();
 
 	info("_update_node_weight: nodes %s weight set to: %u",
 		node_names, weight);
@@ -2345,6 +2364,7 @@ static void _split_node_config(struct node_record *node_ptr,
 	}
 	config_ptr->cores = reg_msg->cores;
 	config_ptr->sockets = reg_msg->sockets;
+	node_set_cache_clear();
 }
 
 /*
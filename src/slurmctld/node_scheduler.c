@@ -86,6 +86,7 @@
 #include "src/slurmctld/slurmctld_plugstack.h"
 
 #define MAX_FEATURES  32	/* max exclusive features "[fs1|fs2]"=2 */
+#define NODE_SET_CACHE_SIZE 256	/* entries in node_set_cache, power of 2 */
 
 struct node_set {		/* set of nodes with same configuration */
 	uint16_t cpus_per_node;	/* NOTE: This is the minimum count,
@@ -101,6 +102,31 @@ struct node_set {		/* set of nodes with same configuration */
 	bitstr_t *my_bitmap;		/* node bitmap */
 };
 
+/*
+ * Result of _build_node_list() for one combination of partition, feature
+ * expression and per-node job constraints. Many pending jobs typically make
+ * identical requests, so this avoids rebuilding the node sets for each of
+ * them on every scheduling pass.
+ */
+typedef struct node_set_cache {
+	struct part_record *part_ptr;	/* NULL if entry unused */
+	char *features;
+	uint32_t pn_min_cpus;
+	uint64_t pn_min_memory;		/* without MEM_PER_CPU flag */
+	uint32_t pn_min_tmp_disk;
+	uint16_t ntasks_per_core;
+	uint16_t sockets_per_node;
+	uint16_t cores_per_socket;
+	uint16_t threads_per_core;
+	bool test_only;
+	bool can_reboot;
+	time_t build_time;		/* time entry was created */
+	struct node_set *node_set_ptr;	/* before power save split */
+	int node_set_size;
+} node_set_cache_t;
+
+static node_set_cache_t node_set_cache[NODE_SET_CACHE_SIZE];
+
 static int  _build_node_list(struct job_record *job_ptr,
 			     struct node_set **node_set_pptr,
 			     int *node_set_size, char **err_msg,
@@ -3252,6 +3278,210 @@ static int _no_reg_nodes(void)
 	return node_count;
 }
 
+/* Free an array of node_set records */
+static void _node_set_free(struct node_set *node_set_ptr, int node_set_size)
+{
+	int i;
+
+	for (i = 0; i < node_set_size; i++) {
+		xfree(node_set_ptr[i].features);
+		FREE_NULL_BITMAP(node_set_ptr[i].my_bitmap);
+		FREE_NULL_BITMAP(node_set_ptr[i].feature_bits);
+	}
+	xfree(node_set_ptr);
+}
+
+/* Return a copy of node_set_size records in a new array of node_set_len */
+static struct node_set *_node_set_copy(struct node_set *node_set_ptr,
+				       int node_set_size, int node_set_len)
+{
+	struct node_set *new_ptr;
+	int i;
+
+	new_ptr = xmalloc(sizeof(struct node_set) * node_set_len);
+	for (i = 0; i < node_set_size; i++) {
+		new_ptr[i] = node_set_ptr[i];
+		new_ptr[i].features = xstrdup(node_set_ptr[i].features);
+		new_ptr[i].my_bitmap = bit_copy(node_set_ptr[i].my_bitmap);
+		new_ptr[i].feature_bits = bit_copy(node_set_ptr[i].feature_bits);
+	}
+	return new_ptr;
+}
+
+/*
+ * Return true if the job's node sets depend only upon the fields recorded in
+ * node_set_cache_t. Reservations are time dependent and excluded nodes are
+ * rarely shared between jobs. With FastSchedule=0 the node sets depend upon
+ * the resources each node registered with.
+ */
+static bool _node_set_cache_usable(struct job_record *job_ptr)
+{
+	if (!slurmctld_conf.fast_schedule || job_ptr->resv_name ||
+	    job_ptr->resv_ptr || job_ptr->details->exc_node_bitmap)
+		return false;
+	return true;
+}
+
+static void _node_set_cache_key(struct job_record *job_ptr, bool test_only,
+				bool can_reboot, node_set_cache_t *key)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	multi_core_data_t *mc_ptr = detail_ptr->mc_ptr;
+
+	memset(key, 0, sizeof(node_set_cache_t));
+	key->part_ptr = job_ptr->part_ptr;
+	key->features = detail_ptr->features;
+	key->pn_min_cpus = detail_ptr->pn_min_cpus;
+	key->pn_min_memory = detail_ptr->pn_min_memory & (~MEM_PER_CPU);
+	key->pn_min_tmp_disk = detail_ptr->pn_min_tmp_disk;
+	key->ntasks_per_core = _get_ntasks_per_core(detail_ptr);
+	if (mc_ptr) {
+		key->sockets_per_node = mc_ptr->sockets_per_node;
+		key->cores_per_socket = mc_ptr->cores_per_socket;
+		key->threads_per_core = mc_ptr->threads_per_core;
+	} else {
+		key->sockets_per_node = NO_VAL16;
+		key->cores_per_socket = NO_VAL16;
+		key->threads_per_core = NO_VAL16;
+	}
+	key->test_only = test_only;
+	key->can_reboot = can_reboot;
+}
+
+/* FNV-1a hash of a node_set_cache key */
+static uint32_t _node_set_cache_hash(node_set_cache_t *key)
+{
+	uint64_t vals[4];
+	unsigned char *p;
+	uint32_t hash = 2166136261U;
+	int i;
+
+	vals[0] = (uint64_t) (uintptr_t) key->part_ptr;
+	vals[1] = key->pn_min_memory;
+	vals[2] = ((uint64_t) key->pn_min_cpus << 32) | key->pn_min_tmp_disk;
+	vals[3] = ((uint64_t) key->ntasks_per_core  << 48) |
+		  ((uint64_t) key->sockets_per_node << 32) |
+		  ((uint64_t) key->cores_per_socket << 16) |
+		  key->threads_per_core;
+	p = (unsigned char *) vals;
+	for (i = 0; i < sizeof(vals); i++)
+		hash = (hash ^ p[i]) * 16777619U;
+	for (p = (unsigned char *) key->features; p && *p; p++)
+		hash = (hash ^ *p) * 16777619U;
+	hash = (hash ^ (key->test_only | (key->can_reboot << 1))) * 16777619U;
+
+	return hash & (NODE_SET_CACHE_SIZE - 1);
+}
+
+/* Return the cache entry matching key or NULL if none */
+static node_set_cache_t *_node_set_cache_find(node_set_cache_t *key)
+{
+	node_set_cache_t *ent = &node_set_cache[_node_set_cache_hash(key)];
+
+	if ((ent->part_ptr != key->part_ptr) ||
+	    (ent->build_time <= last_part_update) ||
+	    (ent->pn_min_cpus != key->pn_min_cpus) ||
+	    (ent->pn_min_memory != key->pn_min_memory) ||
+	    (ent->pn_min_tmp_disk != key->pn_min_tmp_disk) ||
+	    (ent->ntasks_per_core != key->ntasks_per_core) ||
+	    (ent->sockets_per_node != key->sockets_per_node) ||
+	    (ent->cores_per_socket != key->cores_per_socket) ||
+	    (ent->threads_per_core != key->threads_per_core) ||
+	    (ent->test_only != key->test_only) ||
+	    (ent->can_reboot != key->can_reboot) ||
+	    xstrcmp(ent->features, key->features))
+		return NULL;
+	return ent;
+}
+
+/* Record a copy of the node sets built for key, replacing any older entry */
+static void _node_set_cache_add(node_set_cache_t *key,
+				struct node_set *node_set_ptr,
+				int node_set_size)
+{
+	node_set_cache_t *ent = &node_set_cache[_node_set_cache_hash(key)];
+
+	if (ent->part_ptr) {
+		xfree(ent->features);
+		_node_set_free(ent->node_set_ptr, ent->node_set_size);
+	}
+	*ent = *key;
+	ent->features = xstrdup(key->features);
+	ent->build_time = time(NULL);
+	ent->node_set_ptr = _node_set_copy(node_set_ptr, node_set_size,
+					   node_set_size);
+	ent->node_set_size = node_set_size;
+}
+
+/*
+ * node_set_cache_clear - discard the node sets cached by select_nodes(),
+ *	to be called when node configurations, node features or partition
+ *	node lists change
+ */
+extern void node_set_cache_clear(void)
+{
+	node_set_cache_t *ent;
+	int i;
+
+	for (i = 0, ent = node_set_cache; i < NODE_SET_CACHE_SIZE;
+	     i++, ent++) {
+		if (!ent->part_ptr)
+			continue;
+		xfree(ent->features);
+		_node_set_free(ent->node_set_ptr, ent->node_set_size);
+		memset(ent, 0, sizeof(node_set_cache_t));
+	}
+}
+
+/*
+ * If any nodes are powered down, put them into a new node_set record with a
+ * higher scheduling weight. This means we avoid scheduling jobs on powered
+ * down nodes where possible.
+ */
+static void _split_power_node_sets(struct node_set *node_set_ptr,
+				   int *node_set_inx, int node_set_len)
+{
+	int i, power_cnt, inx = *node_set_inx;
+
+	for (i = (inx - 1); i >= 0; i--) {
+		power_cnt = bit_overlap(node_set_ptr[i].my_bitmap,
+					power_node_bitmap);
+		if (power_cnt == 0)
+			continue;	/* no nodes powered down */
+		if (power_cnt == node_set_ptr[i].nodes) {
+			if (node_set_ptr[i].weight != INFINITE)
+				node_set_ptr[i].weight = INFINITE;
+			continue;	/* all nodes powered down */
+		}
+
+		/* Some nodes powered down, others up, split record */
+		node_set_ptr[inx].cpus_per_node =
+			node_set_ptr[i].cpus_per_node;
+		node_set_ptr[inx].real_memory =
+			node_set_ptr[i].real_memory;
+		node_set_ptr[inx].nodes = power_cnt;
+		node_set_ptr[i].nodes -= power_cnt;
+		node_set_ptr[inx].weight = node_set_ptr[i].weight;
+		if (node_set_ptr[inx].weight != INFINITE)
+			node_set_ptr[inx].weight = INFINITE;
+		node_set_ptr[inx].features =
+			xstrdup(node_set_ptr[i].features);
+		node_set_ptr[inx].feature_bits =
+			bit_copy(node_set_ptr[i].feature_bits);
+		node_set_ptr[inx].my_bitmap =
+			bit_copy(node_set_ptr[i].my_bitmap);
+		bit_and(node_set_ptr[inx].my_bitmap, power_node_bitmap);
+		bit_and_not(node_set_ptr[i].my_bitmap, power_node_bitmap);
+
+		inx++;
+		if (inx >= node_set_len) {
+			error("%s: node_set buffer filled", __func__);
+			break;
+		}
+	}
+	*node_set_inx = inx;
+}
+
 /*
  * _build_node_list - identify which nodes could be allocated to a job
  *	based upon node features, memory, processors, etc. Note that a
@@ -3271,8 +3501,10 @@ static int _build_node_list(struct job_record *job_ptr,
 			    int *node_set_size, char **err_msg, bool test_only,
 			    bool can_reboot)
 {
-	int adj_cpus, i, node_set_inx, node_set_len, power_cnt, rc;
+	int adj_cpus, node_set_inx, node_set_len, rc;
 	struct node_set *node_set_ptr, *prev_node_set_ptr;
+	node_set_cache_t cache_key, *cache_ptr;
+	bool use_cache;
 	struct config_record *config_ptr;
 	struct part_record *part_ptr = job_ptr->part_ptr;
 	ListIterator config_iterator;
@@ -3291,6 +3523,28 @@ static int _build_node_list(struct job_record *job_ptr,
 		return ESLURM_INVALID_NODE_COUNT;
 	}
 
+	use_cache = _node_set_cache_usable(job_ptr);
+	if (use_cache) {
+		_node_set_cache_key(job_ptr, test_only, can_reboot,
+				    &cache_key);
+		if ((cache_ptr = _node_set_cache_find(&cache_key))) {
+			slurmctld_diag_stats.node_set_cache_hits++;
+			node_set_inx = cache_ptr->node_set_size;
+			node_set_len = list_count(config_list) * 4 + 1;
+			node_set_ptr = _node_set_copy(cache_ptr->node_set_ptr,
+						      node_set_inx,
+						      node_set_len);
+			if (err_msg)
+				xfree(*err_msg);
+			_split_power_node_sets(node_set_ptr, &node_set_inx,
+					       node_set_len);
+			*node_set_size = node_set_inx;
+			*node_set_pptr = node_set_ptr;
+			return SLURM_SUCCESS;
+		}
+		slurmctld_diag_stats.node_set_cache_misses++;
+	}
+
 	if (job_ptr->resv_name) {
 		/* Limit node selection to those in selected reservation.
 		 * Assume node reboot required since we have not selected the
@@ -3553,46 +3807,9 @@ static int _build_node_list(struct job_record *job_ptr,
 	if (err_msg)
 		xfree(*err_msg);
 
-	/* If any nodes are powered down, put them into a new node_set
-	 * record with a higher scheduling weight. This means we avoid
-	 * scheduling jobs on powered down nodes where possible. */
-	for (i = (node_set_inx-1); i >= 0; i--) {
-		power_cnt = bit_overlap(node_set_ptr[i].my_bitmap,
-					power_node_bitmap);
-		if (power_cnt == 0)
-			continue;	/* no nodes powered down */
-		if (power_cnt == node_set_ptr[i].nodes) {
-			if (node_set_ptr[i].weight != INFINITE)
-				node_set_ptr[i].weight = INFINITE;
-			continue;	/* all nodes powered down */
-		}
-
-		/* Some nodes powered down, others up, split record */
-		node_set_ptr[node_set_inx].cpus_per_node =
-			node_set_ptr[i].cpus_per_node;
-		node_set_ptr[node_set_inx].real_memory =
-			node_set_ptr[i].real_memory;
-		node_set_ptr[node_set_inx].nodes = power_cnt;
-		node_set_ptr[i].nodes -= power_cnt;
-		node_set_ptr[node_set_inx].weight = node_set_ptr[i].weight;
-		if (node_set_ptr[node_set_inx].weight != INFINITE)
-			node_set_ptr[node_set_inx].weight = INFINITE;
-		node_set_ptr[node_set_inx].features =
-			xstrdup(node_set_ptr[i].features);
-		node_set_ptr[node_set_inx].feature_bits =
-			bit_copy(node_set_ptr[i].feature_bits);
-		node_set_ptr[node_set_inx].my_bitmap =
-			bit_copy(node_set_ptr[i].my_bitmap);
-		bit_and(node_set_ptr[node_set_inx].my_bitmap,
-			power_node_bitmap);
-		bit_and_not(node_set_ptr[i].my_bitmap, power_node_bitmap);
-
-		node_set_inx++;
-		if (node_set_inx >= node_set_len) {
-			error("%s: node_set buffer filled", __func__);
-			break;
-		}
-	}
+	if (use_cache)
+		_node_set_cache_add(&cache_key, node_set_ptr, node_set_inx);
+	_split_power_node_sets(node_set_ptr, &node_set_inx, node_set_len);
 
 	*node_set_size = node_set_inx;
 	*node_set_pptr = node_set_ptr;
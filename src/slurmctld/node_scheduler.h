@@ -97,6 +97,13 @@ extern void filter_by_node_mcs(struct job_record *job_ptr, int mcs_select,
 extern void filter_by_node_owner(struct job_record *job_ptr,
 				 bitstr_t *usable_node_mask);
 
+/*
+ * node_set_cache_clear - discard the node sets cached by select_nodes(),
+ *	to be called when node configurations, node features or partition
+ *	node lists change
+ */
+extern void node_set_cache_clear(void);
+
 /*
  * re_kill_job - for a given job, deallocate its nodes for a second time,
  *	basically a cleanup for failed deallocate() calls
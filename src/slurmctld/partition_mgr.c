@@ -64,6 +64,7 @@
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/groups.h"
 #include "src/slurmctld/locks.h"
+#include "src/slurmctld/node_scheduler.h"
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
@@ -253,6 +254,7 @@ extern int build_part_bitmap(struct part_record *part_ptr)
 
 	_unlink_free_nodes(old_bitmap, part_ptr);
 	last_node_update = time(NULL);
+	node_set_cache_clear();
 	FREE_NULL_BITMAP(old_bitmap);
 	return 0;
 }
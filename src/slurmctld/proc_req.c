@@ -61,6 +61,7 @@
 #include "src/common/group_cache.h"
 #include "src/common/hostlist.h"
 #include "src/common/layouts_mgr.h"
+#include "src/common/lock_stats.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
@@ -107,6 +108,7 @@ static int rpc_type_size = 0;	/* Size of rpc_type_* arrays */
 static uint16_t *rpc_type_id = NULL;
 static uint32_t *rpc_type_cnt = NULL;
 static uint64_t *rpc_type_time = NULL;
+static rpc_latency_t *rpc_type_latency = NULL;
 static int rpc_user_size = 0;	/* Size of rpc_user_* arrays */
 static uint32_t *rpc_user_id = NULL;
 static uint32_t *rpc_user_cnt = NULL;
@@ -243,6 +245,23 @@ extern diag_stats_t slurmctld_diag_stats;
 static __thread bool drop_priv = false;
 #endif
 
+/* Add a latency sample in usec to the histogram of an RPC processing phase */
+static void _rpc_latency_add(rpc_latency_t *latency,
+			     enum rpc_latency_phase phase, int64_t usec)
+{
+	int bucket = 0;
+	uint64_t val;
+
+	if (usec < 0)
+		usec = 0;
+	for (val = usec; val && (bucket < (RPC_LATENCY_BUCKETS - 1));
+	     val >>= 1)
+		bucket++;
+	latency->hist[phase][bucket]++;
+	if (usec > latency->max[phase])
+		latency->max[phase] = MIN(usec, INFINITE - 1);
+}
+
 /*
  * slurmctld_req  - Process an individual RPC request
  * IN/OUT msg - the request message, data associated with the message is freed
@@ -252,6 +271,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 	DEF_TIMERS;
 	int i, rpc_type_index = -1, rpc_user_index = -1;
 	uint32_t rpc_uid;
+	uint64_t lock_wait = 0;
 
 	if (arg && (arg->newsockfd >= 0))
 		fd_set_nonblocking(arg->newsockfd);
@@ -275,6 +295,8 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		rpc_type_id   = xmalloc(sizeof(uint16_t) * rpc_type_size);
 		rpc_type_cnt  = xmalloc(sizeof(uint32_t) * rpc_type_size);
 		rpc_type_time = xmalloc(sizeof(uint64_t) * rpc_type_size);
+		rpc_type_latency = xmalloc(sizeof(rpc_latency_t) *
+					   rpc_type_size);
 	}
 	for (i = 0; i < rpc_type_size; i++) {
 		if (rpc_type_id[i] == 0)
@@ -303,6 +325,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 	/* Debug the protocol layer.
 	 */
 	START_TIMER;
+	lock_wait_account(&lock_wait);
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
 		char *p = rpc_num2string(msg->msg_type);
 		if (msg->conn) {
@@ -599,10 +622,22 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 	}
 
 	END_TIMER;
+	lock_wait_account(NULL);
 	slurm_mutex_lock(&rpc_mutex);
 	if (rpc_type_index >= 0) {
+		rpc_latency_t *latency = &rpc_type_latency[rpc_type_index];
 		rpc_type_cnt[rpc_type_index]++;
 		rpc_type_time[rpc_type_index] += DELTA_TIMER;
+		if (arg) {
+			_rpc_latency_add(latency, RPC_LATENCY_QUEUE,
+				(tv1.tv_sec - arg->accept_time.tv_sec) *
+				1000000 +
+				(tv1.tv_usec - arg->accept_time.tv_usec));
+		}
+		_rpc_latency_add(latency, RPC_LATENCY_LOCK, lock_wait);
+		_rpc_latency_add(latency, RPC_LATENCY_RUN,
+				 ((int64_t) lock_wait < DELTA_TIMER) ?
+				 (DELTA_TIMER - lock_wait) : 0);
 	}
 	if (rpc_user_index >= 0) {
 		rpc_user_cnt[rpc_user_index]++;
@@ -1076,8 +1111,9 @@ static int _make_step_cred(struct step_record *step_ptr,
 	cred_arg.sockets_per_node    = job_resrcs_ptr->sockets_per_node;
 	cred_arg.sock_core_rep_count = job_resrcs_ptr->sock_core_rep_count;
 
-	*slurm_cred = slurm_cred_create(slurmctld_config.cred_ctx, &cred_arg,
-					protocol_version);
+	/* Signing is left to the caller, it need not hold the job lock */
+	*slurm_cred = slurm_cred_create_unsigned(slurmctld_config.cred_ctx,
+						 &cred_arg);
 
 	if (*slurm_cred == NULL) {
 		error("slurm_cred_create error");
@@ -2698,9 +2734,13 @@ static void _slurm_rpc_job_step_create(slurm_msg_t * msg)
 	job_step_create_request_msg_t *req_step_msg =
 		(job_step_create_request_msg_t *) msg->data;
 	slurm_cred_t *slurm_cred = (slurm_cred_t *) NULL;
+	struct job_record *job_ptr;
 	/* Locks: Write jobs, read nodes */
 	slurmctld_lock_t job_write_lock = {
 		NO_LOCK, WRITE_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
+	/* Locks: Read jobs, read nodes */
+	slurmctld_lock_t job_read_lock = {
+		NO_LOCK, READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred,
 					 slurmctld_config.auth_info);
 
@@ -2752,12 +2792,41 @@ static void _slurm_rpc_job_step_create(slurm_msg_t * msg)
 					     step_rec->start_protocol_ver);
 		ext_sensors_g_get_stepstartdata(step_rec);
 	}
+#ifdef HAVE_FRONT_END
+	if ((error_code == SLURM_SUCCESS) && step_rec->job_ptr->batch_host) {
+		step_rec->step_layout->front_end =
+			xstrdup(step_rec->job_ptr->batch_host);
+	}
+#endif
 	END_TIMER2("_slurm_rpc_job_step_create");
 
+	/*
+	 * Signing the credential takes longer than creating the step, so do
+	 * it without blocking other users of the job write lock. The step
+	 * may be gone once the read lock is taken.
+	 */
+	if (error_code == SLURM_SUCCESS) {
+		uint32_t job_id = step_rec->job_ptr->job_id;
+		uint32_t step_id = step_rec->step_id;
+		uint16_t start_protocol_ver = step_rec->start_protocol_ver;
+
+		unlock_slurmctld(job_write_lock);
+		if (slurm_cred_sign(slurmctld_config.cred_ctx, slurm_cred,
+				    start_protocol_ver) < 0)
+			error_code = ESLURM_INVALID_JOB_CREDENTIAL;
+		lock_slurmctld(job_read_lock);
+		if (!(job_ptr = find_job_record(job_id)) ||
+		    !(step_rec = find_step_record(job_ptr, step_id)))
+			error_code = ESLURM_ALREADY_DONE;
+		if (error_code)
+			unlock_slurmctld(job_read_lock);
+	} else
+		unlock_slurmctld(job_write_lock);
+
 	/* return result */
 	if (error_code) {
-		unlock_slurmctld(job_write_lock);
 		_throttle_fini(&active_rpc_cnt);
+		slurm_cred_destroy(slurm_cred);
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_STEPS) {
 			if ((error_code == ESLURM_PROLOG_RUNNING) ||
 			    (error_code == ESLURM_DISABLED)) { /*job suspended*/
@@ -2774,8 +2843,6 @@ static void _slurm_rpc_job_step_create(slurm_msg_t * msg)
 		}
 		slurm_send_rc_msg(msg, error_code);
 	} else {
-		slurm_step_layout_t *layout = step_rec->step_layout;
-
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_STEPS)
 			info("sched: %s: StepId=%u.%u %s %s",
 			     __func__,
@@ -2784,19 +2851,13 @@ static void _slurm_rpc_job_step_create(slurm_msg_t * msg)
 
 		job_step_resp.job_step_id = step_rec->step_id;
 		job_step_resp.resv_ports  = step_rec->resv_ports;
-		job_step_resp.step_layout = layout;
-#ifdef HAVE_FRONT_END
-		if (step_rec->job_ptr->batch_host) {
-			job_step_resp.step_layout->front_end =
-				xstrdup(step_rec->job_ptr->batch_host);
-		}
-#endif
+		job_step_resp.step_layout = step_rec->step_layout;
 		job_step_resp.cred           = slurm_cred;
 		job_step_resp.use_protocol_ver = step_rec->start_protocol_ver;
 		job_step_resp.select_jobinfo = step_rec->select_jobinfo;
 		job_step_resp.switch_job     = step_rec->switch_job;
 
-		unlock_slurmctld(job_write_lock);
+		unlock_slurmctld(job_read_lock);
 		_throttle_fini(&active_rpc_cnt);
 		slurm_msg_t_init(&resp);
 		resp.flags = msg->flags;
@@ -6247,6 +6308,7 @@ static void _clear_rpc_stats(void)
 		rpc_type_cnt[i] = 0;
 		rpc_type_id[i] = 0;
 		rpc_type_time[i] = 0;
+		memset(&rpc_type_latency[i], 0, sizeof(rpc_latency_t));
 	}
 	for (i = 0; i < rpc_user_size; i++) {
 		rpc_user_cnt[i] = 0;
@@ -6288,6 +6350,50 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
+/*
+ * Append the latency histograms of each RPC type, without their trailing
+ * empty buckets, then the lock statistics of each call site. These follow
+ * pack_all_stat_ext() so that older 17.11 clients can ignore them.
+ */
+static void _pack_rpc_latency(int resp, char **buffer_ptr, int *buffer_size,
+			      uint16_t protocol_version)
+{
+	rpc_latency_t *latency;
+	uint32_t i, bucket_cnt;
+	int phase;
+	Buf buffer;
+
+	if (!resp || (protocol_version < SLURM_17_11_PROTOCOL_VERSION))
+		return;
+
+	slurm_mutex_lock(&rpc_mutex);
+	buffer = create_buf(*buffer_ptr, *buffer_size);
+	set_buf_offset(buffer, *buffer_size);
+	for (i = 0; i < rpc_type_size; i++) {
+		if (rpc_type_id[i] == 0)
+			break;
+	}
+	pack32(i, buffer);
+	for (i = 0, latency = rpc_type_latency;
+	     (i < rpc_type_size) && rpc_type_id[i]; i++, latency++) {
+		pack16(rpc_type_id[i], buffer);
+		for (phase = 0; phase < RPC_LATENCY_PHASES; phase++) {
+			for (bucket_cnt = RPC_LATENCY_BUCKETS; bucket_cnt;
+			     bucket_cnt--) {
+				if (latency->hist[phase][bucket_cnt - 1])
+					break;
+			}
+			pack32_array(latency->hist[phase], bucket_cnt, buffer);
+			pack32(latency->max[phase], buffer);
+		}
+	}
+	slurm_mutex_unlock(&rpc_mutex);
+	lock_stats_pack(buffer);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /* _slurm_rpc_dump_stats - process RPC for statistics information */
 inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
 {
@@ -6320,6 +6426,7 @@ inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
 	if (request_msg->command_id == STAT_COMMAND_RESET) {
 		reset_stats(1);
 		_clear_rpc_stats();
+		lock_stats_reset();
 		pack_all_stat(0, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(0, &dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
@@ -6327,6 +6434,10 @@ inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
 	} else {
 		pack_all_stat(1, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(1, &dump, &dump_size, msg->protocol_version);
+		pack_all_stat_ext(1, &dump, &dump_size,
+				  msg->protocol_version);
+		_pack_rpc_latency(1, &dump, &dump_size,
+				  msg->protocol_version);
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 	}
@@ -6397,6 +6508,7 @@ extern void free_rpc_stats(void)
 	xfree(rpc_type_cnt);
 	xfree(rpc_type_id);
 	xfree(rpc_type_time);
+	xfree(rpc_type_latency);
 	rpc_type_size = 0;
 
 	xfree(rpc_user_cnt);
@@ -49,6 +49,7 @@
 typedef struct connection_arg {
 	int newsockfd;
 	slurm_addr_t cli_addr;
+	struct timeval accept_time;	/* when the connection was accepted */
 } connection_arg_t;
 
 /* Free memory used to track RPC usage by type and user */
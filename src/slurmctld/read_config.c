@@ -1236,6 +1236,7 @@ int read_slurm_conf(int recover, bool reconfig)
 		build_feature_list_eq();
 	else
 		build_feature_list_ne();
+	node_set_cache_clear();
 
 	_validate_pack_jobs();
 	(void) _sync_nodes_to_comp_job();/* must follow select_g_node_init() */
@@ -1503,6 +1504,7 @@ extern void update_feature_list(List feature_list, char *new_features,
 		xfree(tmp_str);
 	}
 	node_features_updated = true;
+	node_set_cache_clear();
 }
 
 static void _gres_reconfig(bool reconfig)
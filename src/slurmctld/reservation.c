@@ -74,6 +74,7 @@
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/resv_index.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/state_save.h"
 
@@ -98,6 +99,11 @@ time_t    last_resv_update = (time_t) 0;
 List      resv_list = (List) NULL;
 uint32_t  top_suffix = 0;
 
+/* Index of resv_list, rebuilt on first use after any change to it and when
+ * a recurring reservation needs to be advanced */
+static resv_index_t *resv_index = NULL;
+static time_t resv_index_expire = (time_t) 0;
+
 #ifdef HAVE_BG
 uint32_t  cpu_mult = 0;
 uint32_t  cnodes_per_mp = 0;
@@ -157,6 +163,8 @@ static bool _job_overlap(time_t start_time, uint32_t flags,
 static int _job_resv_check(void *x, void *arg);
 static List _list_dup(List license_list);
 static int  _open_resv_state_file(char **state_file);
+static void _resv_index_clear(void);
+static resv_index_t *_resv_index_get(void);
 static void _pack_resv(slurmctld_resv_t *resv_ptr, Buf buffer,
 		       bool internal, uint16_t protocol_version);
 static bitstr_t *_pick_idle_nodes(bitstr_t *avail_nodes,
@@ -1848,6 +1856,49 @@ static bool _job_overlap(time_t start_time, uint32_t flags,
 	return overlap;
 }
 
+static void _resv_index_clear(void)
+{
+	resv_index_free(resv_index);
+	resv_index = NULL;
+}
+
+/*
+ * Return the index of resv_list, building it if needed. Recurring
+ * reservations which have ended are advanced first, as job_test_resv()
+ * used to do for each reservation it looked at.
+ */
+static resv_index_t *_resv_index_get(void)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	time_t now = time(NULL);
+
+	if (resv_index && (now < resv_index_expire))
+		return resv_index;
+
+	_resv_index_clear();
+	resv_index_expire = (time_t) INFINITE;
+	if (!resv_list)
+		return (resv_index = resv_index_build(NULL));
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT)
+			continue;
+		if (resv_ptr->end_time <= now)
+			_advance_resv_time(resv_ptr);
+		if ((resv_ptr->flags & (RESERVE_FLAG_DAILY |
+					RESERVE_FLAG_WEEKDAY |
+					RESERVE_FLAG_WEEKEND |
+					RESERVE_FLAG_WEEKLY)) &&
+		    (resv_ptr->end_time < resv_index_expire))
+			resv_index_expire = resv_ptr->end_time;
+	}
+	list_iterator_destroy(iter);
+	resv_index = resv_index_build(resv_list);
+
+	return resv_index;
+}
+
 /*
  * Test if a new/updated reservation request overlaps an existing
  *	reservation
@@ -1857,20 +1908,22 @@ static bool _resv_overlap(time_t start_time, time_t end_time,
 			  uint32_t flags, bitstr_t *node_bitmap,
 			  slurmctld_resv_t *this_resv_ptr)
 {
-	ListIterator iter;
-	slurmctld_resv_t *resv_ptr;
+	slurmctld_resv_t *resv_ptr, **resv_array;
 	bool rc = false;
-	int i, j;
-	time_t s_time1, s_time2, e_time1, e_time2;
+	int i, j, k, resv_cnt;
+	time_t s_time1, s_time2, e_time1, e_time2, reach_time = end_time;
 
 	if ((flags & RESERVE_FLAG_MAINT)   ||
 	    (flags & RESERVE_FLAG_OVERLAP) ||
 	    (!node_bitmap))
 		return rc;
 
-	iter = list_iterator_create(resv_list);
-
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+	if (flags & RESERVE_FLAG_DAILY)
+		reach_time += RESV_INDEX_DAILY_REACH;
+	resv_cnt = resv_index_find(_resv_index_get(), start_time, reach_time,
+				   node_bitmap, &resv_array);
+	for (k = 0; (k < resv_cnt) && !rc; k++) {
+		resv_ptr = resv_array[k];
 		if (resv_ptr == this_resv_ptr)
 			continue;	/* skip self */
 		if (resv_ptr->node_bitmap == NULL)
@@ -1907,7 +1960,6 @@ static bool _resv_overlap(time_t start_time, time_t end_time,
 				break;
 		}
 	}
-	list_iterator_destroy(iter);
 
 	return rc;
 }
@@ -2546,6 +2598,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 
 	list_append(resv_list, resv_ptr);
 	last_resv_update = now;
+	_resv_index_clear();
 	schedule_resv_save();
 
 	return SLURM_SUCCESS;
@@ -2564,6 +2617,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 /* Purge all reservation data structures */
 extern void resv_fini(void)
 {
+	_resv_index_clear();
 	FREE_NULL_LIST(resv_list);
 }
 
@@ -2958,6 +3012,7 @@ extern int update_resv(resv_desc_msg_t *resv_desc_ptr)
 	_del_resv_rec(resv_backup);
 	(void) set_node_maint_mode(true);
 	last_resv_update = now;
+	_resv_index_clear();
 	schedule_resv_save();
 	return error_code;
 
@@ -2965,6 +3020,7 @@ update_failure:
 	/* Restore backup reservation data */
 	_restore_resv(resv_ptr, resv_backup);
 	_del_resv_rec(resv_backup);
+	_resv_index_clear();
 	return error_code;
 }
 
@@ -3091,6 +3147,7 @@ extern int delete_resv(reservation_name_msg_t *resv_desc_ptr)
 
 	(void) set_node_maint_mode(true);
 	last_resv_update = time(NULL);
+	_resv_index_clear();
 	schedule_resv_save();
 	return rc;
 }
@@ -3389,6 +3446,7 @@ static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr)
 		_set_tres_cnt(resv_ptr, &old_resv_ptr);
 		xfree(old_resv_ptr.tres_str);
 		last_resv_update = time(NULL);
+		_resv_index_clear();
 	} else if (resv_ptr->flags & RESERVE_FLAG_ALL_NODES) {
 		memset(&old_resv_ptr, 0, sizeof(slurmctld_resv_t));
 		FREE_NULL_BITMAP(resv_ptr->node_bitmap);
@@ -3402,6 +3460,7 @@ static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr)
 		_set_tres_cnt(resv_ptr, &old_resv_ptr);
 		xfree(old_resv_ptr.tres_str);
 		last_resv_update = time(NULL);
+		_resv_index_clear();
 	} else if (resv_ptr->node_list) {	/* Change bitmap last */
 #ifdef HAVE_BG
 		int inx;
@@ -3463,6 +3522,7 @@ static void _validate_all_reservations(void)
 		}
 	}
 	list_iterator_destroy(iter);
+	_resv_index_clear();
 
 	/* Validate all job reservation pointers */
 	iter = list_iterator_create(job_list);
@@ -3564,6 +3624,7 @@ static void _resv_node_replace(slurmctld_resv_t *resv_ptr)
 	}
 	FREE_NULL_BITMAP(preserve_bitmap);
 	last_resv_update = time(NULL);
+	_resv_index_clear();
 	schedule_resv_save();
 }
 
@@ -3686,6 +3747,7 @@ extern int load_all_resv_state(int recover)
 	uint16_t protocol_version = NO_VAL16;
 
 	last_resv_update = time(NULL);
+	_resv_index_clear();
 	if ((recover == 0) && resv_list) {
 		_validate_all_reservations();
 		return SLURM_SUCCESS;
@@ -5114,12 +5176,11 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			 bitstr_t **exc_core_bitmap, bool *resv_overlap,
 			 bool reboot)
 {
-	slurmctld_resv_t *resv_ptr = NULL, *res2_ptr;
+	slurmctld_resv_t *resv_ptr = NULL, *res2_ptr, **resv_array;
 	time_t job_start_time, job_end_time, lic_resv_time;
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
-	ListIterator iter;
-	int i, rc = SLURM_SUCCESS, rc2;
+	int i, k, resv_cnt, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
 	job_start_time = *when;
@@ -5188,8 +5249,11 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 
 		/* if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes) */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_cnt = resv_index_find(_resv_index_get(), job_start_time,
+					   job_end_time, *node_bitmap,
+					   &resv_array);
+		for (k = 0; k < resv_cnt; k++) {
+			res2_ptr = resv_array[k];
 			if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
 			    ((resv_ptr->flags & RESERVE_FLAG_OVERLAP) &&
 			     !(res2_ptr->flags & RESERVE_FLAG_MAINT)) ||
@@ -5204,7 +5268,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				bit_and_not(*node_bitmap,res2_ptr->node_bitmap);
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
@@ -5251,8 +5314,12 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		/* Recurring reservations which ended were advanced when the
+		 * index was built */
+		resv_cnt = resv_index_find(_resv_index_get(), job_start_time,
+					   job_end_time, NULL, &resv_array);
+		for (k = 0; k < resv_cnt; k++) {
+			resv_ptr = resv_array[k];
 			if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
 				start_relative = resv_ptr->start_time + now;
 				if (resv_ptr->duration == INFINITE)
@@ -5268,8 +5335,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 						start_relative = end_relative;
 				}
 			} else {
-				if (resv_ptr->end_time <= now)
-					_advance_resv_time(resv_ptr);
 				start_relative = resv_ptr->start_time_first;
 				end_relative = resv_ptr->end_time;
 			}
@@ -5339,7 +5404,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				continue;
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time, reboot)
@@ -5527,6 +5591,7 @@ static void _advance_resv_time(slurmctld_resv_t *resv_ptr)
 		_advance_time(&resv_ptr->end_time, day_cnt);
 		_post_resv_create(resv_ptr);
 		last_resv_update = time(NULL);
+		_resv_index_clear();
 		schedule_resv_save();
 	}
 }
@@ -5657,6 +5722,7 @@ extern void job_resv_check(void)
 			_post_resv_update(resv_ptr, resv_backup); /* accounting */
 			_del_resv_rec(resv_backup);
 			last_resv_update = now;
+			_resv_index_clear();
 			schedule_resv_save();
 		}
 		if (!resv_ptr->run_prolog || !resv_ptr->run_epilog)
@@ -5685,6 +5751,7 @@ extern void job_resv_check(void)
 			_clear_job_resv(resv_ptr);
 			list_delete_item(iter);
 			last_resv_update = now;
+			_resv_index_clear();
 			schedule_resv_save();
 		}
 	}
@@ -5880,6 +5947,7 @@ extern void update_part_nodes_in_resv(struct part_record *part_ptr)
 			_set_tres_cnt(resv_ptr, &old_resv_ptr);
 			xfree(old_resv_ptr.tres_str);
 			last_resv_update = time(NULL);
+			_resv_index_clear();
 		}
 	}
 	list_iterator_destroy(iter);
@@ -0,0 +1,237 @@
+/*****************************************************************************\
+ *  resv_index.c - interval index of reservations
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <stdlib.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/list.h"
+#include "src/common/xmalloc.h"
+#include "src/slurmctld/resv_index.h"
+
+typedef struct resv_index_ent {
+	time_t lo;		/* earliest start time */
+	time_t hi;		/* latest end time */
+	int first_node;		/* first node in node_bitmap */
+	int last_node;		/* last node in node_bitmap */
+	int list_inx;		/* position in resv_list */
+	slurmctld_resv_t *resv_ptr;
+} resv_index_ent_t;
+
+struct resv_index {
+	int ent_cnt;
+	resv_index_ent_t *ents;		/* sorted by lo */
+	time_t *max_hi;			/* largest hi of the subtree at each
+					 * element, see _build_max_hi() */
+	int float_cnt;
+	resv_index_ent_t *floats;	/* RESERVE_FLAG_TIME_FLOAT, always
+					 * tested */
+	int found_cnt;
+	int found_size;
+	resv_index_ent_t **found_ents;
+	slurmctld_resv_t **found;
+};
+
+static int _sort_by_lo(const void *x, const void *y)
+{
+	const resv_index_ent_t *ent1 = x, *ent2 = y;
+
+	if (ent1->lo < ent2->lo)
+		return -1;
+	if (ent1->lo > ent2->lo)
+		return 1;
+	return 0;
+}
+
+static int _sort_by_list_inx(const void *x, const void *y)
+{
+	const resv_index_ent_t *ent1 = *(resv_index_ent_t **) x;
+	const resv_index_ent_t *ent2 = *(resv_index_ent_t **) y;
+
+	return ent1->list_inx - ent2->list_inx;
+}
+
+/*
+ * The sorted array is an implicit binary tree: the element in the middle of
+ * a range is the root of the subtree of that range. max_hi of the root is
+ * the largest hi in the range, so a search can skip ranges which all end
+ * before the time of interest.
+ */
+static time_t _build_max_hi(resv_index_t *index, int first, int last)
+{
+	int mid;
+	time_t max_hi, hi;
+
+	if (first >= last)
+		return 0;
+	mid = first + (last - first) / 2;
+	max_hi = index->ents[mid].hi;
+	hi = _build_max_hi(index, first, mid);
+	if (hi > max_hi)
+		max_hi = hi;
+	hi = _build_max_hi(index, mid + 1, last);
+	if (hi > max_hi)
+		max_hi = hi;
+	index->max_hi[mid] = max_hi;
+	return max_hi;
+}
+
+static void _add_found(resv_index_t *index, resv_index_ent_t *ent,
+		       int first_node, int last_node)
+{
+	if ((first_node >= 0) &&
+	    ((ent->last_node < first_node) || (ent->first_node > last_node)))
+		return;		/* no nodes in common */
+	if (index->found_cnt >= index->found_size) {
+		index->found_size = index->found_size * 2 + 16;
+		xrealloc(index->found_ents,
+			 sizeof(resv_index_ent_t *) * index->found_size);
+		xrealloc(index->found,
+			 sizeof(slurmctld_resv_t *) * index->found_size);
+	}
+	index->found_ents[index->found_cnt++] = ent;
+}
+
+static void _find(resv_index_t *index, int first, int last,
+		  time_t start_time, time_t end_time,
+		  int first_node, int last_node)
+{
+	int mid;
+
+	while (first < last) {
+		mid = first + (last - first) / 2;
+		if (index->max_hi[mid] <= start_time)
+			return;		/* all end before start_time */
+		_find(index, first, mid, start_time, end_time,
+		      first_node, last_node);
+		if (index->ents[mid].lo >= end_time)
+			return;		/* rest start after end_time */
+		if (index->ents[mid].hi > start_time)
+			_add_found(index, &index->ents[mid],
+				   first_node, last_node);
+		first = mid + 1;
+	}
+}
+
+static void _set_ent(resv_index_ent_t *ent, slurmctld_resv_t *resv_ptr,
+		     int list_inx)
+{
+	ent->lo = MIN(resv_ptr->start_time, resv_ptr->start_time_first);
+	ent->hi = resv_ptr->end_time;
+	if (resv_ptr->flags & RESERVE_FLAG_DAILY)
+		ent->hi += RESV_INDEX_DAILY_REACH;
+	ent->first_node = bit_ffs(resv_ptr->node_bitmap);
+	ent->last_node = bit_fls(resv_ptr->node_bitmap);
+	ent->list_inx = list_inx;
+	ent->resv_ptr = resv_ptr;
+}
+
+extern resv_index_t *resv_index_build(List resv_list)
+{
+	resv_index_t *index = xmalloc(sizeof(resv_index_t));
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	int cnt, list_inx = 0;
+
+	if (!resv_list)
+		return index;
+
+	cnt = list_count(resv_list);
+	index->ents = xmalloc(sizeof(resv_index_ent_t) * cnt);
+	index->max_hi = xmalloc(sizeof(time_t) * cnt);
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		list_inx++;
+		if (resv_ptr->node_bitmap == NULL)
+			continue;
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
+			xrealloc(index->floats, sizeof(resv_index_ent_t) *
+						(index->float_cnt + 1));
+			_set_ent(&index->floats[index->float_cnt++], resv_ptr,
+				 list_inx);
+		} else {
+			_set_ent(&index->ents[index->ent_cnt++], resv_ptr,
+				 list_inx);
+		}
+	}
+	list_iterator_destroy(iter);
+
+	qsort(index->ents, index->ent_cnt, sizeof(resv_index_ent_t),
+	      _sort_by_lo);
+	_build_max_hi(index, 0, index->ent_cnt);
+
+	return index;
+}
+
+extern void resv_index_free(resv_index_t *index)
+{
+	if (!index)
+		return;
+	xfree(index->ents);
+	xfree(index->max_hi);
+	xfree(index->floats);
+	xfree(index->found_ents);
+	xfree(index->found);
+	xfree(index);
+}
+
+extern int resv_index_find(resv_index_t *index, time_t start_time,
+			   time_t end_time, bitstr_t *node_bitmap,
+			   slurmctld_resv_t ***resv_array)
+{
+	int i, first_node = -1, last_node = -1;
+
+	if (node_bitmap) {
+		first_node = bit_ffs(node_bitmap);
+		if (first_node == -1) {
+			*resv_array = NULL;
+			return 0;	/* no nodes to overlap */
+		}
+		last_node = bit_fls(node_bitmap);
+	}
+
+	index->found_cnt = 0;
+	_find(index, 0, index->ent_cnt, start_time, end_time,
+	      first_node, last_node);
+	for (i = 0; i < index->float_cnt; i++)
+		_add_found(index, &index->floats[i], first_node, last_node);
+
+	qsort(index->found_ents, index->found_cnt, sizeof(resv_index_ent_t *),
+	      _sort_by_list_inx);
+	for (i = 0; i < index->found_cnt; i++)
+		index->found[i] = index->found_ents[i]->resv_ptr;
+
+	*resv_array = index->found;
+	return index->found_cnt;
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************\
+ *  resv_index.h - interval index of reservations
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _RESV_INDEX_H
+#define _RESV_INDEX_H
+
+#include <time.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/list.h"
+#include "src/slurmctld/slurmctld.h"
+
+/* Margin for the six days a daily reservation's times are moved forward by
+ * when testing overlap, including daylight saving time changes */
+#define RESV_INDEX_DAILY_REACH (8 * 24 * 60 * 60)
+
+typedef struct resv_index resv_index_t;
+
+/*
+ * Build an index of the reservations in resv_list that have a node_bitmap,
+ * by time and by the range of their nodes. The index must be rebuilt after
+ * any reservation is added, removed, or has its times or nodes changed.
+ */
+extern resv_index_t *resv_index_build(List resv_list);
+
+extern void resv_index_free(resv_index_t *index);
+
+/*
+ * Find the reservations which may overlap the time span start_time to
+ * end_time and, if node_bitmap is not NULL, its nodes. The result is a
+ * superset: the caller still tests each reservation. Reservations of
+ * RESERVE_FLAG_TIME_FLOAT and RESERVE_FLAG_DAILY are matched loosely since
+ * their times move. Reservations are returned in resv_list order.
+ * OUT resv_array - set to an array owned by the index and valid until the
+ *	next call
+ * RET count of reservations in resv_array
+ */
+extern int resv_index_find(resv_index_t *index, time_t start_time,
+			   time_t end_time, bitstr_t *node_bitmap,
+			   slurmctld_resv_t ***resv_array);
+
+#endif /* !_RESV_INDEX_H */
@@ -0,0 +1,716 @@
+/*****************************************************************************\
+ *  simulator.c - drive slurmctld with a workload trace and virtual nodes
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * The simulator measures the scheduling throughput of slurmctld without any
+ * slurmd. It registers every configured node itself, submits the jobs of a
+ * workload trace at their (time compressed) submit times and answers the
+ * RPCs that slurmctld sends to the nodes: a batch job launch is completed
+ * once the job's run time has passed, a job termination is followed by an
+ * epilog complete from each node and everything else is a reply from the
+ * node. All of that happens in one thread through the same functions that
+ * process the RPCs from slurmd, so the locks and the scheduler run as they
+ * would with a real cluster.
+ *
+ * Each line of the trace file describes one job:
+ *	<submit_sec> <node_cnt> <run_sec> <time_limit_min> [partition]
+ * with the submit time relative to the start of the trace. Text after a
+ * '#' is a comment. A "Speedup=<factor>" line divides all submit and run
+ * times, and the time limits (to a minimum of one minute), by that factor.
+ */
+
+#include "config.h"
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "src/common/hostlist.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/node_conf.h"
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/agent.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/simulator.h"
+#include "src/slurmctld/slurmctld.h"
+
+/* Longest time to sleep without checking for shutdown, usec */
+#define SIM_POLL_USEC	100000
+
+typedef struct sim_job {
+	int64_t submit_usec;	/* submit time from start of trace */
+	int64_t run_usec;	/* run time of the job */
+	int64_t end_usec;	/* completion time, set at launch */
+	uint32_t node_cnt;
+	uint32_t time_limit;	/* minutes */
+	char *partition;	/* NULL for the default partition */
+	uint32_t job_id;	/* set once submitted */
+	bool started;
+	bool done;		/* completed, killed or rejected */
+	struct sim_job *next;	/* next job in hash chain */
+} sim_job_t;
+
+typedef struct sim_event {
+	slurm_msg_type_t msg_type;
+	uint32_t job_id;
+	char *nodes;		/* nodes the RPC was sent to */
+} sim_event_t;
+
+char *sim_trace_file = NULL;
+
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  sim_cond  = PTHREAD_COND_INITIALIZER;
+static List sim_events = NULL;		/* RPCs not yet processed */
+static bool sim_done = false;
+
+/* Everything below is only used by the simulator thread */
+static sim_job_t *sim_jobs = NULL;	/* trace, sorted by submit time */
+static int sim_job_cnt = 0;
+static sim_job_t **job_hash = NULL;	/* jobs by job_id */
+static uint32_t job_hash_mask = 0;
+static sim_job_t **run_heap = NULL;	/* running jobs by end_usec */
+static int run_heap_cnt = 0;
+
+static int64_t sim_start_usec = 0;
+static int64_t last_start_usec = 0;
+static uint32_t jobs_submitted = 0, jobs_rejected = 0;
+static uint32_t jobs_started = 0, jobs_completed = 0, jobs_killed = 0;
+
+static int64_t lock_start_usec = 0;
+static uint32_t lock_cnt = 0;
+static int64_t lock_wait_sum = 0, lock_wait_max = 0;
+static int64_t lock_hold_sum = 0, lock_hold_max = 0;
+
+static int64_t _usec_now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* lock_slurmctld() recording the time spent waiting for and holding locks */
+static void _sim_lock(slurmctld_lock_t lock_levels)
+{
+	int64_t start = _usec_now(), wait;
+
+	lock_slurmctld(lock_levels);
+	lock_start_usec = _usec_now();
+	wait = lock_start_usec - start;
+	lock_wait_sum += wait;
+	lock_wait_max = MAX(lock_wait_max, wait);
+	lock_cnt++;
+}
+
+static void _sim_unlock(slurmctld_lock_t lock_levels)
+{
+	int64_t hold = _usec_now() - lock_start_usec;
+
+	unlock_slurmctld(lock_levels);
+	lock_hold_sum += hold;
+	lock_hold_max = MAX(lock_hold_max, hold);
+}
+
+static void _event_del(void *x)
+{
+	sim_event_t *event = (sim_event_t *) x;
+
+	xfree(event->nodes);
+	xfree(event);
+}
+
+static int _job_submit_cmp(const void *x, const void *y)
+{
+	const sim_job_t *job1 = x, *job2 = y;
+
+	if (job1->submit_usec < job2->submit_usec)
+		return -1;
+	if (job1->submit_usec > job2->submit_usec)
+		return 1;
+	return 0;
+}
+
+/* Read the workload trace, RET SLURM_SUCCESS or SLURM_ERROR */
+static int _read_trace(void)
+{
+	FILE *fp;
+	char line[1024], part[128], *ptr;
+	double submit, run, speedup = 1.0;
+	uint32_t node_cnt, time_limit;
+	int i, line_num = 0, job_alloc = 0, rc = SLURM_SUCCESS;
+	sim_job_t *job;
+
+	if (!(fp = fopen(sim_trace_file, "r"))) {
+		error("simulator: unable to open %s: %m", sim_trace_file);
+		return SLURM_ERROR;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		line_num++;
+		if ((ptr = strchr(line, '#')))
+			ptr[0] = '\0';
+		for (ptr = line; isspace((int) ptr[0]); ptr++)
+			;
+		if (ptr[0] == '\0')
+			continue;
+		if (!xstrncasecmp(ptr, "Speedup=", 8)) {
+			speedup = strtod(ptr + 8, NULL);
+			if (speedup <= 0.0) {
+				error("simulator: %s line %d: invalid Speedup",
+				      sim_trace_file, line_num);
+				rc = SLURM_ERROR;
+				break;
+			}
+			continue;
+		}
+		part[0] = '\0';
+		if ((sscanf(ptr, "%lf %u %lf %u %127s", &submit, &node_cnt,
+			    &run, &time_limit, part) < 4) ||
+		    (submit < 0.0) || (run < 0.0) || (node_cnt == 0)) {
+			error("simulator: %s line %d: invalid job",
+			      sim_trace_file, line_num);
+			rc = SLURM_ERROR;
+			break;
+		}
+		if (sim_job_cnt >= job_alloc) {
+			job_alloc = MAX(1024, job_alloc * 2);
+			xrealloc(sim_jobs, sizeof(sim_job_t) * job_alloc);
+		}
+		job = &sim_jobs[sim_job_cnt++];
+		job->submit_usec = submit * 1000000.0;
+		job->run_usec = run * 1000000.0;
+		job->node_cnt = node_cnt;
+		job->time_limit = time_limit;
+		if (part[0])
+			job->partition = xstrdup(part);
+	}
+	fclose(fp);
+	if (rc != SLURM_SUCCESS)
+		return rc;
+	if (sim_job_cnt == 0) {
+		error("simulator: %s has no jobs", sim_trace_file);
+		return SLURM_ERROR;
+	}
+
+	for (i = 0, job = sim_jobs; i < sim_job_cnt; i++, job++) {
+		job->submit_usec /= speedup;
+		job->run_usec /= speedup;
+		if (job->time_limit != INFINITE)
+			job->time_limit = MAX(1, job->time_limit / speedup);
+	}
+	qsort(sim_jobs, sim_job_cnt, sizeof(sim_job_t), _job_submit_cmp);
+
+	job_hash_mask = 1;
+	while (job_hash_mask < sim_job_cnt)
+		job_hash_mask <<= 1;
+	job_hash = xmalloc(sizeof(sim_job_t *) * job_hash_mask);
+	job_hash_mask--;
+	run_heap = xmalloc(sizeof(sim_job_t *) * sim_job_cnt);
+
+	info("simulator: %d jobs read from %s, speedup %.1f",
+	     sim_job_cnt, sim_trace_file, speedup);
+	return SLURM_SUCCESS;
+}
+
+static sim_job_t *_find_job(uint32_t job_id)
+{
+	sim_job_t *job;
+
+	if (!job_id)
+		return NULL;
+	for (job = job_hash[job_id & job_hash_mask]; job; job = job->next) {
+		if (job->job_id == job_id)
+			return job;
+	}
+	return NULL;
+}
+
+static void _heap_push(sim_job_t *job)
+{
+	int i = run_heap_cnt++, parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (run_heap[parent]->end_usec <= job->end_usec)
+			break;
+		run_heap[i] = run_heap[parent];
+		i = parent;
+	}
+	run_heap[i] = job;
+}
+
+static sim_job_t *_heap_pop(void)
+{
+	sim_job_t *top = run_heap[0], *last = run_heap[--run_heap_cnt];
+	int i = 0, child;
+
+	while ((child = (2 * i) + 1) < run_heap_cnt) {
+		if (((child + 1) < run_heap_cnt) &&
+		    (run_heap[child + 1]->end_usec < run_heap[child]->end_usec))
+			child++;
+		if (last->end_usec <= run_heap[child]->end_usec)
+			break;
+		run_heap[i] = run_heap[child];
+		i = child;
+	}
+	run_heap[i] = last;
+	return top;
+}
+
+/* Remove a job from the heap of running jobs, if present */
+static void _heap_remove(sim_job_t *job)
+{
+	int i, cnt = run_heap_cnt;
+
+	/* Requeues are rare, rebuild the heap without the job */
+	run_heap_cnt = 0;
+	for (i = 0; i < cnt; i++) {
+		if (run_heap[i] != job)
+			_heap_push(run_heap[i]);
+	}
+}
+
+/* Register every node as a freshly started slurmd with its configuration */
+static void _register_nodes(void)
+{
+	/* Locks: Read config, write job, write node, read federation */
+	slurmctld_lock_t node_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+	slurm_node_registration_status_msg_t *reg_msg;
+	struct node_record *node_ptr;
+	struct config_record *config_ptr;
+	time_t now = time(NULL);
+	bool newly_up = false;
+	int i, reg_cnt = 0;
+
+	_sim_lock(node_write_lock);
+	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
+	     i++, node_ptr++) {
+		config_ptr = node_ptr->config_ptr;
+		reg_msg = xmalloc(sizeof(slurm_node_registration_status_msg_t));
+		reg_msg->node_name = xstrdup(node_ptr->name);
+		reg_msg->version = xstrdup(SLURM_VERSION_STRING);
+		reg_msg->cpus = config_ptr->cpus;
+		reg_msg->boards = config_ptr->boards;
+		reg_msg->sockets = config_ptr->sockets;
+		reg_msg->cores = config_ptr->cores;
+		reg_msg->threads = config_ptr->threads;
+		reg_msg->real_memory = config_ptr->real_memory;
+		reg_msg->tmp_disk = config_ptr->tmp_disk;
+		reg_msg->hash_val = NO_VAL;
+		reg_msg->status = SLURM_SUCCESS;
+		reg_msg->slurmd_start_time = now;
+		reg_msg->timestamp = now;
+		/* No generic resources */
+		reg_msg->gres_info = init_buf(16);
+		pack16(SLURM_PROTOCOL_VERSION, reg_msg->gres_info);
+		pack16(0, reg_msg->gres_info);
+		set_buf_offset(reg_msg->gres_info, 0);
+		if (validate_node_specs(reg_msg, SLURM_PROTOCOL_VERSION,
+					&newly_up) == SLURM_SUCCESS)
+			reg_cnt++;
+		slurm_free_node_registration_status_msg(reg_msg);
+	}
+	_sim_unlock(node_write_lock);
+
+	info("simulator: %d of %d nodes registered", reg_cnt,
+	     node_record_count);
+}
+
+static void _submit_job(sim_job_t *job)
+{
+	/* Locks: Read config, read job, read node, read partition, read
+	 * federation */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
+	/* Locks: Read config, write job, write node, read partition, read
+	 * federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	job_desc_msg_t *job_desc = xmalloc(sizeof(job_desc_msg_t));
+	struct job_record *job_ptr = NULL;
+	char *err_msg = NULL;
+	uid_t uid = getuid();
+	int rc;
+
+	slurm_init_job_desc_msg(job_desc);
+	job_desc->name = xstrdup("sim");
+	job_desc->alloc_node = xstrdup("sim");
+	job_desc->partition = xstrdup(job->partition);
+	job_desc->min_nodes = job->node_cnt;
+	job_desc->max_nodes = job->node_cnt;
+	job_desc->time_limit = job->time_limit;
+	job_desc->user_id = uid;
+	job_desc->group_id = getgid();
+	job_desc->script = xstrdup("#!/bin/sh\n");
+	job_desc->work_dir = xstrdup("/tmp");
+	job_desc->env_size = 1;
+	job_desc->environment = xmalloc(sizeof(char *));
+	job_desc->environment[0] = xstrdup("SLURM_SIMULATOR=1");
+	job_desc->pack_job_offset = NO_VAL;
+
+	_sim_lock(job_read_lock);
+	rc = validate_job_create_req(job_desc, uid, &err_msg);
+	_sim_unlock(job_read_lock);
+
+	if (rc == SLURM_SUCCESS) {
+		_sim_lock(job_write_lock);
+		rc = job_allocate(job_desc, 0, false, NULL, 0, uid, &job_ptr,
+				  &err_msg, SLURM_PROTOCOL_VERSION);
+		if (job_ptr && (!rc || !IS_JOB_FAILED(job_ptr)))
+			job->job_id = job_ptr->job_id;
+		_sim_unlock(job_write_lock);
+	}
+
+	if (job->job_id) {
+		job->next = job_hash[job->job_id & job_hash_mask];
+		job_hash[job->job_id & job_hash_mask] = job;
+		jobs_submitted++;
+		queue_job_scheduler();
+	} else {
+		error("simulator: job submit failed: %s",
+		      err_msg ? err_msg : slurm_strerror(rc));
+		job->done = true;
+		jobs_rejected++;
+	}
+	slurm_free_job_desc_msg(job_desc);
+	xfree(err_msg);
+}
+
+/* The batch script of a running job has reached the end of its run time */
+static void _complete_job(sim_job_t *job)
+{
+	/* Locks: Read config, write job, write node, read federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+	int rc;
+
+	_sim_lock(job_write_lock);
+	rc = job_complete(job->job_id, slurmctld_conf.slurm_user_id,
+			  false, false, 0);
+	_sim_unlock(job_write_lock);
+	if (rc != SLURM_SUCCESS) {
+		debug("simulator: job_complete JobId=%u: %s",
+		      job->job_id, slurm_strerror(rc));
+	}
+	job->done = true;
+	jobs_completed++;
+}
+
+/* Send an epilog complete from each node a job was terminated on */
+static void _epilog_complete(sim_event_t *event)
+{
+	/* Locks: Read configuration, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+	hostlist_t hl = hostlist_create(event->nodes);
+	bool run_scheduler = false, requeued = false;
+	struct job_record *job_ptr;
+	sim_job_t *job;
+	char *node_name;
+
+	_sim_lock(job_write_lock);
+	while ((node_name = hostlist_shift(hl))) {
+		if (job_epilog_complete(event->job_id, node_name, 0))
+			run_scheduler = true;
+		free(node_name);
+	}
+	if ((job_ptr = find_job_record(event->job_id)) &&
+	    IS_JOB_PENDING(job_ptr))
+		requeued = true;
+	_sim_unlock(job_write_lock);
+	hostlist_destroy(hl);
+
+	job = _find_job(event->job_id);
+	if (job && !job->done && requeued) {
+		/* Launch it again with its full run time */
+		if (job->started) {
+			_heap_remove(job);
+			job->started = false;
+		}
+	} else if (job && !job->done) {
+		/* The job was killed before the end of its run time */
+		job->done = true;
+		jobs_killed++;
+	}
+	if (run_scheduler)
+		queue_job_scheduler();
+}
+
+static void _node_did_resp(sim_event_t *event)
+{
+	/* Locks: Write node */
+	slurmctld_lock_t node_write_lock = {
+		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+	hostlist_t hl = hostlist_create(event->nodes);
+	char *node_name;
+
+	_sim_lock(node_write_lock);
+	while ((node_name = hostlist_shift(hl))) {
+		node_did_resp(node_name);
+		free(node_name);
+	}
+	_sim_unlock(node_write_lock);
+	hostlist_destroy(hl);
+}
+
+/* Reply to the RPCs queued by sim_agent_request() */
+static void _process_events(int64_t now_usec)
+{
+	/* Locks: Write job */
+	slurmctld_lock_t job_write_lock = {
+		NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+	sim_event_t *event;
+	sim_job_t *job;
+	List events;
+
+	slurm_mutex_lock(&sim_mutex);
+	events = sim_events;
+	sim_events = list_create(_event_del);
+	slurm_mutex_unlock(&sim_mutex);
+
+	while ((event = list_dequeue(events))) {
+		switch (event->msg_type) {
+		case REQUEST_BATCH_JOB_LAUNCH:
+			job = _find_job(event->job_id);
+			if (!job || job->started)
+				break;
+			job->started = true;
+			job->end_usec = now_usec + job->run_usec;
+			_heap_push(job);
+			last_start_usec = now_usec;
+			jobs_started++;
+			break;
+		case REQUEST_LAUNCH_PROLOG:
+			_sim_lock(job_write_lock);
+			(void) prolog_complete(event->job_id, 0);
+			_sim_unlock(job_write_lock);
+			break;
+		case REQUEST_TERMINATE_JOB:
+		case REQUEST_KILL_PREEMPTED:
+		case REQUEST_KILL_TIMELIMIT:
+			_epilog_complete(event);
+			break;
+		default:
+			_node_did_resp(event);
+			break;
+		}
+		_event_del(event);
+	}
+	FREE_NULL_LIST(events);
+}
+
+static void _report(int64_t now_usec)
+{
+	double elapsed = (last_start_usec ? last_start_usec : now_usec) /
+			 1000000.0;
+	diag_stats_t *stats = &slurmctld_diag_stats;
+
+	info("simulator: %u jobs submitted, %u rejected, %u started, "
+	     "%u completed, %u killed in %.1f sec",
+	     jobs_submitted, jobs_rejected, jobs_started, jobs_completed,
+	     jobs_killed, now_usec / 1000000.0);
+	info("simulator: %.1f jobs started per second",
+	     (elapsed > 0.0) ? (jobs_started / elapsed) : 0.0);
+	info("simulator: %u main scheduler cycles, mean %u usec, "
+	     "mean depth %u",
+	     stats->schedule_cycle_counter,
+	     stats->schedule_cycle_counter ?
+	     (stats->schedule_cycle_sum / stats->schedule_cycle_counter) : 0,
+	     stats->schedule_cycle_counter ?
+	     (stats->schedule_cycle_depth / stats->schedule_cycle_counter) : 0);
+	info("simulator: %u backfill cycles, mean %"PRIu64" usec, "
+	     "mean depth %u, %u jobs backfilled",
+	     stats->bf_cycle_counter,
+	     stats->bf_cycle_counter ?
+	     (stats->bf_cycle_sum / stats->bf_cycle_counter) : 0,
+	     stats->bf_cycle_counter ?
+	     (stats->bf_depth_sum / stats->bf_cycle_counter) : 0,
+	     stats->backfilled_jobs);
+	info("simulator: %u locks, wait mean %"PRId64" max %"PRId64" usec, "
+	     "hold mean %"PRId64" max %"PRId64" usec", lock_cnt,
+	     lock_cnt ? (lock_wait_sum / lock_cnt) : 0, lock_wait_max,
+	     lock_cnt ? (lock_hold_sum / lock_cnt) : 0, lock_hold_max);
+}
+
+static void *_sim_agent(void *arg)
+{
+	struct timespec ts;
+	int64_t now_usec = 0, wake_usec;
+	int i, next_submit = 0, done_cnt;
+	bool finished = false;
+
+	_register_nodes();
+	queue_job_scheduler();
+
+	sim_start_usec = _usec_now();
+	while (slurmctld_config.shutdown_time == 0) {
+		now_usec = _usec_now() - sim_start_usec;
+		while ((next_submit < sim_job_cnt) &&
+		       (sim_jobs[next_submit].submit_usec <= now_usec))
+			_submit_job(&sim_jobs[next_submit++]);
+		_process_events(now_usec);
+		while (run_heap_cnt && (run_heap[0]->end_usec <= now_usec)) {
+			sim_job_t *job = _heap_pop();
+			if (!job->done)
+				_complete_job(job);
+		}
+
+		done_cnt = jobs_rejected + jobs_completed + jobs_killed;
+		if ((next_submit >= sim_job_cnt) && (done_cnt >= sim_job_cnt)) {
+			finished = true;
+			break;
+		}
+
+		wake_usec = now_usec + SIM_POLL_USEC;
+		if (next_submit < sim_job_cnt)
+			wake_usec = MIN(wake_usec,
+					sim_jobs[next_submit].submit_usec);
+		if (run_heap_cnt)
+			wake_usec = MIN(wake_usec, run_heap[0]->end_usec);
+		wake_usec += sim_start_usec;
+		ts.tv_sec = wake_usec / 1000000;
+		ts.tv_nsec = (wake_usec % 1000000) * 1000;
+		slurm_mutex_lock(&sim_mutex);
+		if (list_is_empty(sim_events))
+			slurm_cond_timedwait(&sim_cond, &sim_mutex, &ts);
+		slurm_mutex_unlock(&sim_mutex);
+	}
+
+	_report(now_usec);
+
+	slurm_mutex_lock(&sim_mutex);
+	sim_done = true;
+	FREE_NULL_LIST(sim_events);
+	slurm_mutex_unlock(&sim_mutex);
+	for (i = 0; i < sim_job_cnt; i++)
+		xfree(sim_jobs[i].partition);
+	xfree(sim_jobs);
+	xfree(job_hash);
+	xfree(run_heap);
+
+	if (finished && slurmctld_config.thread_id_sig)	/* signal clean-up */
+		pthread_kill(slurmctld_config.thread_id_sig, SIGTERM);
+	return NULL;
+}
+
+/*
+ * start_simulator - Start the simulator thread if a trace file was given.
+ *	The thread registers every node, submits the jobs of the trace, plays
+ *	the part of slurmd for them and shuts slurmctld down once they have
+ *	all completed.
+ * IN thread_id - pointer to thread ID of the started pthread, left zero if
+ *	the simulator is not enabled
+ */
+extern void start_simulator(pthread_t *thread_id)
+{
+	*thread_id = (pthread_t) 0;
+	if (!sim_trace_file)
+		return;
+	if (_read_trace() != SLURM_SUCCESS)
+		fatal("simulator: unable to read workload trace");
+
+	slurm_mutex_lock(&sim_mutex);
+	if (!sim_events)
+		sim_events = list_create(_event_del);
+	slurm_mutex_unlock(&sim_mutex);
+
+	slurm_thread_create(thread_id, _sim_agent, NULL);
+}
+
+/*
+ * sim_agent_request - Consume an RPC to be sent to the compute nodes,
+ *	replying to it as slurmd would once the simulated job time has passed.
+ * IN agent_arg_ptr - the request, left for the caller to free
+ * RET true if the simulator is enabled and consumed the request
+ * NOTE: Called with slurmctld locks held, all replies are asynchronous
+ */
+extern bool sim_agent_request(agent_arg_t *agent_arg_ptr)
+{
+	sim_event_t *event;
+
+	if (!sim_trace_file)
+		return false;
+
+	/* Messages to srun and to the slurmd daemons themselves are dropped */
+	if (agent_arg_ptr->addr || !agent_arg_ptr->hostlist ||
+	    (agent_arg_ptr->msg_type == REQUEST_SHUTDOWN) ||
+	    (agent_arg_ptr->msg_type == REQUEST_RECONFIGURE))
+		return true;
+
+	event = xmalloc(sizeof(sim_event_t));
+	event->msg_type = agent_arg_ptr->msg_type;
+	event->nodes = hostlist_ranged_string_xmalloc(agent_arg_ptr->hostlist);
+	switch (agent_arg_ptr->msg_type) {
+	case REQUEST_BATCH_JOB_LAUNCH:
+		event->job_id = ((batch_job_launch_msg_t *)
+				 agent_arg_ptr->msg_args)->job_id;
+		break;
+	case REQUEST_LAUNCH_PROLOG:
+		event->job_id = ((prolog_launch_msg_t *)
+				 agent_arg_ptr->msg_args)->job_id;
+		break;
+	case REQUEST_TERMINATE_JOB:
+	case REQUEST_KILL_PREEMPTED:
+	case REQUEST_KILL_TIMELIMIT:
+		event->job_id = ((kill_job_msg_t *)
+				 agent_arg_ptr->msg_args)->job_id;
+		break;
+	default:
+		break;
+	}
+
+	slurm_mutex_lock(&sim_mutex);
+	if (sim_events && !sim_done) {
+		list_enqueue(sim_events, event);
+		event = NULL;
+		slurm_cond_signal(&sim_cond);
+	}
+	slurm_mutex_unlock(&sim_mutex);
+	if (event)
+		_event_del(event);
+
+	return true;
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************\
+ *  simulator.h - drive slurmctld with a workload trace and virtual nodes
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_SIMULATOR_H
+#define _HAVE_SIMULATOR_H
+
+#include "src/slurmctld/agent.h"
+
+/* Workload trace file, set by the slurmctld -S option */
+extern char *sim_trace_file;
+
+/*
+ * start_simulator - Start the simulator thread if a trace file was given.
+ *	The thread registers every node, submits the jobs of the trace, plays
+ *	the part of slurmd for them and shuts slurmctld down once they have
+ *	all completed.
+ * IN thread_id - pointer to thread ID of the started pthread, left zero if
+ *	the simulator is not enabled
+ */
+extern void start_simulator(pthread_t *thread_id);
+
+/*
+ * sim_agent_request - Consume an RPC to be sent to the compute nodes,
+ *	replying to it as slurmd would once the simulated job time has passed.
+ * IN agent_arg_ptr - the request, left for the caller to free
+ * RET true if the simulator is enabled and consumed the request
+ * NOTE: Called with slurmctld locks held, all replies are asynchronous
+ */
+extern bool sim_agent_request(agent_arg_t *agent_arg_ptr);
+
+#endif /* _HAVE_SIMULATOR_H */
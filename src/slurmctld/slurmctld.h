@@ -150,6 +150,7 @@ typedef struct slurmctld_config {
 	pthread_t thread_id_power;
 	pthread_t thread_id_purge_files;
 	pthread_t thread_id_rpc;
+	pthread_t thread_id_sim;
 } slurmctld_config_t;
 
 /* Job scheduling statistics */
@@ -185,6 +186,11 @@ typedef struct diag_stats {
 	uint32_t bf_queue_len_sum;
 	time_t   bf_when_last_cycle;
 	uint32_t bf_active;
+
+	uint32_t node_set_cache_hits;
+	uint32_t node_set_cache_misses;
+	uint32_t schedule_class_skip;
+	uint32_t bf_class_skip;
 } diag_stats_t;
 
 /* This is used to point out constants that exist in the
@@ -745,6 +751,9 @@ struct job_record {
 	uint32_t *priority_array;	/* partition based priority */
 	priority_factors_object_t *prio_factors; /* cached value used
 						  * by sprio command */
+	uint32_t prio_sig;		/* signature of the inputs of
+					 * prio_factors, internal use only,
+					 * DON'T PACK */
 	uint32_t profile;		/* Acct_gather_profile option */
 	uint32_t qos_id;		/* quality of service id */
 	slurmdb_qos_rec_t *qos_ptr;	/* pointer to the quality of
@@ -1899,6 +1908,10 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version);
 
+/* Append the scheduling statistics which follow the RPC statistics */
+extern void pack_all_stat_ext(int resp, char **buffer_ptr, int *buffer_size,
+			      uint16_t protocol_version);
+
 /*
  * pack_ctld_job_step_info_response_msg - packs job step info
  * IN job_id - specific id or NO_VAL for all
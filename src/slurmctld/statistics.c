@@ -182,6 +182,30 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
+/*
+ * Append the scheduling statistics added within 17.11. These follow the RPC
+ * statistics so that older 17.11 clients can ignore them.
+ */
+extern void pack_all_stat_ext(int resp, char **buffer_ptr, int *buffer_size,
+			      uint16_t protocol_version)
+{
+	Buf buffer;
+
+	if (!resp || (protocol_version < SLURM_17_11_PROTOCOL_VERSION))
+		return;
+
+	buffer = create_buf(*buffer_ptr, *buffer_size);
+	set_buf_offset(buffer, *buffer_size);
+
+	pack32(slurmctld_diag_stats.node_set_cache_hits, buffer);
+	pack32(slurmctld_diag_stats.node_set_cache_misses, buffer);
+	pack32(slurmctld_diag_stats.schedule_class_skip, buffer);
+	pack32(slurmctld_diag_stats.bf_class_skip, buffer);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /* Reset all scheduling statistics
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level)
@@ -215,6 +239,10 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
+	slurmctld_diag_stats.node_set_cache_hits = 0;
+	slurmctld_diag_stats.node_set_cache_misses = 0;
+	slurmctld_diag_stats.schedule_class_skip = 0;
+	slurmctld_diag_stats.bf_class_skip = 0;
 
 	last_proc_req_start = time(NULL);
 }
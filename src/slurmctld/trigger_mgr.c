@@ -78,8 +78,6 @@ bitstr_t *trigger_drained_nodes_bitmap = NULL;
 bitstr_t *trigger_fail_nodes_bitmap = NULL;
 bitstr_t *trigger_up_nodes_bitmap   = NULL;
 static bool trigger_bb_error = false;
-static bool trigger_block_err = false;
-static bool trigger_node_reconfig = false;
 static bool trigger_pri_ctld_fail = false;
 static bool trigger_pri_ctld_res_op = false;
 static bool trigger_pri_ctld_res_ctrl = false;
@@ -92,6 +90,18 @@ static bool trigger_pri_dbd_res_op = false;
 static bool trigger_pri_db_fail = false;
 static bool trigger_pri_db_res_op = false;
 
+/* TRIGGER_TYPE_* events published since the last trigger_process() */
+static uint32_t trigger_node_events = 0;
+static uint32_t trigger_front_end_events = 0;
+
+/* Built once per trigger_process() and shared by all subscribed triggers */
+static char *trigger_down_nodes_names = NULL;
+static char *trigger_drained_nodes_names = NULL;
+static char *trigger_fail_nodes_names = NULL;
+static char *trigger_up_nodes_names = NULL;
+static bitstr_t *trigger_idle_nodes_bitmap = NULL;
+static time_t trigger_idle_min = 0;
+
 /* Current trigger pull states (saved and restored) */
 uint8_t ctld_failure = 0;
 uint8_t bu_ctld_failure = 0;
@@ -510,6 +520,7 @@ extern void trigger_front_end_down(front_end_record_t *front_end_ptr)
 	if (trigger_down_front_end_bitmap == NULL)
 		trigger_down_front_end_bitmap = bit_alloc(front_end_node_cnt);
 	bit_set(trigger_down_front_end_bitmap, inx);
+	trigger_front_end_events |= TRIGGER_TYPE_DOWN;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
@@ -521,6 +532,7 @@ extern void trigger_front_end_up(front_end_record_t *front_end_ptr)
 	if (trigger_up_front_end_bitmap == NULL)
 		trigger_up_front_end_bitmap = bit_alloc(front_end_node_cnt);
 	bit_set(trigger_up_front_end_bitmap, inx);
+	trigger_front_end_events |= TRIGGER_TYPE_UP;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
@@ -532,6 +544,7 @@ extern void trigger_node_down(struct node_record *node_ptr)
 	if (trigger_down_nodes_bitmap == NULL)
 		trigger_down_nodes_bitmap = bit_alloc(node_record_count);
 	bit_set(trigger_down_nodes_bitmap, inx);
+	trigger_node_events |= TRIGGER_TYPE_DOWN;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
@@ -543,6 +556,7 @@ extern void trigger_node_drained(struct node_record *node_ptr)
 	if (trigger_drained_nodes_bitmap == NULL)
 		trigger_drained_nodes_bitmap = bit_alloc(node_record_count);
 	bit_set(trigger_drained_nodes_bitmap, inx);
+	trigger_node_events |= TRIGGER_TYPE_DRAINED;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
@@ -554,6 +568,7 @@ extern void trigger_node_failing(struct node_record *node_ptr)
 	if (trigger_fail_nodes_bitmap == NULL)
 		trigger_fail_nodes_bitmap = bit_alloc(node_record_count);
 	bit_set(trigger_fail_nodes_bitmap, inx);
+	trigger_node_events |= TRIGGER_TYPE_FAIL;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
@@ -566,13 +581,14 @@ extern void trigger_node_up(struct node_record *node_ptr)
 	if (trigger_up_nodes_bitmap == NULL)
 		trigger_up_nodes_bitmap = bit_alloc(node_record_count);
 	bit_set(trigger_up_nodes_bitmap, inx);
+	trigger_node_events |= TRIGGER_TYPE_UP;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
 extern void trigger_reconfig(void)
 {
 	slurm_mutex_lock(&trigger_mutex);
-	trigger_node_reconfig = true;
+	trigger_node_events |= TRIGGER_TYPE_RECONFIG;
 	if (trigger_down_front_end_bitmap)
 		trigger_down_front_end_bitmap = bit_realloc(
 			trigger_down_front_end_bitmap, node_record_count);
@@ -689,7 +705,7 @@ extern void trigger_primary_db_res_op(void)
 extern void trigger_block_error(void)
 {
 	slurm_mutex_lock(&trigger_mutex);
-	trigger_block_err = true;
+	trigger_node_events |= TRIGGER_TYPE_BLOCK_ERR;
 	slurm_mutex_unlock(&trigger_mutex);
 }
 
@@ -1058,7 +1074,7 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_DOWN) {
+	if (trig_in->trig_type & trigger_front_end_events & TRIGGER_TYPE_DOWN) {
 		if (_front_end_job_test(trigger_down_front_end_bitmap,
 					trig_in->job_ptr)) {
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_TRIGGERS) {
@@ -1072,9 +1088,8 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_DOWN) {
-		if (trigger_down_nodes_bitmap &&
-		    bit_overlap(trig_in->job_ptr->node_bitmap,
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_DOWN) {
+		if (bit_overlap(trig_in->job_ptr->node_bitmap,
 				trigger_down_nodes_bitmap)) {
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_TRIGGERS) {
 				info("trigger[%u] for job %u down",
@@ -1087,9 +1102,8 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_FAIL) {
-		if (trigger_fail_nodes_bitmap &&
-		    bit_overlap(trig_in->job_ptr->node_bitmap,
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_FAIL) {
+		if (bit_overlap(trig_in->job_ptr->node_bitmap,
 				trigger_fail_nodes_bitmap)) {
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_TRIGGERS) {
 				info("trigger[%u] for job %u node fail",
@@ -1102,9 +1116,8 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_UP) {
-		if (trigger_up_nodes_bitmap &&
-		    bit_overlap(trig_in->job_ptr->node_bitmap,
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_UP) {
+		if (bit_overlap(trig_in->job_ptr->node_bitmap,
 				trigger_up_nodes_bitmap)) {
 			trig_in->state = 1;
 			trig_in->trig_time = now +
@@ -1123,9 +1136,7 @@ static void _trigger_front_end_event(trig_mgr_info_t *trig_in, time_t now)
 {
 	int i;
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_DOWN) &&
-	    (trigger_down_front_end_bitmap != NULL) &&
-	    ((i = bit_ffs(trigger_down_front_end_bitmap)) != -1)) {
+	if (trig_in->trig_type & trigger_front_end_events & TRIGGER_TYPE_DOWN) {
 		xfree(trig_in->res_id);
 		for (i = 0; i < front_end_node_cnt; i++) {
 			if (!bit_test(trigger_down_front_end_bitmap, i))
@@ -1143,9 +1154,7 @@ static void _trigger_front_end_event(trig_mgr_info_t *trig_in, time_t now)
 		return;
 	}
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_UP) &&
-	    (trigger_up_front_end_bitmap != NULL) &&
-	    ((i = bit_ffs(trigger_up_front_end_bitmap)) != -1)) {
+	if (trig_in->trig_type & trigger_front_end_events & TRIGGER_TYPE_UP) {
 		xfree(trig_in->res_id);
 		for (i = 0; i < front_end_node_cnt; i++) {
 			if (!bit_test(trigger_up_front_end_bitmap, i))
@@ -1176,10 +1185,42 @@ static void _trigger_other_event(trig_mgr_info_t *trig_in, time_t now)
 	}
 }
 
+/* Return the names of the nodes in an event bitmap, built only once for all
+ * of the triggers of the pass. Value must be xfreed. */
+static char *_event_node_names(bitstr_t *event_bitmap, char **names)
+{
+	if (*names == NULL)
+		*names = bitmap2node_name(event_bitmap);
+	return xstrdup(*names);
+}
+
+/* Return a bitmap of nodes idle since min_idle. Triggers usually share the
+ * same offset, so keep the last one built for the rest of the pass. */
+static bitstr_t *_idle_nodes(time_t min_idle)
+{
+	struct node_record *node_ptr = node_record_table_ptr;
+	int i;
+
+	if (trigger_idle_nodes_bitmap && (trigger_idle_min == min_idle))
+		return trigger_idle_nodes_bitmap;
+
+	if (trigger_idle_nodes_bitmap)
+		bit_nclear(trigger_idle_nodes_bitmap, 0, node_record_count - 1);
+	else
+		trigger_idle_nodes_bitmap = bit_alloc(node_record_count);
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		if (!IS_NODE_IDLE(node_ptr) ||
+		    (node_ptr->last_idle > min_idle))
+			continue;
+		bit_set(trigger_idle_nodes_bitmap, i);
+	}
+	trigger_idle_min = min_idle;
+	return trigger_idle_nodes_bitmap;
+}
+
 static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 {
-	if ((trig_in->trig_type & TRIGGER_TYPE_BLOCK_ERR) &&
-	    trigger_block_err) {
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_BLOCK_ERR) {
 		trig_in->state = 1;
 		trig_in->trig_time = now + (trig_in->trig_time - 0x8000);
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_TRIGGERS)
@@ -1187,13 +1228,12 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		return;
 	}
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_DOWN) &&
-	    trigger_down_nodes_bitmap                &&
-	    (bit_ffs(trigger_down_nodes_bitmap) != -1)) {
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_DOWN) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
-			trig_in->res_id = bitmap2node_name(
-					  trigger_down_nodes_bitmap);
+			trig_in->res_id = _event_node_names(
+					trigger_down_nodes_bitmap,
+					&trigger_down_nodes_names);
 			trig_in->state = 1;
 		} else if (bit_overlap(trig_in->nodes_bitmap,
 				       trigger_down_nodes_bitmap)) {
@@ -1215,13 +1255,12 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_DRAINED) &&
-	    trigger_drained_nodes_bitmap                &&
-	    (bit_ffs(trigger_drained_nodes_bitmap) != -1)) {
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_DRAINED) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
-			trig_in->res_id = bitmap2node_name(
-					  trigger_drained_nodes_bitmap);
+			trig_in->res_id = _event_node_names(
+					trigger_drained_nodes_bitmap,
+					&trigger_drained_nodes_names);
 			trig_in->state = 1;
 		} else if (bit_overlap(trig_in->nodes_bitmap,
 				       trigger_drained_nodes_bitmap)) {
@@ -1243,13 +1282,12 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_FAIL) &&
-	    trigger_fail_nodes_bitmap                &&
-	    (bit_ffs(trigger_fail_nodes_bitmap) != -1)) {
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_FAIL) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
-			trig_in->res_id = bitmap2node_name(
-					  trigger_fail_nodes_bitmap);
+			trig_in->res_id = _event_node_names(
+					trigger_fail_nodes_bitmap,
+					&trigger_fail_nodes_names);
 			trig_in->state = 1;
 		} else if (bit_overlap(trig_in->nodes_bitmap,
 				       trigger_fail_nodes_bitmap)) {
@@ -1275,17 +1313,8 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		/* We need to determine which (if any) of these
 		 * nodes have been idle for at least the offset time */
 		time_t min_idle = now - (trig_in->trig_time - 0x8000);
-		int i;
-		struct node_record *node_ptr = node_record_table_ptr;
-		bitstr_t *trigger_idle_node_bitmap;
+		bitstr_t *trigger_idle_node_bitmap = _idle_nodes(min_idle);
 
-		trigger_idle_node_bitmap = bit_alloc(node_record_count);
-		for (i = 0; i < node_record_count; i++, node_ptr++) {
-			if (!IS_NODE_IDLE(node_ptr) ||
-			    (node_ptr->last_idle > min_idle))
-				continue;
-			bit_set(trigger_idle_node_bitmap, i);
-		}
 		if (trig_in->nodes_bitmap == NULL) {    /* all nodes */
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
@@ -1300,7 +1329,6 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 					  trig_in->nodes_bitmap);
 			trig_in->state = 1;
 		}
-		FREE_NULL_BITMAP(trigger_idle_node_bitmap);
 		if (trig_in->state == 1) {
 			trig_in->trig_time = now;
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_TRIGGERS) {
@@ -1311,13 +1339,12 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_UP) &&
-	    trigger_up_nodes_bitmap                &&
-	    (bit_ffs(trigger_up_nodes_bitmap) != -1)) {
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_UP) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
-			trig_in->res_id = bitmap2node_name(
-					  trigger_up_nodes_bitmap);
+			trig_in->res_id = _event_node_names(
+					trigger_up_nodes_bitmap,
+					&trigger_up_nodes_names);
 			trig_in->state = 1;
 		} else if (bit_overlap(trig_in->nodes_bitmap,
 				       trigger_up_nodes_bitmap)) {
@@ -1339,8 +1366,7 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if ((trig_in->trig_type & TRIGGER_TYPE_RECONFIG) &&
-	    trigger_node_reconfig) {
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_RECONFIG) {
 		trig_in->state = 1;
 		trig_in->trig_time = now + (trig_in->trig_time - 0x8000);
 		xfree(trig_in->res_id);
@@ -1591,13 +1617,22 @@ static void _clear_event_triggers(void)
 		bit_nclear(trigger_drained_nodes_bitmap,
 			   0, (bit_size(trigger_drained_nodes_bitmap) - 1));
 	}
+	if (trigger_fail_nodes_bitmap) {
+		bit_nclear(trigger_fail_nodes_bitmap,
+			   0, (bit_size(trigger_fail_nodes_bitmap) - 1));
+	}
 	if (trigger_up_nodes_bitmap) {
 		bit_nclear(trigger_up_nodes_bitmap,
 			   0, (bit_size(trigger_up_nodes_bitmap) - 1));
 	}
-	trigger_node_reconfig = false;
+	trigger_node_events = 0;
+	trigger_front_end_events = 0;
+	xfree(trigger_down_nodes_names);
+	xfree(trigger_drained_nodes_names);
+	xfree(trigger_fail_nodes_names);
+	xfree(trigger_up_nodes_names);
+	FREE_NULL_BITMAP(trigger_idle_nodes_bitmap);
 	trigger_bb_error = false;
-	trigger_block_err = false;
 	trigger_pri_ctld_fail = false;
 	trigger_pri_ctld_res_op = false;
 	trigger_pri_ctld_res_ctrl = false;
@@ -1611,6 +1646,19 @@ static void _clear_event_triggers(void)
 	trigger_pri_db_res_op = false;
 }
 
+/* Test if a pending trigger subscribes to any event published since the last
+ * pass. Only idle node triggers and job triggers, which must notice their
+ * job ending or reaching its time limit, are polled every pass. */
+static bool _trigger_subscribed(trig_mgr_info_t *trig_in)
+{
+	if (trig_in->res_type == TRIGGER_RES_TYPE_NODE)
+		return (trig_in->trig_type &
+			(trigger_node_events | TRIGGER_TYPE_IDLE));
+	if (trig_in->res_type == TRIGGER_RES_TYPE_FRONT_END)
+		return (trig_in->trig_type & trigger_front_end_events);
+	return true;
+}
+
 /* Make a copy of a trigger and pre-pend it on our list */
 static void _trigger_clone(trig_mgr_info_t *trig_in)
 {
@@ -1654,7 +1702,7 @@ extern void trigger_process(void)
 
 	trig_iter = list_iterator_create(trigger_list);
 	while ((trig_in = list_next(trig_iter))) {
-		if (trig_in->state == 0) {
+		if ((trig_in->state == 0) && _trigger_subscribed(trig_in)) {
 			if (trig_in->res_type == TRIGGER_RES_TYPE_OTHER)
 				_trigger_other_event(trig_in, now);
 			else if (trig_in->res_type == TRIGGER_RES_TYPE_JOB)
@@ -1754,4 +1802,9 @@ extern void trigger_fini(void)
 	FREE_NULL_BITMAP(trigger_drained_nodes_bitmap);
 	FREE_NULL_BITMAP(trigger_fail_nodes_bitmap);
 	FREE_NULL_BITMAP(trigger_up_nodes_bitmap);
+	FREE_NULL_BITMAP(trigger_idle_nodes_bitmap);
+	xfree(trigger_down_nodes_names);
+	xfree(trigger_drained_nodes_names);
+	xfree(trigger_fail_nodes_names);
+	xfree(trigger_up_nodes_names);
 }
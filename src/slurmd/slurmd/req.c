@@ -87,6 +87,7 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
 #include "src/common/stepd_api.h"
+#include "src/common/timers.h"
 #include "src/common/uid.h"
 #include "src/common/util-net.h"
 #include "src/common/xstring.h"
@@ -270,6 +271,22 @@ static pthread_mutex_t prolog_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t prolog_serial_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define FILE_BCAST_TIMEOUT 300
+/* Pool of idle slurmstepd, LaunchParameters=stepd_pool=# */
+#define STEPD_POOL_MAX 64
+typedef struct {
+	int to_stepd;		/* write end of the slurmstepd's stdin */
+	int to_slurmd;		/* read end of the slurmstepd's stdout */
+} stepd_pool_ent_t;
+static pthread_mutex_t stepd_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  stepd_pool_cond  = PTHREAD_COND_INITIALIZER;
+static stepd_pool_ent_t stepd_pool[STEPD_POOL_MAX];
+static int stepd_pool_idle = 0, stepd_pool_size = 0;
+static uint32_t stepd_pool_gen = 0;
+static bool stepd_pool_shutdown = false;
+static pthread_t stepd_pool_thread = 0;
+static uint32_t launch_hist_pooled[SLURMD_LAUNCH_HIST_CNT];
+static uint32_t launch_hist_forked[SLURMD_LAUNCH_HIST_CNT];
+
 static pthread_mutex_t file_bcast_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  file_bcast_cond  = PTHREAD_COND_INITIALIZER;
 static int fb_read_lock = 0, fb_write_wait_lock = 0, fb_write_lock = 0;
@@ -648,261 +665,466 @@ rwfail:
 
 
 /*
- * Fork and exec the slurmstepd, then send the slurmstepd its
- * initialization data.  Then wait for slurmstepd to send an "ok"
- * message before returning.  When the "ok" message is received,
- * the slurmstepd has created and begun listening on its unix
- * domain socket.
+ * Exec the slurmstepd in a new session, with to_stepd and to_slurmd as its
+ * stdin and stdout. Called in the child of fork(), never returns.
  *
  * Note that this code forks twice and it is the grandchild that
  * becomes the slurmstepd process, so the slurmstepd's parent process
  * will be init, not slurmd.
  */
-static int
-_forkexec_slurmstepd(uint16_t type, void *req,
-		     slurm_addr_t *cli, slurm_addr_t *self,
-		     const hostset_t step_hset, uint16_t protocol_version)
+static void
+_exec_slurmstepd(uint16_t type, void *req, int to_stepd[2], int to_slurmd[2])
 {
+#if (SLURMSTEPD_MEMCHECK == 1)
+	/* memcheck test of slurmstepd, option #1 */
+	char *const argv[3] = {"memcheck",
+			       (char *)conf->stepd_loc, NULL};
+#elif (SLURMSTEPD_MEMCHECK == 2)
+	/* valgrind test of slurmstepd, option #2 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[13] = {"valgrind", "--tool=memcheck",
+				"--error-limit=no",
+				"--leak-check=summary",
+				"--show-reachable=yes",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				"--track-origins=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (req && (type == LAUNCH_BATCH_JOB)) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#elif (SLURMSTEPD_MEMCHECK == 3)
+	/* valgrind/drd test of slurmstepd, option #3 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[10] = {"valgrind", "--tool=drd",
+				"--error-limit=no",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (req && (type == LAUNCH_BATCH_JOB)) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#elif (SLURMSTEPD_MEMCHECK == 4)
+	/* valgrind/helgrind test of slurmstepd, option #4 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[10] = {"valgrind", "--tool=helgrind",
+				"--error-limit=no",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (req && (type == LAUNCH_BATCH_JOB)) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#else
+	/* no memory checking, default */
+	char *const argv[2] = { (char *)conf->stepd_loc, NULL};
+#endif
 	pid_t pid;
-	int to_stepd[2] = {-1, -1};
-	int to_slurmd[2] = {-1, -1};
+	int i;
+	int failed = 0;
+	/* inform slurmstepd about our config */
+	setenv("SLURM_CONF", conf->conffile, 1);
 
-	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
-		error("_forkexec_slurmstepd pipe failed: %m");
-		return SLURM_FAILURE;
+	/*
+	 * Child forks and exits
+	 */
+	if (setsid() < 0) {
+		error("%s: setsid: %m", __func__);
+		failed = 1;
+	}
+	if ((pid = fork()) < 0) {
+		error("%s: Unable to fork grandchild: %m", __func__);
+		failed = 2;
+	} else if (pid > 0) { /* child */
+		exit(0);
 	}
 
-	if (_add_starting_step(type, req)) {
-		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
-		return SLURM_FAILURE;
+	/*
+	 * Just in case we (or someone we are linking to)
+	 * opened a file and didn't do a close on exec.  This
+	 * is needed mostly to protect us against libs we link
+	 * to that don't set the flag as we should already be
+	 * setting it for those that we open.  The number 256
+	 * is an arbitrary number based off test7.9.
+	 */
+	for (i=3; i<256; i++) {
+		(void) fcntl(i, F_SETFD, FD_CLOEXEC);
 	}
 
-	if ((pid = fork()) < 0) {
-		error("_forkexec_slurmstepd: fork: %m");
-		close(to_stepd[0]);
-		close(to_stepd[1]);
-		close(to_slurmd[0]);
-		close(to_slurmd[1]);
-		_remove_starting_step(type, req);
-		return SLURM_FAILURE;
-	} else if (pid > 0) {
-		int rc = SLURM_SUCCESS;
-#if (SLURMSTEPD_MEMCHECK == 0)
-		int i;
-		time_t start_time = time(NULL);
-#endif
-		/*
-		 * Parent sends initialization data to the slurmstepd
-		 * over the to_stepd pipe, and waits for the return code
-		 * reply on the to_slurmd pipe.
-		 */
-		if (close(to_stepd[0]) < 0)
-			error("Unable to close read to_stepd in parent: %m");
-		if (close(to_slurmd[1]) < 0)
-			error("Unable to close write to_slurmd in parent: %m");
-
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset,
-						protocol_version)) != 0) {
-			error("Unable to init slurmstepd");
-			goto done;
+	/*
+	 * Grandchild exec's the slurmstepd
+	 *
+	 * If the slurmd is being shutdown/restarted before
+	 * the pipe happens the old conf->lfd could be reused
+	 * and if we close it the dup2 below will fail.
+	 */
+	if ((to_stepd[0] != conf->lfd)
+	    && (to_slurmd[1] != conf->lfd))
+		slurm_shutdown_msg_engine(conf->lfd);
+
+	if (close(to_stepd[1]) < 0)
+		error("close write to_stepd in grandchild: %m");
+	if (close(to_slurmd[0]) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	(void) close(STDIN_FILENO); /* ignore return */
+	if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
+		error("dup2 over STDIN_FILENO: %m");
+		exit(1);
+	}
+	fd_set_close_on_exec(to_stepd[0]);
+	(void) close(STDOUT_FILENO); /* ignore return */
+	if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
+		error("dup2 over STDOUT_FILENO: %m");
+		exit(1);
+	}
+	fd_set_close_on_exec(to_slurmd[1]);
+	(void) close(STDERR_FILENO); /* ignore return */
+	if (dup2(devnull, STDERR_FILENO) == -1) {
+		error("dup2 /dev/null to STDERR_FILENO: %m");
+		exit(1);
+	}
+	fd_set_noclose_on_exec(STDERR_FILENO);
+	log_fini();
+	if (!failed) {
+		if (conf->chos_loc && !access(conf->chos_loc, X_OK))
+			execvp(conf->chos_loc, argv);
+		else
+			execvp(argv[0], argv);
+		error("exec of slurmstepd failed: %m");
+	}
+	exit(2);
+}
+
+/*
+ * Fork a slurmstepd that waits for its initialization data on the pipe
+ * returned in to_stepd and answers on to_slurmd. type and req are only
+ * used to name memcheck log files and can be 0 and NULL.
+ * RET pid of the intermediate child to reap, or -1 on error
+ */
+static pid_t
+_fork_slurmstepd(uint16_t type, void *req, int *to_stepd, int *to_slurmd)
+{
+	pid_t pid;
+	int stepd_in[2] = {-1, -1};
+	int stepd_out[2] = {-1, -1};
+
+	if ((pipe(stepd_in) < 0) || (pipe(stepd_out) < 0)) {
+		error("%s: pipe failed: %m", __func__);
+		if (stepd_in[0] >= 0) {
+			close(stepd_in[0]);
+			close(stepd_in[1]);
 		}
+		return -1;
+	}
 
-		/* If running under valgrind/memcheck, this pipe doesn't work
-		 * correctly so just skip it. */
-#if (SLURMSTEPD_MEMCHECK == 0)
-		i = read(to_slurmd[0], &rc, sizeof(int));
-		if (i < 0) {
-			error("%s: Can not read return code from slurmstepd "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_FAILURE;
-		} else if (i != sizeof(int)) {
-			error("%s: slurmstepd failed to send return code "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_FAILURE;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			int cc;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-			if (rc != SLURM_SUCCESS)
-				error("slurmstepd return code %d", rc);
-
-			cc = SLURM_SUCCESS;
-			cc = write(to_stepd[1], &cc, sizeof(int));
-			if (cc != sizeof(int)) {
-				error("%s: failed to send ack to stepd %d: %m",
-				      __func__, cc);
-			}
+	if ((pid = fork()) < 0) {
+		error("%s: fork: %m", __func__);
+		close(stepd_in[0]);
+		close(stepd_in[1]);
+		close(stepd_out[0]);
+		close(stepd_out[1]);
+		return -1;
+	} else if (pid == 0) {
+		_exec_slurmstepd(type, req, stepd_in, stepd_out);
+	}
+
+	/*
+	 * Parent sends initialization data to the slurmstepd
+	 * over the to_stepd pipe, and waits for the return code
+	 * reply on the to_slurmd pipe.
+	 */
+	if (close(stepd_in[0]) < 0)
+		error("Unable to close read to_stepd in parent: %m");
+	if (close(stepd_out[1]) < 0)
+		error("Unable to close write to_slurmd in parent: %m");
+	/* Other slurmstepd must not hold these, or EOF is never seen */
+	fd_set_close_on_exec(stepd_in[1]);
+	fd_set_close_on_exec(stepd_out[0]);
+	*to_stepd = stepd_in[1];
+	*to_slurmd = stepd_out[0];
+	return pid;
+}
+
+/* Purge idle slurmstepd, stepd_pool_mutex must be locked */
+static void _stepd_pool_purge(void)
+{
+	/* The slurmstepd see EOF on stdin and exit */
+	while (stepd_pool_idle > 0) {
+		stepd_pool_idle--;
+		close(stepd_pool[stepd_pool_idle].to_stepd);
+		close(stepd_pool[stepd_pool_idle].to_slurmd);
+	}
+	stepd_pool_gen++;
+}
+
+/* Keep stepd_pool_size idle slurmstepd processes ready */
+static void *_stepd_pool_agent(void *arg)
+{
+	stepd_pool_ent_t ent;
+	struct timespec ts = {0, 0};
+	uint32_t gen;
+	pid_t pid;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (!stepd_pool_shutdown) {
+		if (stepd_pool_idle >= stepd_pool_size) {
+			slurm_cond_wait(&stepd_pool_cond, &stepd_pool_mutex);
+			continue;
 		}
-#endif
-	done:
-		if (_remove_starting_step(type, req))
-			error("Error cleaning up starting_step list");
+		gen = stepd_pool_gen;
+		slurm_mutex_unlock(&stepd_pool_mutex);
 
-		/* Reap child */
-		if (waitpid(pid, NULL, 0) < 0)
+		pid = _fork_slurmstepd(0, NULL, &ent.to_stepd, &ent.to_slurmd);
+		if ((pid > 0) && (waitpid(pid, NULL, 0) < 0))
 			error("Unable to reap slurmd child process");
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in parent: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-		return rc;
-	} else {
-#if (SLURMSTEPD_MEMCHECK == 1)
-		/* memcheck test of slurmstepd, option #1 */
-		char *const argv[3] = {"memcheck",
-				       (char *)conf->stepd_loc, NULL};
-#elif (SLURMSTEPD_MEMCHECK == 2)
-		/* valgrind test of slurmstepd, option #2 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[13] = {"valgrind", "--tool=memcheck",
-					"--error-limit=no",
-					"--leak-check=summary",
-					"--show-reachable=yes",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					"--track-origins=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+
+		slurm_mutex_lock(&stepd_pool_mutex);
+		if (pid < 0) {
+			/* Retry later rather than spin on fork failure */
+			ts.tv_sec = time(NULL) + 1;
+			slurm_cond_timedwait(&stepd_pool_cond,
+					     &stepd_pool_mutex, &ts);
+		} else if ((gen != stepd_pool_gen) ||
+			   (stepd_pool_idle >= stepd_pool_size)) {
+			/* Started with a since replaced configuration */
+			close(ent.to_stepd);
+			close(ent.to_slurmd);
+		} else {
+			stepd_pool[stepd_pool_idle++] = ent;
 		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#elif (SLURMSTEPD_MEMCHECK == 3)
-		/* valgrind/drd test of slurmstepd, option #3 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[10] = {"valgrind", "--tool=drd",
-					"--error-limit=no",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return NULL;
+}
+
+/*
+ * Take an idle slurmstepd from the pool
+ * RET true if to_stepd and to_slurmd were set
+ */
+static bool _stepd_pool_get(int *to_stepd, int *to_slurmd)
+{
+	struct pollfd pfd;
+	bool found = false;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (!found && (stepd_pool_idle > 0)) {
+		stepd_pool_idle--;
+		*to_stepd = stepd_pool[stepd_pool_idle].to_stepd;
+		*to_slurmd = stepd_pool[stepd_pool_idle].to_slurmd;
+
+		/* An idle slurmstepd never writes, so any event on its
+		 * stdout means it exited */
+		pfd.fd = *to_slurmd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) == 0) {
+			found = true;
+		} else {
+			debug("%s: idle slurmstepd is gone", __func__);
+			close(*to_stepd);
+			close(*to_slurmd);
 		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#elif (SLURMSTEPD_MEMCHECK == 4)
-		/* valgrind/helgrind test of slurmstepd, option #4 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[10] = {"valgrind", "--tool=helgrind",
-					"--error-limit=no",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	if (stepd_pool_size)
+		slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return found;
+}
+
+/*
+ * (Re)start the pool of idle slurmstepd configured with
+ * LaunchParameters=stepd_pool=#. Idle slurmstepd started with a previous
+ * configuration are replaced.
+ */
+extern void stepd_pool_init(void)
+{
+	char *launch_params, *tmp_ptr;
+	int size = 0;
+
+	launch_params = slurm_get_launch_params();
+	if ((tmp_ptr = xstrcasestr(launch_params, "stepd_pool="))) {
+		size = atoi(tmp_ptr + 11);
+		if ((size < 0) || (size > STEPD_POOL_MAX)) {
+			error("Invalid LaunchParameters stepd_pool=%d, "
+			      "must be between 0 and %d", size,
+			      STEPD_POOL_MAX);
+			size = 0;
 		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#else
-		/* no memory checking, default */
-		char *const argv[2] = { (char *)conf->stepd_loc, NULL};
+	}
+	xfree(launch_params);
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	_stepd_pool_purge();
+	stepd_pool_size = size;
+	if (size && !stepd_pool_thread) {
+		stepd_pool_shutdown = false;
+		slurm_thread_create(&stepd_pool_thread, _stepd_pool_agent,
+				    NULL);
+	}
+	slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (size)
+		debug("%s: keeping %d idle slurmstepd", __func__, size);
+}
+
+/* Terminate all idle slurmstepd of the pool */
+extern void stepd_pool_fini(void)
+{
+	pthread_t thread;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	stepd_pool_shutdown = true;
+	stepd_pool_size = 0;
+	_stepd_pool_purge();
+	slurm_cond_signal(&stepd_pool_cond);
+	thread = stepd_pool_thread;
+	stepd_pool_thread = 0;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (thread)
+		pthread_join(thread, NULL);
+}
+
+/* Add a step launch to the launch latency histograms */
+static void _launch_hist_add(bool pooled, long usec)
+{
+	long msec = usec / 1000;
+	int i;
+
+	for (i = 0; (i < (SLURMD_LAUNCH_HIST_CNT - 1)) && (msec >= (1L << i));
+	     i++)
+		;
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (pooled)
+		launch_hist_pooled[i]++;
+	else
+		launch_hist_forked[i]++;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
+
+/*
+ * Take an idle slurmstepd from the pool or fork and exec a new one, then
+ * send the slurmstepd its initialization data.  Then wait for slurmstepd
+ * to send an "ok" message before returning.  When the "ok" message is
+ * received, the slurmstepd has created and begun listening on its unix
+ * domain socket.
+ */
+static int
+_forkexec_slurmstepd(uint16_t type, void *req,
+		     slurm_addr_t *cli, slurm_addr_t *self,
+		     const hostset_t step_hset, uint16_t protocol_version)
+{
+	pid_t pid = -1;
+	int to_stepd = -1, to_slurmd = -1;
+	int rc = SLURM_SUCCESS;
+	bool pooled;
+#if (SLURMSTEPD_MEMCHECK == 0)
+	int i;
+	time_t start_time = time(NULL);
 #endif
-		int i;
-		int failed = 0;
-		/* inform slurmstepd about our config */
-		setenv("SLURM_CONF", conf->conffile, 1);
+	DEF_TIMERS;
 
-		/*
-		 * Child forks and exits
-		 */
-		if (setsid() < 0) {
-			error("_forkexec_slurmstepd: setsid: %m");
-			failed = 1;
-		}
-		if ((pid = fork()) < 0) {
-			error("_forkexec_slurmstepd: "
-			      "Unable to fork grandchild: %m");
-			failed = 2;
-		} else if (pid > 0) { /* child */
-			exit(0);
-		}
+	START_TIMER;
+	if (_add_starting_step(type, req)) {
+		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
+		return SLURM_FAILURE;
+	}
 
-		/*
-		 * Just in case we (or someone we are linking to)
-		 * opened a file and didn't do a close on exec.  This
-		 * is needed mostly to protect us against libs we link
-		 * to that don't set the flag as we should already be
-		 * setting it for those that we open.  The number 256
-		 * is an arbitrary number based off test7.9.
-		 */
-		for (i=3; i<256; i++) {
-			(void) fcntl(i, F_SETFD, FD_CLOEXEC);
-		}
+	pooled = _stepd_pool_get(&to_stepd, &to_slurmd);
+	if (!pooled &&
+	    ((pid = _fork_slurmstepd(type, req, &to_stepd, &to_slurmd)) < 0)) {
+		_remove_starting_step(type, req);
+		return SLURM_FAILURE;
+	}
 
-		/*
-		 * Grandchild exec's the slurmstepd
-		 *
-		 * If the slurmd is being shutdown/restarted before
-		 * the pipe happens the old conf->lfd could be reused
-		 * and if we close it the dup2 below will fail.
-		 */
-		if ((to_stepd[0] != conf->lfd)
-		    && (to_slurmd[1] != conf->lfd))
-			slurm_shutdown_msg_engine(conf->lfd);
-
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in grandchild: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-
-		(void) close(STDIN_FILENO); /* ignore return */
-		if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
-			error("dup2 over STDIN_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_stepd[0]);
-		(void) close(STDOUT_FILENO); /* ignore return */
-		if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
-			error("dup2 over STDOUT_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_slurmd[1]);
-		(void) close(STDERR_FILENO); /* ignore return */
-		if (dup2(devnull, STDERR_FILENO) == -1) {
-			error("dup2 /dev/null to STDERR_FILENO: %m");
-			exit(1);
+	if ((rc = _send_slurmstepd_init(to_stepd, type,
+					req, cli, self,
+					step_hset,
+					protocol_version)) != 0) {
+		error("Unable to init slurmstepd");
+		goto done;
+	}
+
+	/* If running under valgrind/memcheck, this pipe doesn't work
+	 * correctly so just skip it. */
+#if (SLURMSTEPD_MEMCHECK == 0)
+	i = read(to_slurmd, &rc, sizeof(int));
+	if (i < 0) {
+		error("%s: Can not read return code from slurmstepd "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_FAILURE;
+	} else if (i != sizeof(int)) {
+		error("%s: slurmstepd failed to send return code "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_FAILURE;
+	} else {
+		int delta_time = time(NULL) - start_time;
+		int cc;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
 		}
-		fd_set_noclose_on_exec(STDERR_FILENO);
-		log_fini();
-		if (!failed) {
-			if (conf->chos_loc && !access(conf->chos_loc, X_OK))
-				execvp(conf->chos_loc, argv);
-			else
-				execvp(argv[0], argv);
-			error("exec of slurmstepd failed: %m");
+		if (rc != SLURM_SUCCESS)
+			error("slurmstepd return code %d", rc);
+
+		cc = SLURM_SUCCESS;
+		cc = write(to_stepd, &cc, sizeof(int));
+		if (cc != sizeof(int)) {
+			error("%s: failed to send ack to stepd %d: %m",
+			      __func__, cc);
 		}
-		exit(2);
 	}
+#endif
+done:
+	if (_remove_starting_step(type, req))
+		error("Error cleaning up starting_step list");
+
+	/* Reap child */
+	if ((pid > 0) && (waitpid(pid, NULL, 0) < 0))
+		error("Unable to reap slurmd child process");
+	if (close(to_stepd) < 0)
+		error("close write to_stepd in parent: %m");
+	if (close(to_slurmd) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	END_TIMER;
+	_launch_hist_add(pooled, DELTA_TIMER);
+	return rc;
 }
 
 static void _setup_x11_display(uint32_t job_id, uint32_t step_id,
@@ -3551,6 +3773,18 @@ _rpc_daemon_status(slurm_msg_t *msg)
 	resp->slurmd_logfile     = xstrdup(conf->logfile);
 	resp->version            = xstrdup(SLURM_VERSION_STRING);
 
+	slurm_mutex_lock(&stepd_pool_mutex);
+	resp->stepd_pool_size    = stepd_pool_size;
+	resp->stepd_pool_idle    = stepd_pool_idle;
+	resp->launch_hist_cnt    = SLURMD_LAUNCH_HIST_CNT;
+	resp->launch_hist_pooled = xmalloc(sizeof(launch_hist_pooled));
+	memcpy(resp->launch_hist_pooled, launch_hist_pooled,
+	       sizeof(launch_hist_pooled));
+	resp->launch_hist_forked = xmalloc(sizeof(launch_hist_forked));
+	memcpy(resp->launch_hist_forked, launch_hist_forked,
+	       sizeof(launch_hist_forked));
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
 	slurm_msg_t_copy(&resp_msg, msg);
 	resp_msg.msg_type = RESPONSE_SLURMD_STATUS;
 	resp_msg.data     = resp;
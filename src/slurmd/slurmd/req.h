@@ -54,6 +54,16 @@ void gids_cache_purge(void);
 /* Add record for every launched job so we know they are ready for suspend */
 extern void record_launched_jobs(void);
 
+/*
+ * (Re)start the pool of idle slurmstepd configured with
+ * LaunchParameters=stepd_pool=#, replacing idle slurmstepd started with a
+ * previous configuration
+ */
+extern void stepd_pool_init(void);
+
+/* Terminate all idle slurmstepd of the pool */
+extern void stepd_pool_fini(void);
+
 void file_bcast_init(void);
 void file_bcast_purge(void);
 
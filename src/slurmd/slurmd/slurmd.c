@@ -363,6 +363,7 @@ main (int argc, char **argv)
 	list_install_fork_handlers();
 	slurm_conf_install_fork_handlers();
 	record_launched_jobs();
+	stepd_pool_init();
 
 	run_script_health_check();
 	slurm_thread_create_detached(NULL, _registration_engine, NULL);
@@ -371,6 +372,7 @@ main (int argc, char **argv)
 			     conf->msg_aggr_window_time,
 			     conf->msg_aggr_window_msgs);
 	_msg_engine();
+	stepd_pool_fini();
 
 	/*
 	 * Close fd here, otherwise we'll deadlock since create_pidfile()
@@ -1053,6 +1055,9 @@ _reconfigure(void)
 	/* reconfigure energy */
 	acct_gather_energy_g_set_data(ENERGY_DATA_RECONFIG, NULL);
 
+	/* Idle slurmstepd were started with the old configuration */
+	stepd_pool_init();
+
 	/*
 	 * XXX: reopen slurmd port?
 	 */
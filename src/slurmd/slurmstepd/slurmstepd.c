@@ -477,8 +477,19 @@ _init_from_slurmd(int sock, char **argv,
 
 	log_init(argv[0], lopts, LOG_DAEMON, NULL);
 
-	/* receive job type from slurmd */
-	safe_read(sock, &step_type, sizeof(int));
+	/*
+	 * receive job type from slurmd. An idle slurmstepd of the slurmd's
+	 * pool may wait here for a long time and just exits if slurmd closes
+	 * the pipe instead of handing it a step.
+	 */
+	while ((len = read(sock, &step_type, sizeof(int))) < 0) {
+		if ((errno != EINTR) && (errno != EAGAIN))
+			goto rwfail;
+	}
+	if (len == 0)
+		exit(0);
+	if (len != sizeof(int))
+		goto rwfail;
 	debug3("step_type = %d", step_type);
 
 	/* receive reverse-tree info from slurmd */
@@ -0,0 +1,140 @@
+/* Benchmark of the arena allocator of src/common/xmalloc.c
+ *
+ * Time unpacking and freeing typical RPCs, with each field freed by
+ * slurm_free_msg_data() and with the fields allocated from an arena
+ * attached to the buffer, then freed at once. Not run by "make check",
+ * run it by hand:
+ *	./arena-bench [message_count]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/slurmdbd/read_config.h"
+
+static int msg_cnt = 200000;
+
+static long _usec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000 +
+	       (now.tv_usec - start->tv_usec);
+}
+
+/* Returns the mean time to unpack and free msg in nsec, -1 on error */
+static long _run(slurm_msg_t *msg, bool use_arena)
+{
+	struct timeval start;
+	slurm_msg_t unpacked;
+	Buf buffer = init_buf(0);
+	uint32_t size;
+	long usec;
+	int i;
+
+	pack_msg(msg, buffer);
+	size = get_buf_offset(buffer);
+
+	slurm_msg_t_init(&unpacked);
+	unpacked.msg_type = msg->msg_type;
+	unpacked.protocol_version = msg->protocol_version;
+	gettimeofday(&start, NULL);
+	for (i = 0; i < msg_cnt; i++) {
+		set_buf_offset(buffer, 0);
+		if (use_arena)
+			buffer->arena = xarena_create();
+		if ((unpack_msg(&unpacked, buffer) != SLURM_SUCCESS) ||
+		    (get_buf_offset(buffer) != size))
+			break;
+		slurm_free_msg_data(unpacked.msg_type, unpacked.data);
+		xarena_destroy(buffer->arena);
+		buffer->arena = NULL;
+	}
+	usec = _usec_since(&start);
+	xarena_destroy(buffer->arena);
+	buffer->arena = NULL;
+	free_buf(buffer);
+	if (i < msg_cnt)
+		return -1;
+
+	return (usec * 1000) / msg_cnt;
+}
+
+static int _bench(char *name, uint16_t msg_type, void *data)
+{
+	slurm_msg_t msg;
+	long nsec_heap, nsec_arena;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = msg_type;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	msg.data = data;
+
+	nsec_heap = _run(&msg, false);
+	nsec_arena = _run(&msg, true);
+	if ((nsec_heap < 0) || (nsec_arena < 0)) {
+		fprintf(stderr, "%s: unpack failed\n", name);
+		return 1;
+	}
+	printf("%-24s unpack+free: xfree %5ld nsec, arena %5ld nsec\n",
+	       name, nsec_heap, nsec_arena);
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	epilog_complete_msg_t epilog;
+	complete_batch_script_msg_t batch;
+	step_complete_msg_t step;
+	update_part_msg_t part;
+	int rc = 0;
+
+	if (argc > 1)
+		msg_cnt = atoi(argv[1]);
+	if (msg_cnt < 1) {
+		fprintf(stderr, "message_count must be positive\n");
+		return 1;
+	}
+
+	/* Keep jobacctinfo_unpack() from loading a plugin */
+	slurmdbd_conf = xmalloc(sizeof(slurm_dbd_conf_t));
+
+	memset(&epilog, 0, sizeof(epilog));
+	epilog.job_id = 1234;
+	epilog.node_name = "node0001";
+	rc |= _bench("MESSAGE_EPILOG_COMPLETE", MESSAGE_EPILOG_COMPLETE,
+		     &epilog);
+
+	memset(&batch, 0, sizeof(batch));
+	batch.job_id = 1234;
+	batch.node_name = "node0001";
+	rc |= _bench("COMPLETE_BATCH_SCRIPT", REQUEST_COMPLETE_BATCH_SCRIPT,
+		     &batch);
+
+	memset(&step, 0, sizeof(step));
+	step.job_id = 1234;
+	step.job_step_id = 1;
+	rc |= _bench("REQUEST_STEP_COMPLETE", REQUEST_STEP_COMPLETE, &step);
+
+	slurm_init_part_desc_msg(&part);
+	part.name = "batch";
+	part.nodes = "node[0001-1024]";
+	part.allow_accounts = "physics,chemistry,biology";
+	part.allow_groups = "users";
+	part.allow_qos = "normal,high";
+	part.alternate = "debug";
+	part.deny_accounts = "guest";
+	part.qos_char = "part_qos";
+	rc |= _bench("REQUEST_UPDATE_PARTITION", REQUEST_UPDATE_PARTITION,
+		     &part);
+
+	xfree(slurmdbd_conf);
+	return rc;
+}
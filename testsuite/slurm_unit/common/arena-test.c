@@ -0,0 +1,160 @@
+/* Test of the arena allocator of src/common/xmalloc.c
+ *
+ * Check the handling of arena memory by xfree(), xrealloc() and xsize(),
+ * then unpack typical RPCs with and without an arena attached to the buffer
+ * and check that they pack back to the same bytes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmdbd/read_config.h"
+
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+static void _test_arena(void)
+{
+	xarena_t *arena = xarena_create();
+	char *str, *big, *small[200];
+	int i, ok = 1;
+
+	str = xarena_alloc(arena, 6);
+	TEST(str && (xsize(str) == 6), "xarena_alloc xsize");
+	TEST(((uintptr_t) str % (2 * sizeof(size_t))) == 0,
+	     "xarena_alloc alignment");
+	strcpy(str, "hello");
+	xstrcat(str, " world");
+	TEST(!strcmp(str, "hello world"), "xrealloc of arena memory");
+	xfree(str);
+	TEST(str == NULL, "xfree of moved arena memory");
+
+	big = xarena_alloc(arena, 100000);
+	TEST(big && (big[99999] == 0), "xarena_alloc large block");
+	/* fill several chunks, each block must keep its own contents */
+	for (i = 0; i < 200; i++) {
+		small[i] = xarena_alloc(arena, 100);
+		memset(small[i], i, 100);
+	}
+	for (i = 0; i < 200; i++) {
+		if ((small[i][0] != (char) i) || (small[i][99] != (char) i))
+			ok = 0;
+	}
+	TEST(ok, "xarena_alloc blocks do not overlap");
+	xfree(big);
+	TEST(big == NULL, "xfree of arena memory");
+	xarena_destroy(arena);
+
+	str = xarena_alloc(NULL, 8);
+	TEST(str && (xsize(str) == 8), "xarena_alloc without arena");
+	xfree(str);
+}
+
+/* Unpack msg, pack it again and compare with the original bytes */
+static bool _round_trip(slurm_msg_t *msg, bool use_arena)
+{
+	slurm_msg_t unpacked;
+	Buf buffer = init_buf(0), repacked = init_buf(0);
+	uint32_t size;
+	bool match = false;
+
+	pack_msg(msg, buffer);
+	size = get_buf_offset(buffer);
+
+	slurm_msg_t_init(&unpacked);
+	unpacked.msg_type = msg->msg_type;
+	unpacked.protocol_version = msg->protocol_version;
+	set_buf_offset(buffer, 0);
+	if (use_arena)
+		buffer->arena = xarena_create();
+	if ((unpack_msg(&unpacked, buffer) == SLURM_SUCCESS) &&
+	    (get_buf_offset(buffer) == size)) {
+		pack_msg(&unpacked, repacked);
+		match = (get_buf_offset(repacked) == size) &&
+			!memcmp(get_buf_data(repacked), get_buf_data(buffer),
+				size);
+		slurm_free_msg_data(unpacked.msg_type, unpacked.data);
+	}
+	xarena_destroy(buffer->arena);
+	buffer->arena = NULL;
+	free_buf(buffer);
+	free_buf(repacked);
+
+	return match;
+}
+
+static void _test_msg(char *name, uint16_t msg_type, void *data)
+{
+	slurm_msg_t msg;
+	char *str = NULL;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = msg_type;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	msg.data = data;
+
+	xstrfmtcat(str, "%s unpack to heap", name);
+	TEST(_round_trip(&msg, false), str);
+	xfree(str);
+	xstrfmtcat(str, "%s unpack to arena", name);
+	TEST(_round_trip(&msg, true), str);
+	xfree(str);
+}
+
+int
+main(int argc, char *argv[])
+{
+	epilog_complete_msg_t epilog;
+	complete_batch_script_msg_t batch;
+	step_complete_msg_t step;
+	update_part_msg_t part;
+
+	/* Keep jobacctinfo_unpack() from loading a plugin */
+	slurmdbd_conf = xmalloc(sizeof(slurm_dbd_conf_t));
+
+	_test_arena();
+
+	memset(&epilog, 0, sizeof(epilog));
+	epilog.job_id = 1234;
+	epilog.node_name = "node0001";
+	_test_msg("MESSAGE_EPILOG_COMPLETE", MESSAGE_EPILOG_COMPLETE, &epilog);
+
+	memset(&batch, 0, sizeof(batch));
+	batch.job_id = 1234;
+	batch.node_name = "node0001";
+	_test_msg("COMPLETE_BATCH_SCRIPT", REQUEST_COMPLETE_BATCH_SCRIPT, &batch);
+
+	memset(&step, 0, sizeof(step));
+	step.job_id = 1234;
+	step.job_step_id = 1;
+	_test_msg("REQUEST_STEP_COMPLETE", REQUEST_STEP_COMPLETE, &step);
+
+	slurm_init_part_desc_msg(&part);
+	part.name = "batch";
+	part.nodes = "node[0001-1024]";
+	part.allow_accounts = "physics,chemistry,biology";
+	part.allow_groups = "users";
+	part.allow_qos = "normal,high";
+	part.alternate = "debug";
+	part.deny_accounts = "guest";
+	part.qos_char = "part_qos";
+	_test_msg("REQUEST_UPDATE_PARTITION", REQUEST_UPDATE_PARTITION, &part);
+
+	xfree(slurmdbd_conf);
+	totals();
+	return failed;
+}
@@ -0,0 +1,169 @@
+/* Benchmark of src/common/eio.c
+ *
+ * Stream data through a number of pipes, as srun does with the stdout of
+ * the tasks of each node, and compare the throughput of the epoll and
+ * poll() backends at 16, 256 and 1024 connections. Not run by
+ * "make check", run it by hand:
+ *	./eio-bench
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "src/common/eio.h"
+#include "src/common/fd.h"
+#include "src/common/xmalloc.h"
+
+#define BURST_CHUNKS	8
+#define CHUNK_SIZE	128
+#define TOTAL_BYTES	(8 * 1024 * 1024)
+
+typedef struct {
+	int cnt;		/* number of pipes written to */
+	int *fds;		/* write end of each pipe */
+	int next;		/* pipe written to next */
+	uint64_t sent;		/* bytes written so far */
+} feeder_args_t;
+
+static uint64_t bytes_read = 0;
+
+static bool _readable(eio_obj_t *obj)
+{
+	return !obj->shutdown;
+}
+
+static int _read(eio_obj_t *obj, List objs)
+{
+	char buf[CHUNK_SIZE * BURST_CHUNKS];
+	ssize_t n;
+
+	if ((n = read(obj->fd, buf, sizeof(buf))) > 0) {
+		bytes_read += n;
+	} else if ((n == 0) || (errno != EAGAIN)) {
+		close(obj->fd);
+		obj->fd = -1;
+		obj->shutdown = true;
+	}
+	return 0;
+}
+
+/*
+ * The feeder object polls a pipe that always holds data, so it runs once
+ * per loop iteration. It writes a burst of chunks to one pipe in turn,
+ * like output arriving from one node while the connections to all other
+ * nodes are idle, so each wakeup has two ready objects out of cnt + 1.
+ */
+static int _feed(eio_obj_t *obj, List objs)
+{
+	feeder_args_t *args = obj->arg;
+	char buf[CHUNK_SIZE];
+	int i;
+
+	memset(buf, 'x', sizeof(buf));
+	for (i = 0; i < BURST_CHUNKS; i++) {
+		if (write(args->fds[args->next], buf, sizeof(buf)) !=
+		    sizeof(buf))
+			break;
+		args->sent += sizeof(buf);
+	}
+	args->next = (args->next + 1) % args->cnt;
+
+	if (args->sent >= TOTAL_BYTES) {
+		for (i = 0; i < args->cnt; i++)
+			close(args->fds[i]);
+		obj->shutdown = true;
+	}
+	return 0;
+}
+
+static struct io_operations reader_ops = {
+	.readable    = &_readable,
+	.handle_read = &_read,
+};
+
+static struct io_operations feeder_ops = {
+	.readable    = &_readable,
+	.handle_read = &_feed,
+};
+
+/* Returns throughput in MB/sec, or -1 on error */
+static double _run(int cnt, bool use_poll)
+{
+	eio_handle_t *eio = eio_handle_create(0);
+	feeder_args_t args;
+	struct timeval start, end;
+	double usec;
+	int i, p[2], feed[2];
+
+	if (use_poll)
+		setenv("SLURM_EIO_POLL", "1", 1);
+	else
+		unsetenv("SLURM_EIO_POLL");
+
+	memset(&args, 0, sizeof(args));
+	args.cnt = cnt;
+	args.fds = xmalloc(sizeof(int) * cnt);
+	for (i = 0; i < cnt; i++) {
+		if (pipe(p) < 0)
+			return -1;
+		fd_set_nonblocking(p[0]);
+		args.fds[i] = p[1];
+		eio_new_initial_obj(eio, eio_obj_create(p[0], &reader_ops,
+							NULL));
+	}
+	if ((pipe(feed) < 0) || (write(feed[1], "x", 1) != 1))
+		return -1;
+	eio_new_initial_obj(eio, eio_obj_create(feed[0], &feeder_ops, &args));
+
+	bytes_read = 0;
+	gettimeofday(&start, NULL);
+	eio_handle_mainloop(eio);
+	gettimeofday(&end, NULL);
+
+	close(feed[0]);
+	close(feed[1]);
+	eio_handle_destroy(eio);
+	xfree(args.fds);
+	if (bytes_read != TOTAL_BYTES)
+		return -1;
+
+	usec = (end.tv_sec - start.tv_sec) * 1000000.0 +
+	       (end.tv_usec - start.tv_usec);
+	return (TOTAL_BYTES / (1024.0 * 1024.0)) / (usec / 1000000.0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int cnts[] = { 16, 256, 1024 };
+	struct rlimit rlim;
+	double mb_epoll, mb_poll;
+	int i;
+
+	getrlimit(RLIMIT_NOFILE, &rlim);
+	rlim.rlim_cur = rlim.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &rlim);
+
+	for (i = 0; i < sizeof(cnts) / sizeof(cnts[0]); i++) {
+		if ((cnts[i] * 2 + 16) > rlim.rlim_cur) {
+			printf("%5d pipes: not enough file descriptors\n",
+			       cnts[i]);
+			break;
+		}
+		mb_epoll = _run(cnts[i], false);
+		mb_poll  = _run(cnts[i], true);
+		if ((mb_epoll < 0) || (mb_poll < 0)) {
+			fprintf(stderr, "%d pipes: not all data read\n",
+				cnts[i]);
+			return 1;
+		}
+		printf("%5d pipes: epoll %8.1f MB/sec, poll %8.1f MB/sec\n",
+		       cnts[i], mb_epoll, mb_poll);
+	}
+
+	return 0;
+}
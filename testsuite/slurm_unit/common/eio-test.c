@@ -0,0 +1,277 @@
+/* Test of src/common/eio.c
+ *
+ * Stream data through a number of pipes, as srun does with the stdout of
+ * the tasks of each node, with the epoll and poll() backends.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "src/common/eio.h"
+#include "src/common/fd.h"
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+#define BURST_CHUNKS	8
+#define CHUNK_SIZE	128
+#define TOTAL_BYTES	(1024 * 1024)
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+typedef struct {
+	int cnt;		/* number of pipes written to */
+	int *fds;		/* write end of each pipe */
+	int next;		/* pipe written to next */
+	uint64_t sent;		/* bytes written so far */
+} feeder_args_t;
+
+static uint64_t bytes_read = 0;
+
+static bool _readable(eio_obj_t *obj)
+{
+	return !obj->shutdown;
+}
+
+static int _read(eio_obj_t *obj, List objs)
+{
+	char buf[CHUNK_SIZE * BURST_CHUNKS];
+	ssize_t n;
+
+	if ((n = read(obj->fd, buf, sizeof(buf))) > 0) {
+		bytes_read += n;
+	} else if ((n == 0) || (errno != EAGAIN)) {
+		close(obj->fd);
+		obj->fd = -1;
+		obj->shutdown = true;
+	}
+	return 0;
+}
+
+/*
+ * The feeder object polls a pipe that always holds data, so it runs once
+ * per loop iteration. It writes a burst of chunks to one pipe in turn,
+ * like output arriving from one node while the connections to all other
+ * nodes are idle, so each wakeup has two ready objects out of cnt + 1.
+ */
+static int _feed(eio_obj_t *obj, List objs)
+{
+	feeder_args_t *args = obj->arg;
+	char buf[CHUNK_SIZE];
+	int i;
+
+	memset(buf, 'x', sizeof(buf));
+	for (i = 0; i < BURST_CHUNKS; i++) {
+		if (write(args->fds[args->next], buf, sizeof(buf)) !=
+		    sizeof(buf))
+			break;
+		args->sent += sizeof(buf);
+	}
+	args->next = (args->next + 1) % args->cnt;
+
+	if (args->sent >= TOTAL_BYTES) {
+		for (i = 0; i < args->cnt; i++)
+			close(args->fds[i]);
+		obj->shutdown = true;
+	}
+	return 0;
+}
+
+static struct io_operations reader_ops = {
+	.readable    = &_readable,
+	.handle_read = &_read,
+};
+
+static struct io_operations feeder_ops = {
+	.readable    = &_readable,
+	.handle_read = &_feed,
+};
+
+/*
+ * Objects of _test_reuse(). The trigger object replaces the idle object
+ * with a new one at the same address, polling a new pipe on the same fd,
+ * then makes the new pipe readable.
+ */
+static eio_obj_t *idle_obj = NULL;
+static eio_handle_t *reuse_eio = NULL;
+static bool reuse_read = false, reuse_stop = false;
+
+static int _read_reused(eio_obj_t *obj, List objs)
+{
+	ListIterator iter;
+	eio_obj_t *o;
+
+	reuse_read = true;
+	iter = list_iterator_create(objs);
+	while ((o = list_next(iter)))
+		o->shutdown = true;
+	list_iterator_destroy(iter);
+	return 0;
+}
+
+static struct io_operations reused_ops = {
+	.readable    = &_readable,
+	.handle_read = &_read_reused,
+};
+
+static int _replace_idle(eio_obj_t *obj, List objs)
+{
+	ListIterator iter;
+	eio_obj_t *new_obj, *o;
+	int fd = idle_obj->fd, p[2];
+
+	obj->shutdown = true;
+	close(fd);
+	iter = list_iterator_create(objs);
+	while ((o = list_next(iter))) {
+		if (o == idle_obj) {
+			list_remove(iter);
+			break;
+		}
+	}
+	list_iterator_destroy(iter);
+	if (pipe(p) < 0)
+		return 0;
+	if (p[0] != fd) {
+		dup2(p[0], fd);
+		close(p[0]);
+	}
+	/* Free the old object and create the new one in its memory, as
+	 * malloc may do */
+	new_obj = eio_obj_create(fd, &reused_ops, NULL);
+	xfree(idle_obj->ops);
+	memcpy(idle_obj, new_obj, sizeof(eio_obj_t));
+	xfree(new_obj);
+	list_append(objs, idle_obj);
+	if (write(p[1], "x", 1) != 1)
+		return 0;
+	close(p[1]);
+	return 0;
+}
+
+static struct io_operations replace_ops = {
+	.readable    = &_readable,
+	.handle_read = &_replace_idle,
+};
+
+/* Shut the loop down if the new object is never polled */
+static void *_reuse_timeout(void *arg)
+{
+	int i;
+
+	for (i = 0; (i < 500) && !reuse_stop; i++)
+		usleep(10000);
+	if (!reuse_stop)
+		eio_signal_shutdown(reuse_eio);
+	return NULL;
+}
+
+/* An object freed while registered and replaced by one with the same fd
+ * and address must still be polled */
+static void _test_reuse(void)
+{
+	pthread_t tid;
+	int idle[2], trigger[2];
+
+	unsetenv("SLURM_EIO_POLL");
+	if ((pipe(idle) < 0) || (pipe(trigger) < 0) ||
+	    (write(trigger[1], "x", 1) != 1)) {
+		fail("epoll reused fd and object polled");
+		return;
+	}
+	reuse_eio = eio_handle_create(0);
+	idle_obj = eio_obj_create(idle[0], &reader_ops, NULL);
+	eio_new_initial_obj(reuse_eio, idle_obj);
+	eio_new_initial_obj(reuse_eio, eio_obj_create(trigger[0], &replace_ops,
+						      NULL));
+	slurm_thread_create(&tid, _reuse_timeout, NULL);
+	eio_handle_mainloop(reuse_eio);
+	reuse_stop = true;
+	pthread_join(tid, NULL);
+	TEST(reuse_read, "epoll reused fd and object polled");
+
+	close(idle_obj->fd);
+	close(idle[1]);
+	close(trigger[0]);
+	close(trigger[1]);
+	eio_handle_destroy(reuse_eio);
+}
+
+/* Returns true if all data written to cnt pipes was read */
+static bool _run(int cnt, bool use_poll)
+{
+	eio_handle_t *eio = eio_handle_create(0);
+	feeder_args_t args;
+	int i, p[2], feed[2];
+
+	if (use_poll)
+		setenv("SLURM_EIO_POLL", "1", 1);
+	else
+		unsetenv("SLURM_EIO_POLL");
+
+	memset(&args, 0, sizeof(args));
+	args.cnt = cnt;
+	args.fds = xmalloc(sizeof(int) * cnt);
+	for (i = 0; i < cnt; i++) {
+		if (pipe(p) < 0)
+			return false;
+		fd_set_nonblocking(p[0]);
+		args.fds[i] = p[1];
+		eio_new_initial_obj(eio, eio_obj_create(p[0], &reader_ops,
+							NULL));
+	}
+	if ((pipe(feed) < 0) || (write(feed[1], "x", 1) != 1))
+		return false;
+	eio_new_initial_obj(eio, eio_obj_create(feed[0], &feeder_ops, &args));
+
+	bytes_read = 0;
+	eio_handle_mainloop(eio);
+
+	close(feed[0]);
+	close(feed[1]);
+	eio_handle_destroy(eio);
+	xfree(args.fds);
+	return (bytes_read == TOTAL_BYTES);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int cnts[] = { 16, 256, 1024 };
+	struct rlimit rlim;
+	char *msg = NULL;
+	int i;
+
+	_test_reuse();
+
+	getrlimit(RLIMIT_NOFILE, &rlim);
+	rlim.rlim_cur = rlim.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &rlim);
+
+	for (i = 0; i < sizeof(cnts) / sizeof(cnts[0]); i++) {
+		if ((cnts[i] * 2 + 16) > rlim.rlim_cur)
+			break;
+		xstrfmtcat(msg, "epoll read all data of %d pipes", cnts[i]);
+		TEST(_run(cnts[i], false), msg);
+		xfree(msg);
+		xstrfmtcat(msg, "poll read all data of %d pipes", cnts[i]);
+		TEST(_run(cnts[i], true), msg);
+		xfree(msg);
+	}
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,78 @@
+/* Benchmark of src/plugins/priority/multifactor/fair_tree.c
+ *
+ * Build a synthetic association tree of 100 accounts, each with 20
+ * subaccounts of 20 users, and time fair_tree_decay() with one and with
+ * FT_MAX_THREADS worker threads. Not run by "make check", run it by hand:
+ *	./fair_tree-bench [accounts [subaccounts [users]]]
+ */
+#include <sys/time.h>
+
+#include "fair_tree-common.c"
+
+#define BENCH_RUNS	5
+
+static long _usec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000 +
+	       (now.tv_usec - start->tv_usec);
+}
+
+/* Returns the mean run time of fair_tree_decay() in usec */
+static long _time_runs(int threads, double *fs_factor)
+{
+	struct timeval start;
+	long usec = 0;
+	int run;
+
+	for (run = 0; run < BENCH_RUNS; run++) {
+		gettimeofday(&start, NULL);
+		_run(threads, fs_factor);
+		usec += _usec_since(&start);
+	}
+
+	return usec / BENCH_RUNS;
+}
+
+int
+main(int argc, char *argv[])
+{
+	int accounts = 100, subaccts = 20, users_per_acct = 20;
+	double *fs_serial, *fs_parallel;
+	long usec_serial, usec_parallel;
+	int i, diff = 0;
+
+	if (argc > 1)
+		accounts = atoi(argv[1]);
+	if (argc > 2)
+		subaccts = atoi(argv[2]);
+	if (argc > 3)
+		users_per_acct = atoi(argv[3]);
+	if ((accounts < 1) || (subaccts < 1) || (users_per_acct < 1)) {
+		fprintf(stderr, "counts must be positive\n");
+		return 1;
+	}
+
+	_build_tree(accounts, subaccts, users_per_acct);
+	fs_serial = xmalloc(sizeof(double) * user_cnt);
+	fs_parallel = xmalloc(sizeof(double) * user_cnt);
+
+	usec_serial = _time_runs(1, fs_serial);
+	usec_parallel = _time_runs(FT_MAX_THREADS, fs_parallel);
+	for (i = 0; i < user_cnt; i++) {
+		if (fs_serial[i] != fs_parallel[i])
+			diff++;
+	}
+	printf("fair_tree_decay %d users in %d accounts: 1 thread %ld usec, "
+	       "up to %d threads %ld usec\n", user_cnt,
+	       accounts * (subaccts + 1), usec_serial, FT_MAX_THREADS,
+	       usec_parallel);
+	if (diff)
+		fprintf(stderr, "%d fs_factor differences\n", diff);
+
+	xfree(fs_serial);
+	xfree(fs_parallel);
+	return diff ? 1 : 0;
+}
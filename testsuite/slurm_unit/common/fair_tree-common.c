@@ -0,0 +1,137 @@
+/* Synthetic association tree shared by fair_tree-test and fair_tree-bench
+ *
+ * Stub the slurmctld and priority_multifactor.c symbols used by
+ * src/plugins/priority/multifactor/fair_tree.c, build an association tree
+ * with random shares and usage, and run fair_tree_decay() on it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Include the plugin source to reach its thread count */
+#include "src/plugins/priority/multifactor/fair_tree.c"
+
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* Symbols of slurmctld and priority_multifactor.c used by fair_tree.c */
+bool priority_debug = false;
+
+extern void lock_slurmctld_at(slurmctld_lock_t lock_levels, const char *file,
+			      int line, const char *func)
+{
+}
+
+extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
+{
+}
+
+extern bool decay_apply_new_usage(struct job_record *job_ptr,
+				  time_t *start_time_ptr)
+{
+	return true;
+}
+
+extern int decay_apply_weighted_factors(struct job_record *job_ptr,
+					time_t *start_time_ptr)
+{
+	return SLURM_SUCCESS;
+}
+
+extern void set_assoc_usage_norm(slurmdb_assoc_rec_t *assoc)
+{
+	assoc->usage->usage_norm = assoc->usage->usage_raw /
+				   assoc_mgr_root_assoc->usage->usage_raw;
+}
+
+static slurmdb_assoc_rec_t **users = NULL;
+static int user_cnt = 0;
+
+static slurmdb_assoc_rec_t *_add_assoc(slurmdb_assoc_rec_t *parent,
+				       char *acct, char *user)
+{
+	slurmdb_assoc_rec_t *assoc = xmalloc(sizeof(slurmdb_assoc_rec_t));
+
+	assoc->acct = acct;
+	assoc->user = user;
+	assoc->shares_raw = 1 + (random() % 10);
+	assoc->usage = slurmdb_create_assoc_usage(1);
+	assoc->usage->children_list = list_create(NULL);
+	/* Give a few associations the same usage to create ties */
+	assoc->usage->usage_raw = (long double) (random() % 1000);
+	if (parent) {
+		assoc->usage->parent_assoc_ptr = parent;
+		assoc->usage->fs_assoc_ptr = parent;
+		list_append(parent->usage->children_list, assoc);
+		parent->usage->usage_raw += assoc->usage->usage_raw;
+	}
+	if (user) {
+		users = xrealloc(users, sizeof(slurmdb_assoc_rec_t *) *
+					(user_cnt + 1));
+		users[user_cnt++] = assoc;
+	}
+	return assoc;
+}
+
+/* Set shares_norm of the children of assoc, recursively */
+static void _set_shares(slurmdb_assoc_rec_t *assoc)
+{
+	ListIterator itr;
+	slurmdb_assoc_rec_t *child;
+	uint32_t level_shares = 0;
+
+	itr = list_iterator_create(assoc->usage->children_list);
+	while ((child = list_next(itr)))
+		level_shares += child->shares_raw;
+	list_iterator_reset(itr);
+	while ((child = list_next(itr))) {
+		child->usage->shares_norm =
+			(double) child->shares_raw / (double) level_shares;
+		_set_shares(child);
+	}
+	list_iterator_destroy(itr);
+}
+
+/* Build a tree of accounts, each with subaccts subaccounts of users users */
+static void _build_tree(int accounts, int subaccts, int users_per_acct)
+{
+	slurmdb_assoc_rec_t *root, *acct, *sub;
+	int i, j, k;
+
+	srandom(1);
+	root = _add_assoc(NULL, "root", NULL);
+	for (i = 0; i < accounts; i++) {
+		acct = _add_assoc(root, xstrdup_printf("a%d", i), NULL);
+		for (j = 0; j < subaccts; j++) {
+			sub = _add_assoc(acct, xstrdup_printf("a%d_%d", i, j),
+					 NULL);
+			for (k = 0; k < users_per_acct; k++) {
+				_add_assoc(sub, sub->acct,
+					   xstrdup_printf("u%d", k));
+			}
+		}
+	}
+	/* Root usage is the total usage of all users */
+	root->usage->usage_raw = 0;
+	for (i = 0; i < user_cnt; i++)
+		root->usage->usage_raw += users[i]->usage->usage_raw;
+	_set_shares(root);
+
+	assoc_mgr_root_assoc = root;
+	g_user_assoc_count = user_cnt;
+}
+
+/* Run fair_tree_decay() with the given number of threads */
+static void _run(int threads, double *fs_factor)
+{
+	List jobs = list_create(NULL);
+	int i;
+
+	ft_max_threads = threads;
+	for (i = 0; i < user_cnt; i++)
+		users[i]->usage->fs_factor = 0.0;
+	fair_tree_decay(jobs, time(NULL));
+	for (i = 0; i < user_cnt; i++)
+		fs_factor[i] = users[i]->usage->fs_factor;
+	FREE_NULL_LIST(jobs);
+}
@@ -0,0 +1,51 @@
+/* Test of src/plugins/priority/multifactor/fair_tree.c
+ *
+ * Build a synthetic association tree and compare the fairshare factors set
+ * by fair_tree_decay() with one and several worker threads.
+ */
+#include "fair_tree-common.c"
+
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+/* 10000 users, enough for two threads of FT_USERS_PER_THREAD */
+#define TREE_ACCOUNTS	25	/* accounts below root */
+#define TREE_SUBACCTS	20	/* accounts below each of them */
+#define TREE_USERS	20	/* users in each of those */
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+int
+main(int argc, char *argv[])
+{
+	double *fs_serial, *fs_parallel;
+	int i, diff = 0, zero = 0;
+
+	_build_tree(TREE_ACCOUNTS, TREE_SUBACCTS, TREE_USERS);
+	fs_serial = xmalloc(sizeof(double) * user_cnt);
+	fs_parallel = xmalloc(sizeof(double) * user_cnt);
+
+	_run(1, fs_serial);
+	_run(FT_MAX_THREADS, fs_parallel);
+
+	for (i = 0; i < user_cnt; i++) {
+		if (fs_serial[i] != fs_parallel[i])
+			diff++;
+		if ((fs_serial[i] <= 0.0) || (fs_serial[i] > 1.0))
+			zero++;
+	}
+	TEST(zero == 0, "fair tree fs_factor range");
+	TEST(diff == 0, "fair tree parallel matches serial");
+
+	xfree(fs_serial);
+	xfree(fs_parallel);
+	totals();
+	return failed;
+}
@@ -0,0 +1,215 @@
+/* Test of the job GRES tests of src/common/gres.c
+ *
+ * Configure a node with two sockets of eight cores, each bound to four GPUs
+ * of a different type, then check which cores gres_plugin_job_core_filter()
+ * and gres_plugin_job_test() leave to jobs as GPUs are allocated and
+ * released.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/gres.h"
+#include "src/common/pack.h"
+#include "src/common/read_config.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+#define CORES		16
+#define NODE_GRES	"gpu:k80:4,gpu:p100:4"
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+static char conf_dir[] = "/tmp/gres-testXXXXXX";
+
+static void _write_file(char *name, char *content)
+{
+	char *path = xstrdup_printf("%s/%s", conf_dir, name);
+	FILE *fp = fopen(path, "w");
+
+	if (fp) {
+		fputs(content, fp);
+		fclose(fp);
+	}
+	xfree(path);
+}
+
+/* Write slurm.conf, gres.conf and the device files. No gres/gpu plugin is
+ * found in PluginDir, so only GRES counts and topology are tracked. */
+static void _write_config(void)
+{
+	char *str = NULL;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		str = xstrdup_printf("gpu%d", i);
+		_write_file(str, "");
+		xfree(str);
+	}
+	str = xstrdup_printf("ClusterName=test\nControlMachine=localhost\n"
+			     "GresTypes=gpu\nPluginDir=%s\n", conf_dir);
+	_write_file("slurm.conf", str);
+	xfree(str);
+	str = xstrdup_printf("Name=gpu Type=k80 File=%s/gpu[0-3] Cores=0-7\n"
+			     "Name=gpu Type=p100 File=%s/gpu[4-7] Cores=8-15\n",
+			     conf_dir, conf_dir);
+	_write_file("gres.conf", str);
+	xfree(str);
+	str = xstrdup_printf("%s/slurm.conf", conf_dir);
+	setenv("SLURM_CONF", str, 1);
+	xfree(str);
+}
+
+static void _remove_config(void)
+{
+	char *cmd = xstrdup_printf("rm -rf %s", conf_dir);
+
+	if (system(cmd))
+		note("could not remove %s", conf_dir);
+	xfree(cmd);
+}
+
+static List _job_gres(char *req)
+{
+	char *config = xstrdup(req);
+	List gres_list = NULL;
+
+	if (gres_plugin_job_state_validate(&config, &gres_list))
+		gres_list = NULL;
+	xfree(config);
+	return gres_list;
+}
+
+/* Return the cores left to a job by the core filter, as a range string */
+static char *_filter(List job_gres, List node_gres, bool use_total_gres)
+{
+	bitstr_t *core_bitmap = bit_alloc(CORES);
+	char *str;
+
+	bit_nset(core_bitmap, 0, CORES - 1);
+	gres_plugin_job_core_filter(job_gres, node_gres, use_total_gres,
+				    core_bitmap, 0, CORES - 1, "n1");
+	str = bit_fmt_full(core_bitmap);
+	FREE_NULL_BITMAP(core_bitmap);
+	return str;
+}
+
+static bool _filter_is(List job_gres, List node_gres, bool use_total_gres,
+		       char *expect)
+{
+	char *str = _filter(job_gres, node_gres, use_total_gres);
+	bool match = !xstrcmp(str ? str : "", expect);
+
+	if (!match)
+		note("core filter left %s, expected %s", str, expect);
+	xfree(str);
+	return match;
+}
+
+static uint32_t _test(List job_gres, List node_gres, char *cores)
+{
+	bitstr_t *core_bitmap = bit_alloc(CORES);
+	uint32_t cnt;
+
+	bit_unfmt(core_bitmap, cores);
+	cnt = gres_plugin_job_test(job_gres, node_gres, false, core_bitmap,
+				   0, CORES - 1, 1, "n1");
+	FREE_NULL_BITMAP(core_bitmap);
+	return cnt;
+}
+
+int
+main(int argc, char *argv[])
+{
+	List node_gres = NULL, job_any, job_k80, job_p100, job_alloc;
+	char *new_config = NULL, *reason = NULL;
+	bitstr_t *alloc_cores;
+	Buf buffer;
+
+	if (!mkdtemp(conf_dir)) {
+		fail("mkdtemp");
+		totals();
+		return failed;
+	}
+	_write_config();
+	slurm_conf_init(NULL);
+
+	/* Pass the topology read by slurmd to the controller side */
+	gres_plugin_node_config_load(CORES, "n1", NULL);
+	buffer = init_buf(0);
+	gres_plugin_node_config_pack(buffer);
+	set_buf_offset(buffer, 0);
+	TEST(gres_plugin_node_config_unpack(buffer, "n1") == SLURM_SUCCESS,
+	     "node config unpack");
+	free_buf(buffer);
+	gres_plugin_init_node_config("n1", NODE_GRES, &node_gres);
+	TEST(gres_plugin_node_config_validate("n1", NODE_GRES, &new_config,
+					      &node_gres, 1, &reason) ==
+	     SLURM_SUCCESS, "node config validate");
+	xfree(new_config);
+	xfree(reason);
+
+	job_any  = _job_gres("gpu:2");
+	job_k80  = _job_gres("gpu:k80:2");
+	job_p100 = _job_gres("gpu:p100:2");
+	job_alloc = _job_gres("gpu:k80:4");
+	TEST(job_any && job_k80 && job_p100 && job_alloc, "job gres");
+
+	TEST(_filter_is(job_any, node_gres, false, "0-15"),
+	     "core filter, any type");
+	TEST(_filter_is(job_k80, node_gres, false, "0-7"),
+	     "core filter, type k80");
+	TEST(_filter_is(job_p100, node_gres, false, "8-15"),
+	     "core filter, type p100");
+	TEST(_test(job_any, node_gres, "0-15") == CORES, "job test, any type");
+	TEST(_test(job_k80, node_gres, "0-15") == 8, "job test, type k80");
+	TEST(_test(job_p100, node_gres, "0-15") == 8, "job test, type p100");
+	TEST(_test(job_p100, node_gres, "0-7") == 0,
+	     "job test, type p100 on wrong socket");
+
+	/* Allocate all k80 GPUs */
+	alloc_cores = bit_alloc(CORES);
+	bit_nset(alloc_cores, 0, 7);
+	TEST(gres_plugin_job_alloc(job_alloc, node_gres, 1, 0, 8, 2, "n1",
+				   alloc_cores) == SLURM_SUCCESS, "job alloc");
+	TEST(_filter_is(job_any, node_gres, false, "8-15"),
+	     "core filter after alloc, any type");
+	TEST(_filter_is(job_k80, node_gres, false, ""),
+	     "core filter after alloc, type k80");
+	TEST(_filter_is(job_k80, node_gres, true, "0-7"),
+	     "core filter after alloc, type k80, total gres");
+	TEST(_test(job_k80, node_gres, "0-15") == 0,
+	     "job test after alloc, type k80");
+	TEST(_test(job_any, node_gres, "0-15") == 8,
+	     "job test after alloc, any type");
+
+	TEST(gres_plugin_job_dealloc(job_alloc, node_gres, 0, 2, "n1") ==
+	     SLURM_SUCCESS, "job dealloc");
+	TEST(_filter_is(job_any, node_gres, false, "0-15"),
+	     "core filter after dealloc, any type");
+	TEST(_filter_is(job_k80, node_gres, false, "0-7"),
+	     "core filter after dealloc, type k80");
+
+	FREE_NULL_BITMAP(alloc_cores);
+	FREE_NULL_LIST(job_any);
+	FREE_NULL_LIST(job_k80);
+	FREE_NULL_LIST(job_p100);
+	FREE_NULL_LIST(job_alloc);
+	FREE_NULL_LIST(node_gres);
+	gres_plugin_fini();
+	_remove_config();
+	totals();
+	return failed;
+}
@@ -0,0 +1,92 @@
+/* Benchmark of src/common/hostlist.c
+ *
+ * Time hostlist_create() and hostlist_ranged_string() of a list of 100k
+ * hosts, and hostset_within() and hostset_delete() on a set in which each
+ * host is its own range. Not run by "make check", run it by hand:
+ *	./hostlist-bench [host_count]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "src/common/hostlist.h"
+#include "src/common/xmalloc.h"
+
+static int host_cnt = 100000;
+
+static long _usec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000 +
+	       (now.tv_usec - start->tv_usec);
+}
+
+/* Build a comma separated list of every step'th host name */
+static char *_host_names(int step)
+{
+	char *str = xmalloc(host_cnt * 12);
+	int i, len = 0;
+
+	for (i = 0; i < host_cnt; i += step)
+		len += sprintf(str + len, "%snode%06d", i ? "," : "", i);
+	return str;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct timeval start;
+	hostlist_t hl;
+	hostset_t set;
+	char *str, *ranged, host[32];
+	int i, cnt;
+
+	if (argc > 1)
+		host_cnt = atoi(argv[1]);
+	if ((host_cnt < 4) || (host_cnt > 1000000)) {
+		fprintf(stderr, "host_count must be 4 to 1000000\n");
+		return 1;
+	}
+
+	str = _host_names(1);
+	gettimeofday(&start, NULL);
+	hl = hostlist_create(str);
+	printf("hostlist_create %d hosts: %ld usec\n", host_cnt,
+	       _usec_since(&start));
+	xfree(str);
+
+	gettimeofday(&start, NULL);
+	ranged = hostlist_ranged_string_xmalloc(hl);
+	printf("hostlist_ranged_string %d hosts: %ld usec\n", host_cnt,
+	       _usec_since(&start));
+	xfree(ranged);
+	hostlist_destroy(hl);
+
+	/* every other host, so that each host is its own range */
+	str = _host_names(2);
+	set = hostset_create(str);
+	xfree(str);
+
+	gettimeofday(&start, NULL);
+	for (i = 0, cnt = 0; i < host_cnt; i += 2) {
+		snprintf(host, sizeof(host), "node%06d", i);
+		if (hostset_within(set, host))
+			cnt++;
+	}
+	printf("hostset_within %d lookups: %ld usec\n", (host_cnt + 1) / 2,
+	       _usec_since(&start));
+	if (cnt != (host_cnt + 1) / 2)
+		fprintf(stderr, "hostset_within found %d hosts\n", cnt);
+
+	snprintf(host, sizeof(host), "node[000000-%06d]", host_cnt / 2 - 1);
+	gettimeofday(&start, NULL);
+	cnt = hostset_delete(set, host);
+	printf("hostset_delete %d hosts: %ld usec\n", cnt,
+	       _usec_since(&start));
+	hostset_destroy(set);
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+/* Test of src/common/hostlist.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/hostlist.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include <testsuite/dejagnu.h>
+
+/* Number of hosts in the large list expressions */
+#define LARGE_HOSTS 10000
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* Build a comma separated list of every step'th host name */
+static char *_host_names(int step)
+{
+	char *str = xmalloc(LARGE_HOSTS * 12);
+	int i, len = 0;
+
+	for (i = 0; i < LARGE_HOSTS; i += step)
+		len += sprintf(str + len, "%snode%06d", i ? "," : "", i);
+	return str;
+}
+
+static void _test_hostset(void)
+{
+	hostset_t set;
+	char buf[256];
+
+	set = hostset_create("n[1-10,20-30],n05x,login");
+	TEST(hostset_count(set) == 23, "hostset_create count");
+	TEST(hostset_within(set, "n[2-5,25]"), "hostset_within");
+	TEST(!hostset_within(set, "n[9-12]"), "hostset_within partial");
+	TEST(hostset_within(set, "login,n05x"), "hostset_within singles");
+	TEST(hostset_intersects(set, "n[11-21]"), "hostset_intersects");
+	TEST(!hostset_intersects(set, "n[11-19],foo"),
+	     "hostset_intersects none");
+	TEST(hostset_find(set, "n20") == 11, "hostset_find position");
+	TEST(hostset_find(set, "n15") == -1, "hostset_find missing");
+
+	TEST(hostset_insert(set, "n[8-22]") == 9, "hostset_insert");
+	hostset_ranged_string(set, sizeof(buf), buf);
+	TEST(!strcmp(buf, "login,n[1-30],n05x"), "hostset_insert merge");
+
+	TEST(hostset_delete(set, "n[3-5,29-40],login") == 6,
+	     "hostset_delete");
+	hostset_ranged_string(set, sizeof(buf), buf);
+	TEST(!strcmp(buf, "n[1-2,6-28],n05x"), "hostset_delete split");
+	TEST(hostset_count(set) == 26, "hostset_delete count");
+	hostset_destroy(set);
+
+	set = hostset_create("nid0000[2-7]");
+	TEST(hostset_within(set, "nid00002"), "hostset_within padded");
+	TEST(hostset_delete(set, "nid0000[1-3]") == 2, "hostset_delete padded");
+	TEST(hostset_delete_host(set, "nid00007"), "hostset_delete_host padded");
+	TEST(hostset_count(set) == 3, "hostset_delete padded count");
+	hostset_destroy(set);
+}
+
+/* Operations on lists long enough to hold many ranges */
+static void _test_large(void)
+{
+	hostlist_t hl;
+	hostset_t set;
+	char *str, *ranged;
+	int i;
+
+	str = _host_names(1);
+	hl = hostlist_create(str);
+	TEST(hostlist_count(hl) == LARGE_HOSTS, "large hostlist_count");
+	ranged = hostlist_ranged_string_xmalloc(hl);
+	TEST(!strcmp(ranged, "node[000000-009999]"), "large ranged string");
+	xfree(ranged);
+	hostlist_destroy(hl);
+	xfree(str);
+
+	/* every other host, so that each host is its own range */
+	str = _host_names(2);
+	set = hostset_create(str);
+	xfree(str);
+	for (i = 0; i < LARGE_HOSTS; i += 2) {
+		char host[32];
+		snprintf(host, sizeof(host), "node%06d", i);
+		if (!hostset_within(set, host))
+			break;
+	}
+	TEST(i >= LARGE_HOSTS, "large hostset_within");
+	TEST(!hostset_within(set, "node000001"), "large hostset_within odd");
+	hostset_delete(set, "node[000000-004999]");
+	TEST(hostset_count(set) == LARGE_HOSTS / 4, "large hostset_delete");
+	hostset_destroy(set);
+}
+
+int
+main(int argc, char *argv[])
+{
+	_test_hostset();
+	_test_large();
+
+	totals();
+	return failed;
+}
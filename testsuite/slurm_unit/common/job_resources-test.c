@@ -0,0 +1,153 @@
+/* Test of the core bitmap functions of job_resources.c
+ *
+ * Fill a cluster-wide core bitmap, laid out as select/cons_res keeps the
+ * rows of a partition, with whole node and partial node jobs, compare the
+ * results of add_job_to_cores(), remove_job_from_cores() and
+ * job_fits_into_cores() with a core by core reference.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/job_resources.h"
+#include "src/common/node_conf.h"
+#include "src/common/xmalloc.h"
+
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+#define NODE_CNT	1000
+#define CORE_CNT	128	/* cores per node */
+#define JOB_CNT		500
+#define JOB_NODES	16	/* maximum nodes per job */
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+static uint16_t bits_per_node[NODE_CNT];
+static job_resources_t *jobs[JOB_CNT];
+
+/* Set or clear the cores of a job in full_bitmap, or test them for
+ * conflicts, one core at a time. Returns 0 on conflict. */
+static int _ref_cores(job_resources_t *job, bitstr_t *full_bitmap, int op)
+{
+	int n, i, job_bit_inx = 0, full_bit_inx;
+	int last = bit_fls(job->node_bitmap);
+
+	for (n = bit_ffs(job->node_bitmap); n <= last; n++) {
+		if (!bit_test(job->node_bitmap, n))
+			continue;
+		full_bit_inx = cr_node_cores_offset[n];
+		for (i = 0; i < bits_per_node[n]; i++) {
+			if ((job->whole_node != 1) &&
+			    !bit_test(job->core_bitmap, job_bit_inx + i))
+				continue;
+			if (op == 0) {
+				if (bit_test(full_bitmap, full_bit_inx + i))
+					return 0;
+			} else if (op == 1) {
+				bit_set(full_bitmap, full_bit_inx + i);
+			} else {
+				bit_clear(full_bitmap, full_bit_inx + i);
+			}
+		}
+		job_bit_inx += bits_per_node[n];
+	}
+	return 1;
+}
+
+static job_resources_t *_create_job(int whole_node)
+{
+	job_resources_t *job = create_job_resources();
+	int i, n, node_cnt = 1 + (random() % JOB_NODES);
+	int first = random() % (NODE_CNT - JOB_NODES);
+
+	job->node_bitmap = bit_alloc(NODE_CNT);
+	for (i = 0; i < node_cnt; i++)
+		bit_set(job->node_bitmap, first + (random() % JOB_NODES));
+	node_cnt = bit_set_count(job->node_bitmap);
+	job->core_bitmap = bit_alloc(node_cnt * CORE_CNT);
+	if (whole_node) {
+		job->whole_node = 1;
+		bit_nset(job->core_bitmap, 0, node_cnt * CORE_CNT - 1);
+	} else {
+		for (n = 0; n < node_cnt; n++) {
+			i = n * CORE_CNT + (random() % CORE_CNT);
+			bit_set(job->core_bitmap, i);
+			if (random() % 2)
+				bit_set(job->core_bitmap,
+					n * CORE_CNT +
+					(random() % CORE_CNT));
+		}
+	}
+	return job;
+}
+
+int
+main(int argc, char *argv[])
+{
+	bitstr_t *full = NULL, *ref;
+	int i, fits_diff = 0, fits_cnt = 0;
+
+	node_record_count = NODE_CNT;
+	cr_node_cores_offset = xmalloc((NODE_CNT + 1) * sizeof(uint32_t));
+	for (i = 0; i < NODE_CNT; i++) {
+		bits_per_node[i] = CORE_CNT;
+		cr_node_cores_offset[i + 1] = cr_node_cores_offset[i] +
+					      CORE_CNT;
+	}
+	ref = bit_alloc(NODE_CNT * CORE_CNT);
+
+	srandom(1);
+	for (i = 0; i < JOB_CNT; i++)
+		jobs[i] = _create_job(i % 2);
+
+	/* Place jobs as cons_res places them in a row: only if they fit */
+	for (i = 0; i < JOB_CNT; i++) {
+		if (_ref_cores(jobs[i], ref, 0) !=
+		    job_fits_into_cores(jobs[i], full, bits_per_node))
+			fits_diff++;
+		if (!_ref_cores(jobs[i], ref, 0))
+			continue;
+		_ref_cores(jobs[i], ref, 1);
+		add_job_to_cores(jobs[i], &full, bits_per_node);
+		fits_cnt++;
+	}
+	TEST(fits_diff == 0, "job_fits_into_cores matches reference");
+	TEST(full && bit_equal(full, ref),
+	     "add_job_to_cores matches reference");
+	note("%d of %d jobs placed in row", fits_cnt, JOB_CNT);
+
+	for (i = 0; i < JOB_CNT; i += 3) {
+		_ref_cores(jobs[i], ref, 2);
+		remove_job_from_cores(jobs[i], &full, bits_per_node);
+	}
+	TEST(bit_equal(full, ref), "remove_job_from_cores matches reference");
+
+	/* Fill the row again, releasing each job right after placing it */
+	for (i = 0; i < JOB_CNT; i++) {
+		if (_ref_cores(jobs[i], ref, 0))
+			_ref_cores(jobs[i], ref, 1);
+		_ref_cores(jobs[i], ref, 2);
+		if (job_fits_into_cores(jobs[i], full, bits_per_node))
+			add_job_to_cores(jobs[i], &full, bits_per_node);
+		remove_job_from_cores(jobs[i], &full, bits_per_node);
+	}
+	TEST((bit_set_count(full) == 0) && (bit_set_count(ref) == 0),
+	     "add and remove of all jobs empties row");
+
+	for (i = 0; i < JOB_CNT; i++)
+		free_job_resources(&jobs[i]);
+	FREE_NULL_BITMAP(full);
+	FREE_NULL_BITMAP(ref);
+	xfree(cr_node_cores_offset);
+	totals();
+	return failed;
+}
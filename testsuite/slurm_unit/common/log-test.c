@@ -1,4 +1,6 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -62,6 +64,36 @@ int main(int ac, char **av)
 
 	if (bad_func() < 0)
 		error("bad_func: %m");
+
+	/* test asynchronous log file writes: all queued messages must
+	 * reach the file once the writer is stopped */
+	{
+		char fname[] = "/tmp/log-test.XXXXXX";
+		char line[256];
+		FILE *fp;
+		int fd, lines = 0;
+
+		if ((fd = mkstemp(fname)) < 0)
+			return 1;
+		close(fd);
+		log_opts.stderr_level  = LOG_LEVEL_QUIET;
+		log_opts.logfile_level = LOG_LEVEL_INFO;
+		log_init("log-test", log_opts, 0, fname);
+		log_set_async(1024);
+		for (i = 0; i < 100; i++)
+			info("testing async message %d", i);
+		log_set_async(0);
+		if (!(fp = fopen(fname, "r")))
+			return 1;
+		while (fgets(line, sizeof(line), fp)) {
+			if (strstr(line, "testing async message"))
+				lines++;
+		}
+		fclose(fp);
+		unlink(fname);
+		if (lines != 100)
+			return 1;
+	}
 	return 0;
 }
 	
@@ -3,10 +3,17 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <sys/socket.h>
+
 #include <src/common/pack.h>
+#include <src/common/slurm_protocol_interface.h>
 #include <src/common/xmalloc.h>
+#include <src/slurmdbd/read_config.h>
 
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
 #include <testsuite/dejagnu.h>
+#undef wait
 
 /* Test for failure: 
 */
@@ -26,9 +33,13 @@ int main (int argc, char *argv[])
 	char teststring[] = "TEST STRING",  *outstring = NULL;
 	char *nullstr = NULL;
 	char *data;
-	int data_size;
+	int data_size, msg_size;
 	long double test_double = 1340664754944.2132312, test_double2;
 	uint64_t test64;
+	uint32_t rec_offsets[3], *rec_index;
+	char *head, *seg, *recv_data = NULL;
+	size_t recv_len = 0;
+	int i, fds[2];
 
 	buffer = init_buf (0);
         pack16(test16, buffer);
@@ -83,6 +94,82 @@ int main (int argc, char *argv[])
 	xfree(outstring);
 
 	free_buf(buffer);
+
+	/* Record index after three records */
+	buffer = init_buf(0);
+	rec_offsets[0] = 0;
+	packstr("a", buffer);
+	rec_offsets[1] = get_buf_offset(buffer);
+	packstr("bcd", buffer);
+	rec_offsets[2] = get_buf_offset(buffer);
+	pack32(test32, buffer);
+	data_size = get_buf_offset(buffer);
+	pack_rec_index(rec_offsets, 3, buffer);
+	/* The index is found from the end of the received data */
+	msg_size = get_buf_offset(buffer);
+	buffer = create_buf(xfer_buf_data(buffer), msg_size);
+
+	rec_index = unpack_rec_index(3, buffer);
+	TEST(!rec_index || (rec_index[0] != 0) ||
+	     (rec_index[1] != rec_offsets[1]) ||
+	     (rec_index[2] != rec_offsets[2]) || (rec_index[3] != data_size),
+	     "un/pack_rec_index");
+	TEST(get_buf_offset(buffer) != 0, "unpack_rec_index buffer offset");
+	xfree(rec_index);
+
+	rec_index = unpack_rec_index(2, buffer);
+	TEST(rec_index != NULL, "unpack_rec_index record count mismatch");
+	set_buf_offset(buffer, rec_offsets[1]);
+	rec_index = unpack_rec_index(3, buffer);
+	TEST(rec_index != NULL, "unpack_rec_index not at first record");
+	free_buf(buffer);
+
+	/* Freed buffers are reused, growing ones double in size */
+	buffer = init_buf(0);
+	head = get_buf_data(buffer);
+	free_buf(buffer);
+	buffer = init_buf(BUF_SIZE);
+	TEST(get_buf_data(buffer) != head, "init_buf reuses pooled buffer");
+	for (i = 0; i < 100000; i++)
+		pack64((uint64_t) i, buffer);
+	TEST(size_buf(buffer) != (1024 * 1024), "buffer growth to size class");
+	free_buf(buffer);
+
+	/* Chained segments are sent in place, between the packed data */
+	seg = xmalloc(BUF_SIZE * 4);
+	memset(seg, 'x', BUF_SIZE * 4);
+	buffer = init_buf_chain(0);
+	pack32(test32, buffer);
+	packmem_chain(seg, BUF_SIZE * 4, buffer);
+	packmem_chain("small", 5, buffer);
+	pack32(test32, buffer);
+	TEST(get_buf_length(buffer) != (BUF_SIZE * 4 + 13),
+	     "packmem_chain length");
+
+	/* slurm_get_msg_timeout() is read from slurmdbd_conf */
+	slurmdbd_conf = xmalloc(sizeof(slurm_dbd_conf_t));
+	slurmdbd_conf->msg_timeout = 10;
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+		fail("socketpair");
+	} else {
+		TEST(slurm_msg_sendto_buf(fds[0], buffer, 0) !=
+		     (BUF_SIZE * 4 + 13), "slurm_msg_sendto_buf");
+		TEST(slurm_msg_recvfrom_timeout(fds[1], &recv_data, &recv_len,
+						0, 10000) !=
+		     (BUF_SIZE * 4 + 13), "slurm_msg_sendto_buf receive");
+		TEST(!recv_data || memcmp(recv_data, get_buf_data(buffer), 4) ||
+		     memcmp(recv_data + 4, seg, BUF_SIZE * 4) ||
+		     memcmp(recv_data + 4 + BUF_SIZE * 4,
+			    get_buf_data(buffer) + 4, 9),
+		     "slurm_msg_sendto_buf data");
+		close(fds[0]);
+		close(fds[1]);
+	}
+	xfree(recv_data);
+	xfree(slurmdbd_conf);
+	free_buf(buffer);
+	xfree(seg);
+
 	totals();
 	return failed;
 
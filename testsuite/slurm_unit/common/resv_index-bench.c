@@ -0,0 +1,189 @@
+/* Benchmark of src/slurmctld/resv_index.c
+ *
+ * Build a synthetic set of reservations, then time the lookups of the
+ * reservations overlapping a job's time and nodes with the index against
+ * a scan of the whole resv_list. Not run by "make check", run it by hand:
+ *	./resv_index-bench [reservation_count]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/* Include the slurmctld source, which is not part of a library */
+#include "src/slurmctld/resv_index.c"
+
+#include "src/common/xmalloc.h"
+
+#define NODE_CNT	10000
+#define QUERY_CNT	20000
+#define DAY		(24 * 60 * 60)
+
+typedef struct {
+	time_t start_time;
+	time_t end_time;
+	bitstr_t *node_bitmap;
+} query_t;
+
+static int resv_cnt = 1000;
+
+static long _usec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000 +
+	       (now.tv_usec - start->tv_usec);
+}
+
+static bitstr_t *_node_range(int max_cnt)
+{
+	bitstr_t *node_bitmap = bit_alloc(NODE_CNT);
+	int first = random() % NODE_CNT;
+	int cnt = 1 + random() % max_cnt;
+
+	bit_nset(node_bitmap, first, MIN(first + cnt, NODE_CNT) - 1);
+	return node_bitmap;
+}
+
+static void _free_resv(void *x)
+{
+	slurmctld_resv_t *resv_ptr = (slurmctld_resv_t *) x;
+
+	FREE_NULL_BITMAP(resv_ptr->node_bitmap);
+	xfree(resv_ptr);
+}
+
+static List _build_resvs(time_t now)
+{
+	List resv_list = list_create(_free_resv);
+	slurmctld_resv_t *resv_ptr;
+	int i;
+
+	for (i = 0; i < resv_cnt; i++) {
+		resv_ptr = xmalloc(sizeof(slurmctld_resv_t));
+		resv_ptr->resv_id = i;
+		resv_ptr->start_time = now + (random() % (60 * DAY));
+		resv_ptr->start_time_first = resv_ptr->start_time;
+		resv_ptr->end_time = resv_ptr->start_time + 3600 +
+				     (random() % (2 * DAY));
+		if ((i % 10) == 0)
+			resv_ptr->flags |= RESERVE_FLAG_DAILY;
+		if ((i % 50) == 1) {
+			/* relative times */
+			resv_ptr->flags |= RESERVE_FLAG_TIME_FLOAT;
+			resv_ptr->start_time = 600;
+			resv_ptr->end_time = 7200;
+		}
+		if ((i % 100) != 2)	/* some without nodes */
+			resv_ptr->node_bitmap = _node_range(256);
+		list_append(resv_list, resv_ptr);
+	}
+	return resv_list;
+}
+
+static bool _overlap(slurmctld_resv_t *resv_ptr, query_t *query)
+{
+	if (!resv_ptr->node_bitmap)
+		return false;
+	if (!(resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) &&
+	    ((resv_ptr->start_time_first >= query->end_time) ||
+	     (resv_ptr->end_time <= query->start_time)))
+		return false;
+	if (query->node_bitmap &&
+	    !bit_overlap(resv_ptr->node_bitmap, query->node_bitmap))
+		return false;
+	return true;
+}
+
+/* Count overlapping reservations with a scan of resv_list */
+static int _scan(List resv_list, query_t *query)
+{
+	ListIterator iter = list_iterator_create(resv_list);
+	slurmctld_resv_t *resv_ptr;
+	int cnt = 0;
+
+	while ((resv_ptr = list_next(iter))) {
+		if (_overlap(resv_ptr, query))
+			cnt++;
+	}
+	list_iterator_destroy(iter);
+	return cnt;
+}
+
+/* Count overlapping reservations found with the index */
+static int _find_cnt(resv_index_t *index, query_t *query)
+{
+	slurmctld_resv_t **resv_array;
+	int i, found, cnt = 0;
+
+	found = resv_index_find(index, query->start_time, query->end_time,
+				query->node_bitmap, &resv_array);
+	for (i = 0; i < found; i++) {
+		if (_overlap(resv_array[i], query))
+			cnt++;
+	}
+	return cnt;
+}
+
+int
+main(int argc, char *argv[])
+{
+	time_t now = time(NULL);
+	List resv_list;
+	resv_index_t *index;
+	query_t *queries;
+	struct timeval start;
+	long usec_build, usec_scan, usec_index;
+	int i, scan_cnt = 0, index_cnt = 0;
+
+	if (argc > 1)
+		resv_cnt = atoi(argv[1]);
+	if (resv_cnt < 1) {
+		fprintf(stderr, "reservation_count must be positive\n");
+		return 1;
+	}
+
+	srandom(1);
+	resv_list = _build_resvs(now);
+	queries = xmalloc(sizeof(query_t) * QUERY_CNT);
+	for (i = 0; i < QUERY_CNT; i++) {
+		queries[i].start_time = now + (random() % (60 * DAY));
+		queries[i].end_time = queries[i].start_time + 60 +
+				      (random() % DAY);
+		if (i % 4)	/* some jobs without required nodes */
+			queries[i].node_bitmap = _node_range(1024);
+	}
+
+	gettimeofday(&start, NULL);
+	index = resv_index_build(resv_list);
+	usec_build = _usec_since(&start);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < QUERY_CNT; i++)
+		scan_cnt += _scan(resv_list, &queries[i]);
+	usec_scan = _usec_since(&start);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < QUERY_CNT; i++)
+		index_cnt += _find_cnt(index, &queries[i]);
+	usec_index = _usec_since(&start);
+
+	printf("resv_index_build %d reservations: %ld usec\n", resv_cnt,
+	       usec_build);
+	printf("%d lookups: scan %ld usec, index %ld usec\n", QUERY_CNT,
+	       usec_scan, usec_index);
+
+	resv_index_free(index);
+	for (i = 0; i < QUERY_CNT; i++)
+		FREE_NULL_BITMAP(queries[i].node_bitmap);
+	xfree(queries);
+	FREE_NULL_LIST(resv_list);
+
+	if (scan_cnt != index_cnt) {
+		fprintf(stderr, "scan found %d reservations, index %d\n",
+			scan_cnt, index_cnt);
+		return 1;
+	}
+	return 0;
+}
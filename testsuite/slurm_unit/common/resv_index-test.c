@@ -0,0 +1,163 @@
+/* Test of src/slurmctld/resv_index.c
+ *
+ * Build a synthetic set of reservations and check that the index finds
+ * every reservation overlapping a job's time and nodes, in resv_list order,
+ * that a scan of the whole list finds.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Include the slurmctld source, which is not part of a library */
+#include "src/slurmctld/resv_index.c"
+
+#include "src/common/xmalloc.h"
+
+/* dejagnu.h defines a wait() that conflicts with <sys/wait.h> */
+#define wait _dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+#define NODE_CNT	10000
+#define RESV_CNT	1000
+#define QUERY_CNT	2000
+#define DAY		(24 * 60 * 60)
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+typedef struct {
+	time_t start_time;
+	time_t end_time;
+	bitstr_t *node_bitmap;
+} query_t;
+
+static bitstr_t *_node_range(int max_cnt)
+{
+	bitstr_t *node_bitmap = bit_alloc(NODE_CNT);
+	int first = random() % NODE_CNT;
+	int cnt = 1 + random() % max_cnt;
+
+	bit_nset(node_bitmap, first, MIN(first + cnt, NODE_CNT) - 1);
+	return node_bitmap;
+}
+
+static List _build_resvs(time_t now)
+{
+	List resv_list = list_create(NULL);
+	slurmctld_resv_t *resv_ptr;
+	int i;
+
+	for (i = 0; i < RESV_CNT; i++) {
+		resv_ptr = xmalloc(sizeof(slurmctld_resv_t));
+		resv_ptr->resv_id = i;	/* position in resv_list */
+		resv_ptr->start_time = now + (random() % (60 * DAY));
+		resv_ptr->start_time_first = resv_ptr->start_time;
+		resv_ptr->end_time = resv_ptr->start_time + 3600 +
+				     (random() % (2 * DAY));
+		if ((i % 10) == 0)
+			resv_ptr->flags |= RESERVE_FLAG_DAILY;
+		if ((i % 50) == 1) {
+			/* relative times */
+			resv_ptr->flags |= RESERVE_FLAG_TIME_FLOAT;
+			resv_ptr->start_time = 600;
+			resv_ptr->end_time = 7200;
+		}
+		if ((i % 100) != 2)	/* some without nodes */
+			resv_ptr->node_bitmap = _node_range(256);
+		list_append(resv_list, resv_ptr);
+	}
+	return resv_list;
+}
+
+static bool _overlap(slurmctld_resv_t *resv_ptr, query_t *query)
+{
+	if (!resv_ptr->node_bitmap)
+		return false;
+	if (!(resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) &&
+	    ((resv_ptr->start_time_first >= query->end_time) ||
+	     (resv_ptr->end_time <= query->start_time)))
+		return false;
+	if (query->node_bitmap &&
+	    !bit_overlap(resv_ptr->node_bitmap, query->node_bitmap))
+		return false;
+	return true;
+}
+
+/* Count overlapping reservations with a scan of resv_list */
+static int _scan(List resv_list, query_t *query)
+{
+	ListIterator iter = list_iterator_create(resv_list);
+	slurmctld_resv_t *resv_ptr;
+	int cnt = 0;
+
+	while ((resv_ptr = list_next(iter))) {
+		if (_overlap(resv_ptr, query))
+			cnt++;
+	}
+	list_iterator_destroy(iter);
+	return cnt;
+}
+
+/* Count overlapping reservations found with the index, -1 if out of order */
+static int _find_cnt(resv_index_t *index, query_t *query)
+{
+	slurmctld_resv_t **resv_array;
+	int i, resv_cnt, cnt = 0;
+
+	resv_cnt = resv_index_find(index, query->start_time, query->end_time,
+				   query->node_bitmap, &resv_array);
+	for (i = 0; i < resv_cnt; i++) {
+		if ((i > 0) &&
+		    (resv_array[i]->resv_id <= resv_array[i - 1]->resv_id))
+			return -1;
+		if (_overlap(resv_array[i], query))
+			cnt++;
+	}
+	return cnt;
+}
+
+int
+main(int argc, char *argv[])
+{
+	time_t now = time(NULL);
+	List resv_list;
+	resv_index_t *index;
+	query_t *queries;
+	int i, diff = 0;
+
+	srandom(1);
+	resv_list = _build_resvs(now);
+	queries = xmalloc(sizeof(query_t) * QUERY_CNT);
+	for (i = 0; i < QUERY_CNT; i++) {
+		queries[i].start_time = now + (random() % (60 * DAY));
+		queries[i].end_time = queries[i].start_time + 60 +
+				      (random() % DAY);
+		if (i % 4)	/* some jobs without required nodes */
+			queries[i].node_bitmap = _node_range(1024);
+	}
+
+	index = resv_index_build(resv_list);
+
+	for (i = 0; i < QUERY_CNT; i++) {
+		if (_scan(resv_list, &queries[i]) !=
+		    _find_cnt(index, &queries[i]))
+			diff++;
+	}
+	TEST(diff == 0, "resv_index_find finds all overlapping reservations");
+
+	resv_index_free(index);
+	index = resv_index_build(NULL);
+	TEST(_find_cnt(index, &queries[0]) == 0, "resv_index_find empty index");
+	resv_index_free(index);
+
+	for (i = 0; i < QUERY_CNT; i++)
+		FREE_NULL_BITMAP(queries[i].node_bitmap);
+	xfree(queries);
+	totals();
+	return failed;
+}